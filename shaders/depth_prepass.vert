@@ -0,0 +1,33 @@
+#version 450
+
+layout(location = 0) in vec3 position;
+
+// Has to produce exactly the same depth as simple_shader.vert for the EQUAL depth test
+invariant gl_Position;
+
+struct PointLight
+{
+    vec4 position;
+    vec4 color; // w is intensity
+};
+
+layout(set = 0, binding = 0) uniform GlobalUbo {
+    mat4 projection;
+    mat4 view;
+    mat4 inverseView;
+    vec4 ambientLightColor;
+    PointLight pointLights[10];
+    int numLights;
+} ubo;
+
+layout(push_constant) uniform Push {
+    mat4 modelMatrix; 
+    mat3x4 normalMatrix;
+    uint materialIndex;
+} push;
+
+void main()
+{
+    vec4 positionWorld = push.modelMatrix * vec4(position, 1.0);
+    gl_Position = ubo.projection * ubo.view * positionWorld;
+}
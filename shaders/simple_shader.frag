@@ -1,11 +1,17 @@
 #version 450
+#extension GL_EXT_nonuniform_qualifier : require
 
-layout(location = 0) in vec3 fragColor;
 layout(location = 1) in vec3 fragPosWorld;
 layout(location = 2) in vec3 fragNormalWorld;
+layout(location = 3) in vec2 fragUv;
 
 layout(location = 0) out vec4 outColor;
 
+// Specialized per pipeline variant, see PipelineVariantKey. The light loop is unrolled
+// up to LIGHT_COUNT and the specular term is removed when SPECULAR is false.
+layout(constant_id = 0) const int LIGHT_COUNT = 10;
+layout(constant_id = 1) const bool SPECULAR = true;
+
 struct PointLight
 {
     vec4 position;
@@ -21,13 +27,30 @@ layout(set = 0, binding = 0) uniform GlobalUbo {
     int numLights;
 } ubo;
 
+struct Material
+{
+    vec4 baseColor;
+    uint albedoIndex; // Index into textures, 0 is white
+    float shininess;
+};
+
+layout(set = 1, binding = 1) readonly buffer MaterialBuffer {
+    Material materials[];
+};
+
+layout(set = 2, binding = 0) uniform sampler2D textures[];
+
 layout(push_constant) uniform Push {
     mat4 modelMatrix; 
-    mat4 normalMatrix;
+    mat3x4 normalMatrix;
+    uint materialIndex;
 } push;
 
 void main()
 {
+    Material material = materials[push.materialIndex];
+    vec3 albedo = material.baseColor.rgb * texture(textures[nonuniformEXT(material.albedoIndex)], fragUv).rgb;
+
     vec3 diffuseLight = ubo.ambientLightColor.xyz * ubo.ambientLightColor.w;
     vec3 specularLight = vec3(0.0);
     vec3 surfaceNormal = normalize(fragNormalWorld);
@@ -35,8 +58,11 @@ void main()
     vec3 cameraPosWorld = ubo.inverseView[3].xyz;
     vec3 viewDirection = normalize(cameraPosWorld - fragPosWorld);
 
-    for (int i = 0; i < ubo.numLights; i++)
+    for (int i = 0; i < LIGHT_COUNT; i++)
     {
+        if (i >= ubo.numLights)
+            break;
+
         PointLight pointLight = ubo.pointLights[i];
         vec3 directionToLight = pointLight.position.xyz - fragPosWorld;
         float attenuation = 1.0 / dot(directionToLight, directionToLight); // distance squared
@@ -48,12 +74,15 @@ void main()
         diffuseLight += intensity * cosAngleIncidence ;
 
         // specular light
-        vec3 halfAngle = normalize(directionToLight + viewDirection);
-		float blinnTerm = dot(surfaceNormal, halfAngle);
-		blinnTerm = clamp(blinnTerm, 0, 1);
-		blinnTerm = pow(blinnTerm, 32.0); // higher exponent gives sharper highlight
-		specularLight += intensity * blinnTerm;
+        if (SPECULAR)
+        {
+            vec3 halfAngle = normalize(directionToLight + viewDirection);
+            float blinnTerm = dot(surfaceNormal, halfAngle);
+            blinnTerm = clamp(blinnTerm, 0, 1);
+            blinnTerm = pow(blinnTerm, material.shininess); // higher exponent gives sharper highlight
+            specularLight += intensity * blinnTerm;
+        }
     }
 
-    outColor = vec4(diffuseLight * fragColor + specularLight * fragColor, 1.0);
+    outColor = vec4(diffuseLight * albedo + specularLight * albedo, 1.0);
 }
\ No newline at end of file
@@ -3,11 +3,14 @@
 layout(location = 0) in vec3 position;
 layout(location = 1) in vec3 color;
 layout(location = 2) in vec3 normal;
-layout(location = 3) in vec3 uv;
+layout(location = 3) in vec2 uv;
 
-layout(location = 0) out vec3 fragColor;
 layout(location = 1) out vec3 fragPosWorld;
 layout(location = 2) out vec3 fragNormalWorld;
+layout(location = 3) out vec2 fragUv;
+
+// Has to produce exactly the same depth as depth_prepass.vert for the EQUAL depth test
+invariant gl_Position;
 
 struct PointLight
 {
@@ -26,7 +29,8 @@ layout(set = 0, binding = 0) uniform GlobalUbo {
 
 layout(push_constant) uniform Push {
     mat4 modelMatrix; 
-    mat4 normalMatrix; // color is stuffed in last row
+    mat3x4 normalMatrix;
+    uint materialIndex;
 } push;
 
 void main()
@@ -36,5 +40,5 @@ void main()
 
     fragNormalWorld = normalize(mat3(push.normalMatrix) * normal);
     fragPosWorld = positionWorld.xyz;
-    fragColor = push.normalMatrix[3].rgb; 
+    fragUv = uv;
 }
\ No newline at end of file
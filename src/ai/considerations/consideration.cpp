@@ -51,8 +51,8 @@ namespace VEAI
 		auto entityB = m_blackboard.get<EntityKnowledge>(m_entityKeyB);
 		assert(entityA && entityB && "Entity key does not exist in blackboard");
 
-		auto& positionA = entityA->entity.getComponent<VEComponent::Transform>().location;
-		auto& positionB = entityB->entity.getComponent<VEComponent::Transform>().location;
+		const auto& positionA = entityA->entity.readComponent<VEComponent::Transform>().location;
+		const auto& positionB = entityB->entity.readComponent<VEComponent::Transform>().location;
 		return glm::distance(positionA, positionB) < m_distance;
 	}
 
@@ -20,8 +20,8 @@ public:
 			const float worldSize = 50.0f;
 
 			// Load Models
-			auto planeModel = loadModel("models/plane.obj");
-			auto arrowModel = loadModel("models/arrow.obj");
+			auto planeModel = loadModelAsync("models/plane.obj");
+			auto arrowModel = loadModelAsync("models/arrow.obj");
 
 			// Floor
 			auto plane = createEntity("Plane");
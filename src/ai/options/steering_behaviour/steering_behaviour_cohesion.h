@@ -16,7 +16,7 @@ namespace VEAI
 			if (m_group.entities.empty())
 				return VEPhysics::Force{};
 
-			auto& transform = m_aiComponent->getComponent<VEComponent::Transform>();
+			const auto& transform = m_aiComponent->readComponent<VEComponent::Transform>();
 
 			Vector3 centerOfMass{ 0.0f };
 			int relevantEntities = 0;
@@ -25,7 +25,7 @@ namespace VEAI
 				if (entity == m_aiComponent->entity())
 					continue;
 
-				auto& otherTransform = entity.getComponent<VEComponent::Transform>();
+				const auto& otherTransform = entity.readComponent<VEComponent::Transform>();
 
 				auto direction = transform.location - otherTransform.location;
 				float distance = glm::length(direction);
@@ -20,8 +20,8 @@ namespace VEAI
 			if (!m_target.has_value())
 				return VEPhysics::Force{};
 
-			auto& transform = m_aiComponent->getComponent<VEComponent::Transform>();
-			auto& playerTransform = m_target.value().entity.getComponent<VEComponent::Transform>();
+			const auto& transform = m_aiComponent->readComponent<VEComponent::Transform>();
+			const auto& playerTransform = m_target.value().entity.readComponent<VEComponent::Transform>();
 
 			VEPhysics::Force force{};
 			force.linear = MathLib::normalize(transform.location - playerTransform.location) * m_limits.maxLinearForce;
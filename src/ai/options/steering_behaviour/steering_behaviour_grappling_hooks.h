@@ -13,7 +13,7 @@ namespace VEAI
 
 		virtual VEPhysics::Force computeForce() override
 		{
-			auto& transform = m_aiComponent->getComponent<VEComponent::Transform>();
+			const auto& transform = m_aiComponent->readComponent<VEComponent::Transform>();
 
 			auto targetDistance = glm::length(m_path.path[m_currentIndex] - transform.location);
 			if (targetDistance < m_distanceThreshold)
@@ -12,8 +12,8 @@ namespace VEAI
 
 		virtual VEPhysics::Force computeForce() override
 		{
-			auto& transform = m_aiComponent->getComponent<VEComponent::Transform>();
-			auto& playerTransform = m_target.entity.getComponent<VEComponent::Transform>();
+			const auto& transform = m_aiComponent->readComponent<VEComponent::Transform>();
+			const auto& playerTransform = m_target.entity.readComponent<VEComponent::Transform>();
 
 			VEPhysics::Force force{};
 			force.linear = MathLib::normalize(playerTransform.location - transform.location) * m_limits.maxLinearForce;
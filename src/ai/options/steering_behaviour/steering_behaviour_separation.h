@@ -16,13 +16,13 @@ namespace VEAI
 			if (m_group.entities.empty())
 				return VEPhysics::Force{};
 
-			auto& tranform = m_aiComponent->getComponent<VEComponent::Transform>();
+			const auto& tranform = m_aiComponent->readComponent<VEComponent::Transform>();
 			auto& dynamics = m_aiComponent->getComponent<VEPhysics::MotionDynamics>();
 
 			VEPhysics::Force force{};
 			for (const auto& entity : m_group.entities)
 			{
-				auto& otherTransform = entity.getComponent<VEComponent::Transform>();
+				const auto& otherTransform = entity.readComponent<VEComponent::Transform>();
 
 				auto OtherDirection = otherTransform.location - tranform.location;
 				auto distance = glm::length(OtherDirection);
@@ -19,7 +19,7 @@ namespace VEAI
 			if (m_group.entities.empty())
 				return VEPhysics::Force{};
 
-			auto& thisTransform = m_aiComponent->getComponent<VEComponent::Transform>();
+			const auto& thisTransform = m_aiComponent->readComponent<VEComponent::Transform>();
 
 			Vector3 averageVelocity{ 0.0f };
 			for (const auto& entity : m_group.entities)
@@ -27,7 +27,7 @@ namespace VEAI
 				if (entity == m_aiComponent->entity())
 					continue;
 
-				auto& otherTransform = entity.getComponent<VEComponent::Transform>();
+				const auto& otherTransform = entity.readComponent<VEComponent::Transform>();
 				auto& dynamics = entity.getComponent<VEPhysics::MotionDynamics>();
 
 				auto direction = otherTransform.location - thisTransform.location;
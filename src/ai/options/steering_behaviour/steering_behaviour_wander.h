@@ -13,7 +13,7 @@ namespace VEAI
 
 		virtual VEPhysics::Force computeForce() override
 		{
-			auto& transform = m_aiComponent->getComponent<VEComponent::Transform>();
+			const auto& transform = m_aiComponent->readComponent<VEComponent::Transform>();
 
 			auto centerPoint = MathLib::forward({ 0.0f, m_currentAngle, 0.0f }) * m_distance;
 			m_currentAngle += Random::uniformFloat(-m_jitter, m_jitter);
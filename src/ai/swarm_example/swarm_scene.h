@@ -2,11 +2,14 @@
 
 #include "scene/scene.h"
 #include "scene/components.h"
+#include "scene/prefab.h"
 #include "physics/motion_dynamics.h"
 #include "ai/swarm_example/swarm_ai.h"
 #include "scripting/movement/world_border.h"
 #include "utils/random.h"
 
+#include <functional>
+
 class SwarmScene : public VEScene::Scene
 {
 public:
@@ -18,9 +21,9 @@ public:
 			const float worldSize = 50.0f;
 
 			// Load Models
-			auto planeModel = loadModel("models/plane.obj");
-			auto arrowModel = loadModel("models/arrow.obj");
-			auto teapotModel = loadModel("models/teapot.obj");
+			auto planeModel = loadModelAsync("models/plane.obj");
+			auto arrowModel = loadModelAsync("models/arrow.obj");
+			auto teapotModel = loadModelAsync("models/teapot.obj");
 
 			// Floor
 			auto plane = createEntity("Plane");
@@ -29,32 +32,42 @@ public:
 
 			// Food
 			int foodCount = 10;
-			std::vector<VEScene::Entity> food;
+			std::vector<Vector3> foodLocations;
 			for (int i = 0; i < foodCount; i++)
 			{
 				float x = Random::normalFloatRange(-worldSize / 2.0f, worldSize / 2.0f);
 				float z = Random::normalFloatRange(-worldSize / 2.0f, worldSize / 2.0f);
-				auto foodEntity = createEntity("Food " + std::to_string(i), { x, 0.0f, z });
-				foodEntity.addComponent<VEComponent::Mesh>(teapotModel, Color::green());
-				food.emplace_back(foodEntity);
+				foodLocations.emplace_back(x, 0.0f, z);
 			}
+			VEScene::Prefab foodPrefab{ "Food" };
+			foodPrefab.addComponent<VEComponent::Mesh>(teapotModel, Color::green());
+			auto food = instantiate(foodPrefab, foodLocations);
 
 			auto blackBoardEntity = createEntity("Blackboard");
 			auto& blackboard = blackBoardEntity.addComponent<VEAI::Blackboard>();
 
 			// NPCs at random locations
 			int npcCount = 50;
-			std::vector<VEScene::Entity> npcs;
+			std::vector<Vector3> npcLocations;
 			for (int i = 0; i < npcCount; i++)
 			{
 				float x = Random::uniformFloat(-worldSize / 2.0f, worldSize / 2.0f);
 				float z = Random::uniformFloat(-worldSize / 2.0f, worldSize / 2.0f);
-				auto npc = createEntity("NPC " + std::to_string(i), { x, 0.0f, z });
-				npc.addComponent<VEComponent::Mesh>(arrowModel, Color::red());
-				npc.addComponent<VEPhysics::MotionDynamics>();
-				npc.addComponent<SwarmAIComponent>(blackboard);
-				npc.addComponent<VEScripting::WorldBorder>(Vector3{ worldSize / 2.0f });
-				npcs.emplace_back(npc);
+				npcLocations.emplace_back(x, 0.0f, z);
+			}
+			VEScene::Prefab npcPrefab{ "NPC" };
+			npcPrefab.addComponent<VEComponent::Mesh>(arrowModel, Color::red())
+				.addComponent<VEPhysics::MotionDynamics>()
+				.addComponent<SwarmAIComponent>(std::ref(blackboard))
+				.addComponent<VEScripting::WorldBorder>(Vector3{ worldSize / 2.0f });
+			auto npcs = instantiate(npcPrefab, npcLocations);
+
+			// Far NPCs think and move less often, both scripts use the same policy so forces act over the whole delta
+			auto tickPolicy = VEScripting::ScriptBase::TickPolicy::byDistance(30.0f, 80.0f, 4);
+			for (auto& npc : npcs)
+			{
+				npc.getComponent<SwarmAIComponent>().setTickPolicy(tickPolicy);
+				npc.getComponent<VEPhysics::MotionDynamics>().setTickPolicy(tickPolicy);
 			}
 
 			// Fill blackboard
@@ -45,12 +45,12 @@ namespace VEAI
         if (activeOption->isActive())
         {
             activeOption->pause();
-            std::cout << getComponent<VEComponent::Name>().name << ": Paused option" << std::endl;
+            std::cout << readComponent<VEComponent::Name>().name() << ": Paused option" << std::endl;
         }
         else
         {
             activeOption->start();
-            std::cout << getComponent<VEComponent::Name>().name << ": Started option" << std::endl;
+            std::cout << readComponent<VEComponent::Name>().name() << ": Started option" << std::endl;
         }
     }
 
@@ -58,7 +58,7 @@ namespace VEAI
     {
         m_optionManager.cancelActive();
 
-        std::cout << getComponent<VEComponent::Name>().name << ": Stopping option" << std::endl;
+        std::cout << readComponent<VEComponent::Name>().name() << ": Stopping option" << std::endl;
     }
 
     void TestAIComponent::seekPlayer()
@@ -66,7 +66,7 @@ namespace VEAI
         m_optionManager.cancelActive();
         auto& seekOption = m_optionManager.emplacePrioritized<SteeringBehaviourSeek>(this, EntityKnowledge{ *m_player });
 
-        std::cout << getComponent<VEComponent::Name>().name << ": Seeking player" << std::endl;
+        std::cout << readComponent<VEComponent::Name>().name() << ": Seeking player" << std::endl;
     }
 
     void TestAIComponent::fleeFromPlayer()
@@ -75,7 +75,7 @@ namespace VEAI
         auto& fleeOption = m_optionManager.emplacePrioritized<SteeringBehaviourFlee>(this);
         fleeOption.setTarget(EntityKnowledge{ *m_player });
 
-        std::cout << getComponent<VEComponent::Name>().name << ": Fleeing from player" << std::endl;
+        std::cout << readComponent<VEComponent::Name>().name() << ": Fleeing from player" << std::endl;
     }
 
     void TestAIComponent::arriveAtPlayer()
@@ -84,7 +84,7 @@ namespace VEAI
         auto& arriveOption = m_optionManager.emplacePrioritized<SteeringBehaviourArrive>(this);
         arriveOption.setTarget(EntityKnowledge{ *m_player });
 
-        std::cout << getComponent<VEComponent::Name>().name << ": Arriving at player" << std::endl;
+        std::cout << readComponent<VEComponent::Name>().name() << ": Arriving at player" << std::endl;
     }
 
     void TestAIComponent::flockingWander()
@@ -95,7 +95,7 @@ namespace VEAI
         blendOption.add<SteeringBehaviourWander>(1.0f, this);
 		blendOption.add<SteeringBehaviourFlocking>(1.0f, this, *m_npcs);
 
-        std::cout << getComponent<VEComponent::Name>().name << ": Flocking wander" << std::endl;
+        std::cout << readComponent<VEComponent::Name>().name() << ": Flocking wander" << std::endl;
     }
 
     void TestAIComponent::flockingSeek()
@@ -105,7 +105,7 @@ namespace VEAI
         blendOption.add<SteeringBehaviourSeek>(1.0f, this, *m_player);
         blendOption.add<SteeringBehaviourFlocking>(1.0f, this, *m_npcs);
 
-        std::cout << getComponent<VEComponent::Name>().name << ": Flocking seek" << std::endl;
+        std::cout << readComponent<VEComponent::Name>().name() << ": Flocking seek" << std::endl;
     }
 
     void TestAIComponent::followPath()
@@ -119,7 +119,7 @@ namespace VEAI
         path.path.emplace_back(Vector3{ 10.0f, 0.0f, -10.0f });
         m_optionManager.emplacePrioritized<SteeringBehaviourGrapplingHooks>(this, path);
 
-        std::cout << getComponent<VEComponent::Name>().name << ": Flollow path" << std::endl;
+        std::cout << readComponent<VEComponent::Name>().name() << ": Flollow path" << std::endl;
     }
 
 } // namespace VEAI
@@ -23,16 +23,19 @@ void Input::initialize(GLFWwindow* window)
 
 bool Input::keyPressed(Key key)
 {
-	return glfwGetKey(m_window, key) == GLFW_PRESS;
+	return m_window && glfwGetKey(m_window, key) == GLFW_PRESS;
 }
 
 bool Input::mouseButtonPressed(MouseButton button)
 {
-	return glfwGetMouseButton(m_window, button) == GLFW_PRESS;
+	return m_window && glfwGetMouseButton(m_window, button) == GLFW_PRESS;
 }
 
 Vector2 Input::cursorPosition()
 {
+	if (!m_window)
+		return { 0.0f, 0.0f };
+
 	double xPos, yPos;
 	glfwGetCursorPos(m_window, &xPos, &yPos);
 	return { xPos, yPos };
@@ -40,7 +43,8 @@ Vector2 Input::cursorPosition()
 
 void Input::setInputMode(int mode, int value)
 {
-	glfwSetInputMode(m_window, mode, value);
+	if (m_window)
+		glfwSetInputMode(m_window, mode, value);
 }
 
 void Input::glfwKeyCallback(int key, int scancode, KeyEvent action, Modifier mods)
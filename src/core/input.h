@@ -186,7 +186,7 @@ public:
 
 	/// @brief Acces to the instance of Input
 	/// @return Returns a reference to the instance of Input
-	/// @note Make sure Input was initialized 
+	/// @note Without initialization (headless) no key or button is pressed
 	static Input& instance();
 
 	/// @brief Initializes Input
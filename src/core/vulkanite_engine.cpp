@@ -9,20 +9,20 @@
 #include "scripting/script_base.h"
 #include "utils/math_utils.h"
 
+#include <algorithm>
 #include <array>
+#include <cassert>
 #include <chrono>
 #include <iostream>
 #include <stdexcept>
 
 namespace Vulkanite
 {
-	Engine::Engine()
+	Engine::Engine(const EngineConfig& config) : m_config{ config }
 	{
-		m_globalPool = VEGraphics::DescriptorPool::Builder(m_device)
-			.setMaxSets(VEGraphics::SwapChain::MAX_FRAMES_IN_FLIGHT)
-			.addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VEGraphics::SwapChain::MAX_FRAMES_IN_FLIGHT)
-			.build();
-		
+		if (m_config.shaderHotReload)
+			m_shaderWatcher = std::make_unique<VEGraphics::ShaderWatcher>();
+
 		std::cout << "Engine initialized!\n" << std::endl;
 		std::cout <<
 			" ___      ___ ___  ___  ___       ___  __    ________  ________   ___  _________  _______         \n"
@@ -43,107 +43,320 @@ namespace Vulkanite
 	{
 		// ****
 		// Init
-		std::vector<std::unique_ptr<VEGraphics::Buffer>> uboBuffers(VEGraphics::SwapChain::MAX_FRAMES_IN_FLIGHT);
+		// Without a window the frames are recorded by the dataset capture
+		uint32_t framesInFlight = m_capture ? VEGraphics::DatasetCapture::SLOT_COUNT : m_renderer->framesInFlight();
+		VkRenderPass renderPass = m_capture ? m_capture->renderPass() : m_renderer->swapChainRenderPass();
+		VEGraphics::FrameAllocator& frameAllocator = m_capture ? m_capture->frameAllocator() : m_renderer->frameAllocator();
+
+		// One global ubo and descriptor set per view in every frame
+		uint32_t viewCount = m_capture ? m_capture->tileCount() : MAX_VIEWS;
+		std::vector<std::unique_ptr<VEGraphics::Buffer>> uboBuffers(framesInFlight);
 		for (int i = 0; i < uboBuffers.size(); i++)
 		{
 			uboBuffers[i] = std::make_unique<VEGraphics::Buffer>(
 				m_device,
 				sizeof(VEGraphics::GlobalUbo),
-				1,
+				viewCount,
 				VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
+				m_device.properties.limits.minUniformBufferOffsetAlignment
 			);
 			uboBuffers[i]->map();
 		}
 
-		auto globalSetLayout = VEGraphics::DescriptorSetLayout::Builder(m_device)
-			.addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS)
-			.build();
+		auto& globalSetLayout = m_layoutCache.layout(VEGraphics::DescriptorSetLayout::Builder(m_device)
+			.addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS));
 
-		std::vector<VkDescriptorSet> globalDescriptorSets(VEGraphics::SwapChain::MAX_FRAMES_IN_FLIGHT);
+		std::vector<std::vector<VkDescriptorSet>> globalDescriptorSets(framesInFlight, std::vector<VkDescriptorSet>(viewCount));
 		for (int i = 0; i < globalDescriptorSets.size(); i++)
 		{
-			auto bufferInfo = uboBuffers[i]->descriptorInfo();
-			VEGraphics::DescriptorWriter(*globalSetLayout, *m_globalPool)
-				.writeBuffer(0, &bufferInfo)
-				.build(globalDescriptorSets[i]);
+			for (int view = 0; view < viewCount; view++)
+			{
+				auto bufferInfo = uboBuffers[i]->descriptorInfoForIndex(view);
+				VEGraphics::DescriptorWriter(globalSetLayout, m_descriptorAllocator)
+					.writeBuffer(0, &bufferInfo)
+					.build(globalDescriptorSets[i][view]);
+			}
 		}
 
-		VEGraphics::SimpleRenderSystem simpleRenderSystem{ m_device, m_renderer.swapChainRenderPass(), globalSetLayout->descriptorSetLayout() };
-		VEGraphics::PointLightSystem pointLightSystem{ m_device, m_renderer.swapChainRenderPass(), globalSetLayout->descriptorSetLayout() };
+		VEGraphics::SimpleRenderSystem simpleRenderSystem{
+			m_device,
+			m_pipelineLibrary,
+			renderPass,
+			globalSetLayout.descriptorSetLayout(),
+			frameAllocator.descriptorSetLayout(),
+			m_bindlessTextures };
+		VEGraphics::PointLightSystem pointLightSystem{ m_device, m_pipelineLibrary, renderPass, globalSetLayout.descriptorSetLayout() };
 
 		// Init Input
-		Input::instance().initialize(m_window.glfwWindow());
+		if (m_window)
+		{
+			Input::instance().initialize(m_window->glfwWindow());
+			Input::instance().bind(&simpleRenderSystem, &VEGraphics::SimpleRenderSystem::toggleDepthPrepass, Input::F1);
+			Input::instance().bind(m_renderer.get(), &VEGraphics::Renderer::toggleDynamicResolution, Input::F2);
+		}
 
 		// Init Scene
-		m_scene->initialize();
+		auto sceneInitBeginTime = std::chrono::high_resolution_clock::now();
+		if (m_config.sceneSnapshot.empty() || !m_scene->loadSnapshot(m_config.sceneSnapshot))
+		{
+			m_scene->initialize();
+			if (!m_config.sceneSnapshot.empty())
+				m_scene->saveSnapshot(m_config.sceneSnapshot);
+		}
+		std::cout << "Scene initialized in "
+			<< std::chrono::duration<float, std::chrono::milliseconds::period>(std::chrono::high_resolution_clock::now() - sceneInitBeginTime).count()
+			<< " ms" << std::endl;
 
-		// Init Camera
-		auto& camera = m_scene->camera().getComponent<VEComponent::Camera>().camera;
-		auto& cameraTransform = m_scene->camera().getComponent<VEComponent::Transform>();
+		// Init World Partition
+		if (!m_config.worldPartition.empty())
+		{
+			m_worldPartition = std::make_unique<VEScene::WorldPartition>(*m_scene, m_config.worldPartition);
+			m_worldPartition->build();
+		}
 
 		auto currentTime = std::chrono::high_resolution_clock::now();
+		auto runBeginTime = currentTime;
+
+		// Summed bind counts of the render queue
+		uint64_t drawCalls = 0, pipelineBinds = 0, descriptorBinds = 0, vertexBufferBinds = 0;
+		// Sets of the per-frame descriptor allocators, sampled before they are reset
+		uint64_t frameDescriptorSets = 0;
+		uint32_t maxFrameDescriptorSets = 0;
+		uint64_t renderedFrames = 0;
+		bool viewLimitReported = false;
 
 		// ***********
 		// update loop
-		while (!m_window.shouldClose())
+		while (m_capture ? !m_capture->isFinished() : !m_window->shouldClose())
 		{
 			// Calculate time
 			auto frameBeginTime = std::chrono::high_resolution_clock::now();
 			float frameTimeSec = std::chrono::duration<float, std::chrono::seconds::period>(frameBeginTime - currentTime).count();
 			currentTime = frameBeginTime;
 
-			glfwPollEvents();
+			if (m_window)
+				glfwPollEvents();
+			auto inputTime = std::chrono::steady_clock::now();
+
+			// Assets of entities destroyed from here on may be drawn by every frame submitted so far,
+			// they are released once those frames have finished
+			uint64_t submittedFrames = m_capture ? m_capture->submittedFrames() : m_renderer->submittedFrames();
+			m_scene->assetLoader().releaseRetired(submittedFrames, framesInFlight, m_bindlessTextures);
+
+			// Stream cells around the camera before the scripts see the scene
+			if (m_worldPartition)
+				m_worldPartition->update(m_scene->camera().readComponent<VEComponent::Transform>().location);
 
 			// Update all components
 			m_scene->update(frameTimeSec);
+			if (m_worldPartition)
+				m_worldPartition->suspendDeparted();
+
+			// Upload assets which finished loading
+			m_scene->processAssetUploads();
 
-			float aspect = m_renderer.aspectRatio();
-			camera.setPerspectiveProjection(glm::radians(50.0f), aspect, 0.1f, 100.0f);
-			camera.setViewYXZ(cameraTransform.location, cameraTransform.rotation);
+			// Rebuild pipelines whose shaders were changed and recompiled
+			if (m_shaderWatcher)
+			{
+				for (const auto& spirvPath : m_shaderWatcher->poll())
+				{
+					m_pipelineLibrary.reloadShader(spirvPath);
+				}
+			}
+			m_pipelineLibrary.update();
 
 			// RENDERING
-			if (auto commandBuffer = m_renderer.beginFrame())
+			VkCommandBuffer commandBuffer = m_capture ? m_capture->beginFrame() : m_renderer->beginFrame(inputTime);
+			if (commandBuffer)
 			{
-				int frameIndex = m_renderer.frameIndex();
+				int frameIndex = m_capture ? m_capture->frameIndex() : m_renderer->frameIndex();
 				VEGraphics::FrameInfo frameInfo{
 					frameIndex,
 					frameTimeSec,
 					commandBuffer,
-					&camera,
-					globalDescriptorSets[frameIndex],
-					m_scene.get()
+					nullptr,
+					VK_NULL_HANDLE,
+					m_scene.get(),
+					&frameAllocator,
+					m_capture ? &m_capture->frameDescriptorAllocator() : &m_renderer->frameDescriptorAllocator(),
+					&m_renderQueue
 				};
 
-				// update
+				// Lights and meshes are gathered and uploaded once and shared by all views
 				VEGraphics::GlobalUbo ubo{};
-				ubo.projection = camera.projectionMatrix();
-				ubo.view = camera.viewMatrix();
-				ubo.inverseView = camera.inverseViewMatrix();
-
 				pointLightSystem.update(frameInfo, ubo);
+				simpleRenderSystem.prepare(frameInfo);
+
+				// Fetched every frame, destroying entities moves components in their storage
+				auto cameras = m_scene->cameras();
 
-				uboBuffers[frameIndex]->writeToBuffer(&ubo);
-				uboBuffers[frameIndex]->flush();
+				auto renderView = [&](int viewIndex, VEScene::Entity cameraEntity, float aspect)
+				{
+					auto& cameraComponent = cameraEntity.getComponent<VEComponent::Camera>();
+					const auto& cameraTransform = cameraEntity.readComponent<VEComponent::Transform>();
+					auto& camera = cameraComponent.camera;
+					camera.setPerspectiveProjection(cameraComponent.fieldOfView, aspect, cameraComponent.nearPlane, cameraComponent.farPlane);
+					camera.setViewYXZ(cameraTransform.location, cameraTransform.rotation);
+
+					ubo.projection = camera.projectionMatrix();
+					ubo.view = camera.viewMatrix();
+					ubo.inverseView = camera.inverseViewMatrix();
+					uboBuffers[frameIndex]->writeToIndex(&ubo, viewIndex);
+					uboBuffers[frameIndex]->flushIndex(viewIndex);
+
+					frameInfo.camera = &camera;
+					frameInfo.globalDescriptorSet = globalDescriptorSets[frameIndex][viewIndex];
+
+					m_renderQueue.clear();
+					simpleRenderSystem.submit(frameInfo);
+					pointLightSystem.submit(frameInfo);
+					m_renderQueue.execute(commandBuffer);
+
+					const auto& queueStatistics = m_renderQueue.statistics();
+					drawCalls += queueStatistics.drawCalls;
+					pipelineBinds += queueStatistics.pipelineBinds;
+					descriptorBinds += queueStatistics.descriptorBinds;
+					vertexBufferBinds += queueStatistics.vertexBufferBinds;
+				};
 
-				// render
-				m_renderer.beginSwapChainRenderPass(commandBuffer);
+				if (m_capture)
+				{
+					// Every camera is a pose with its own tile of the atlas
+					m_capture->beginAtlasPass(commandBuffer);
+					for (uint32_t i = 0; i < cameras.size() && i < m_capture->tileCount(); i++)
+					{
+						m_capture->setTile(commandBuffer, i);
+						renderView(i, cameras[i], m_capture->aspectRatio());
+					}
+					m_capture->endAtlasPass(commandBuffer);
+					m_capture->endFrame();
+				}
+				else
+				{
+					// Every view needs its own ubo slot and descriptor set, cameras with the highest order are left out
+					if (cameras.size() > MAX_VIEWS)
+					{
+						if (!viewLimitReported)
+						{
+							std::cout << "Scene has " << cameras.size() << " cameras, only the first " << MAX_VIEWS << " by order are rendered" << std::endl;
+							viewLimitReported = true;
+						}
+						cameras.resize(MAX_VIEWS);
+					}
 
-				// render solid objects first
-				simpleRenderSystem.renderGameObjects(frameInfo);
-				pointLightSystem.render(frameInfo);
+					// Targets of destroyed cameras and of cameras which render to the window again are retired
+					std::erase_if(m_viewTargets, [&](auto& entry)
+						{
+							bool isUsed = std::any_of(cameras.begin(), cameras.end(), [&](VEScene::Entity camera)
+								{
+									return camera.handle() == entry.first && camera.readComponent<VEComponent::Camera>().isOffscreen();
+								});
+							if (!isUsed)
+								m_renderer->retireRenderTarget(std::move(entry.second));
+							return !isUsed;
+						});
 
-				m_renderer.endSwapChainRenderPass(commandBuffer);
-				m_renderer.endFrame();
+					// Offscreen views are rendered first, each into its own target
+					for (int i = 0; i < cameras.size(); i++)
+					{
+						const auto& cameraComponent = cameras[i].readComponent<VEComponent::Camera>();
+						if (!cameraComponent.isOffscreen())
+							continue;
+
+						VkExtent2D extent{ cameraComponent.targetWidth, cameraComponent.targetHeight };
+						auto& target = m_viewTargets[cameras[i].handle()];
+						if (!target || target->extent().width != extent.width || target->extent().height != extent.height)
+						{
+							if (target)
+								m_renderer->retireRenderTarget(std::move(target));
+							target = m_renderer->createRenderTarget(extent);
+						}
+
+						m_renderer->beginTargetPass(commandBuffer, *target);
+						renderView(i, cameras[i], static_cast<float>(extent.width) / static_cast<float>(extent.height));
+						m_renderer->endTargetPass(commandBuffer);
+					}
+
+					// Window views share the scene pass, each is restricted to its region
+					m_renderer->beginScenePass(commandBuffer);
+					for (int i = 0; i < cameras.size(); i++)
+					{
+						const auto& cameraComponent = cameras[i].readComponent<VEComponent::Camera>();
+						if (cameraComponent.isOffscreen())
+							continue;
+
+						const Vector4& region = cameraComponent.viewport;
+						m_renderer->setViewport(commandBuffer, region);
+						renderView(i, cameras[i], m_renderer->aspectRatio() * region.z / region.w);
+					}
+					m_renderer->endScenePass(commandBuffer);
+					m_renderer->endFrame();
+				}
+
+				// The allocator of this frame is reset when its frame index comes around again
+				uint32_t descriptorSets = frameInfo.descriptorAllocator->allocationCount();
+				frameDescriptorSets += descriptorSets;
+				maxFrameDescriptorSets = std::max(maxFrameDescriptorSets, descriptorSets);
+
+				renderedFrames++;
 			}
 
-			applyFrameBrake(frameBeginTime);
+			// All systems have seen the changes of this frame
+			m_scene->clearChanges();
+
+			// The capture runs as fast as the GPU and the writers allow
+			if (!m_capture)
+				applyFrameBrake(frameBeginTime);
 		}
+
+		if (m_capture)
+			m_capture->finish();
 		vkDeviceWaitIdle(m_device.device());
 
+		const auto& allocatorStatistics = frameAllocator.statistics();
+		std::cout << "Frame allocator high-water mark: " << allocatorStatistics.highWaterMark / 1024.0f
+			<< " KiB of " << allocatorStatistics.frameSize / 1024 << " KiB per frame" << std::endl;
+
+		// The engine allocator is never reset, so its count covers the whole run
+		std::cout << "Engine descriptor sets: " << m_descriptorAllocator.allocationCount()
+			<< " in " << m_descriptorAllocator.poolCount() << " pools" << std::endl;
+
+		if (m_renderer)
+		{
+			std::cout << "GPU frame time: " << m_renderer->dynamicResolution().averageFrameTime()
+				<< " ms at render scale " << m_renderer->dynamicResolution().scale() << std::endl;
+
+			const auto& latency = m_renderer->latency();
+			std::cout << "Input to frame finished latency: " << latency.average << " ms average, "
+				<< latency.maximum << " ms max with " << m_renderer->framesInFlight() << " frames in flight" << std::endl;
+		}
+		else
+		{
+			std::cout << "Captured " << renderedFrames << " frames in "
+				<< std::chrono::duration<float, std::chrono::seconds::period>(std::chrono::high_resolution_clock::now() - runBeginTime).count()
+				<< " s" << std::endl;
+		}
+
+		if (renderedFrames > 0)
+		{
+			std::cout << "Average per frame: " << drawCalls / renderedFrames << " draws, "
+				<< pipelineBinds / renderedFrames << " pipeline binds, "
+				<< descriptorBinds / renderedFrames << " descriptor binds, "
+				<< vertexBufferBinds / renderedFrames << " vertex buffer binds" << std::endl;
+			std::cout << "Frame descriptor sets: " << frameDescriptorSets / renderedFrames << " average, "
+				<< maxFrameDescriptorSets << " max per frame" << std::endl;
+		}
+
 		m_scene->runtimeEnd();
 	}
 
+	VEGraphics::RenderTarget* Engine::viewTarget(VEScene::Entity camera)
+	{
+		auto it = m_viewTargets.find(camera.handle());
+		return it != m_viewTargets.end() ? it->second.get() : nullptr;
+	}
+
 	void Engine::applyFrameBrake(std::chrono::steady_clock::time_point frameBeginTime)
 	{
 		// FPS
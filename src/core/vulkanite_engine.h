@@ -1,17 +1,57 @@
 #pragma once
 
+#include "graphics/bindless_textures.h"
+#include "graphics/dataset_capture.h"
 #include "graphics/descriptors.h"
 #include "graphics/device.h"
+#include "graphics/pipeline_library.h"
+#include "graphics/render_queue.h"
+#include "graphics/render_target.h"
 #include "graphics/renderer.h"
+#include "graphics/shader_watcher.h"
 #include "graphics/window.h"
+#include "scene/entity.h"
 #include "scene/scene.h"
+#include "scene/world_partition.h"
 
+#include <filesystem>
 #include <memory>
+#include <optional>
 #include <type_traits>
+#include <unordered_map>
 #include <vector>
 
 namespace Vulkanite
 {
+	/// @brief Settings which are chosen per deployment and fixed for the lifetime of the engine
+	struct EngineConfig
+	{
+		/// @brief Lower values reduce the input latency, higher values keep the GPU busy when frame times vary
+		uint32_t framesInFlight = 2;
+
+		/// @brief FIFO, FIFO_RELAXED, MAILBOX or IMMEDIATE, falls back to FIFO if not supported
+		VkPresentModeKHR presentMode = VK_PRESENT_MODE_MAILBOX_KHR;
+
+		/// @brief Recompiles changed shaders and rebuilds their pipelines while the engine is running
+#ifdef NDEBUG
+		bool shaderHotReload = false;
+#else
+		bool shaderHotReload = true;
+#endif
+
+		/// @brief Binary snapshot the scene is loaded from instead of running its initialize, empty to always initialize
+		/// @note If the file does not exist the scene is initialized and saved to it
+		std::filesystem::path sceneSnapshot;
+
+		/// @brief Directory of the world partition cell chunks, empty to keep the whole scene resident
+		/// @note The chunks are rebuilt from the scene on every start
+		std::filesystem::path worldPartition;
+
+		/// @brief Renders every camera into a tile of an atlas and writes the images to disk instead of opening a window
+		/// @note Runs headless, so software devices like lavapipe can be used. The engine stops after the configured frames.
+		std::optional<VEGraphics::DatasetCaptureSettings> capture;
+	};
+
 	class Engine
 	{
 	public:
@@ -19,8 +59,9 @@ namespace Vulkanite
 		static constexpr int HEIGHT = 720;
 
 		static constexpr int MAX_FPS = 144; // Max frames per second, set 0 to disable
+		static constexpr int MAX_VIEWS = 8; // Max cameras rendered per frame
 
-		Engine();
+		Engine(const EngineConfig& config = {});
 		~Engine();
 
 		Engine(const Engine&) = delete;
@@ -28,6 +69,11 @@ namespace Vulkanite
 
 		void run();
 
+		/// @brief Returns the target an offscreen camera renders into, nullptr if it has not rendered yet
+		/// @note After a frame the color image is in TRANSFER_SRC_OPTIMAL, so it can be copied or blitted. The target is
+		/// shared by the frames in flight and replaced when the camera is resized, destroyed or renders to the window.
+		VEGraphics::RenderTarget* viewTarget(VEScene::Entity camera);
+
 		/// @brief Creates a scene of T 
 		/// @tparam T Subclass of Scene which should be loaded
 		/// @note T has to be a subclass of Scene otherwise compile will fail
@@ -40,12 +86,29 @@ namespace Vulkanite
 	private:
 		void applyFrameBrake(std::chrono::steady_clock::time_point frameBeginTime);
 
-		VEGraphics::Window m_window{ WIDTH, HEIGHT, "Vulkanite" };
-		VEGraphics::VulkanDevice m_device{ m_window };
-		VEGraphics::Renderer m_renderer{ m_window, m_device };
+		EngineConfig m_config;
 
-		std::unique_ptr<VEGraphics::DescriptorPool> m_globalPool{};
+		// Either the window and its renderer or the headless dataset capture is created
+		std::unique_ptr<VEGraphics::Window> m_window{ m_config.capture ? nullptr : std::make_unique<VEGraphics::Window>(WIDTH, HEIGHT, "Vulkanite") };
+		VEGraphics::VulkanDevice m_device{ m_window.get() };
+		std::unique_ptr<VEGraphics::Renderer> m_renderer{ m_window
+			? std::make_unique<VEGraphics::Renderer>(*m_window, m_device, VEGraphics::PresentSettings{ m_config.framesInFlight, m_config.presentMode })
+			: nullptr };
+		std::unique_ptr<VEGraphics::DatasetCapture> m_capture{ m_config.capture
+			? std::make_unique<VEGraphics::DatasetCapture>(m_device, *m_config.capture)
+			: nullptr };
+		VEGraphics::PipelineLibrary m_pipelineLibrary{ m_device };
+		std::unique_ptr<VEGraphics::ShaderWatcher> m_shaderWatcher; // Only created with shader hot-reload
+
+		VEGraphics::DescriptorAllocator m_descriptorAllocator{ m_device }; // Descriptor sets which live as long as the engine
+		VEGraphics::DescriptorLayoutCache m_layoutCache;
+		VEGraphics::BindlessTextures m_bindlessTextures{ m_device };
+		VEGraphics::RenderQueue m_renderQueue;
 		std::unique_ptr<VEScene::Scene> m_scene;
+		std::unique_ptr<VEScene::WorldPartition> m_worldPartition; // Only created with a world partition directory
+
+		// Targets of the offscreen cameras, shared by the frames in flight like the scene render target
+		std::unordered_map<entt::entity, std::unique_ptr<VEGraphics::RenderTarget>> m_viewTargets;
 	};
 
 } // namespace vre
@@ -0,0 +1,189 @@
+#include "asset_loader.h"
+
+#include "graphics/bindless_textures.h"
+#include "graphics/uploader.h"
+
+#include <iostream>
+#include <thread>
+
+namespace VEGraphics
+{
+	namespace
+	{
+		// Called on the main thread after the upload, workers do not print so parallel loads do not interleave
+		void printLoaded(const std::filesystem::path& filepath, const Model::Builder& builder)
+		{
+			builder.printStatistics(filepath);
+		}
+
+		void printLoaded(const std::filesystem::path& filepath, const Texture::Builder& builder)
+		{
+		}
+	}
+
+	AssetLoader::AssetLoader(VulkanDevice& device, uint32_t threadCount)
+		: m_device{ device }, m_threadPool{ threadCount }
+	{
+		createPlaceholderTexture();
+	}
+
+	AssetLoader::~AssetLoader()
+	{
+	}
+
+	std::shared_ptr<Model> AssetLoader::loadModel(const std::filesystem::path& filepath)
+	{
+		auto& cached = m_models[filepath.string()];
+		if (auto model = cached.lock())
+			return model;
+
+		auto model = std::make_shared<Model>(m_device);
+		cached = model;
+
+		loadAsync<Model, Model::Builder>(model, filepath, [filepath](Model::Builder& builder) { builder.loadModel(filepath); });
+		return model;
+	}
+
+	std::shared_ptr<Texture> AssetLoader::loadTexture(const std::filesystem::path& filepath)
+	{
+		auto& cached = m_textures[filepath.string()];
+		if (auto texture = cached.lock())
+			return texture;
+
+		auto texture = std::make_shared<Texture>(m_device);
+		cached = texture;
+
+		loadAsync<Texture, Texture::Builder>(texture, filepath, [filepath](Texture::Builder& builder) { builder.loadTexture(filepath); });
+		return texture;
+	}
+
+	template<typename Asset, typename Builder>
+	void AssetLoader::loadAsync(std::shared_ptr<Asset> asset, const std::filesystem::path& filepath, std::function<void(Builder&)> parse)
+	{
+		m_pendingCount++;
+		m_threadPool.submit([this, asset, filepath, parse]()
+			{
+				auto builder = std::make_shared<Builder>();
+				try
+				{
+					parse(*builder);
+				}
+				catch (const std::exception& e)
+				{
+					// The asset stays a placeholder, the failure is reported on the main thread like the uploads
+					std::lock_guard lock{ m_uploadMutex };
+					m_uploads.push([filepath, message = std::string(e.what())]() { std::cout << "Failed to load " << filepath << ": " << message << std::endl; });
+					return;
+				}
+
+				std::lock_guard lock{ m_uploadMutex };
+				m_uploads.push([asset, builder, filepath]()
+					{
+						asset->upload(*builder);
+						printLoaded(filepath, *builder);
+					});
+			});
+	}
+
+	void AssetLoader::processUploads(uint32_t maxUploads)
+	{
+		for (uint32_t i = 0; i < maxUploads; i++)
+		{
+			std::function<void()> upload;
+			{
+				std::lock_guard lock{ m_uploadMutex };
+				if (m_uploads.empty())
+					return;
+
+				upload = std::move(m_uploads.front());
+				m_uploads.pop();
+			}
+
+			upload();
+			m_pendingCount--;
+		}
+	}
+
+	void AssetLoader::retire(std::shared_ptr<Model> model)
+	{
+		if (model)
+			m_retiredAssets.push_back({ std::move(model), nullptr, m_submittedFrames });
+	}
+
+	void AssetLoader::retire(std::shared_ptr<Texture> texture)
+	{
+		if (texture)
+			m_retiredAssets.push_back({ nullptr, std::move(texture), m_submittedFrames });
+	}
+
+	void AssetLoader::releaseRetired(uint64_t submittedFrames, uint32_t framesInFlight, BindlessTextures& textures)
+	{
+		m_submittedFrames = submittedFrames;
+
+		// The last frame which could draw the assets is the one before the retirement, its fence was waited on
+		// when the frame framesInFlight later began
+		while (!m_retiredAssets.empty() &&
+			m_submittedFrames >= m_retiredAssets.front().submittedFrames + framesInFlight)
+		{
+			// A texture which was loaded again from the cache while it was retired keeps its slot
+			const auto& texture = m_retiredAssets.front().texture;
+			if (texture && texture.use_count() == 1)
+				textures.unregisterTexture(texture.get());
+
+			m_retiredAssets.pop_front();
+		}
+	}
+
+	void AssetLoader::waitIdle()
+	{
+		while (m_pendingCount > 0)
+		{
+			processUploads(UINT32_MAX);
+			std::this_thread::yield();
+		}
+
+		m_device.uploader().flush();
+	}
+
+	Texture& AssetLoader::resolve(const std::shared_ptr<Texture>& texture)
+	{
+		if (texture && texture->isReady())
+			return *texture;
+
+		return *m_placeholderTexture;
+	}
+
+	std::string AssetLoader::modelPath(const Model* model) const
+	{
+		for (const auto& [path, cached] : m_models)
+		{
+			if (cached.lock().get() == model)
+				return path;
+		}
+		return {};
+	}
+
+	std::string AssetLoader::texturePath(const Texture* texture) const
+	{
+		for (const auto& [path, cached] : m_textures)
+		{
+			if (cached.lock().get() == texture)
+				return path;
+		}
+		return {};
+	}
+
+	void AssetLoader::createPlaceholderTexture()
+	{
+		Texture::Builder builder{};
+		builder.format = VK_FORMAT_R8G8B8A8_UNORM;
+		builder.width = 1;
+		builder.height = 1;
+		builder.mipLevels = 1;
+		builder.data = { 255, 255, 255, 255 };
+		builder.levelOffsets = { 0 };
+
+		m_placeholderTexture = std::make_unique<Texture>(m_device, builder);
+	}
+
+} // namespace VEGraphics
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "graphics/device.h"
+#include "graphics/model.h"
+#include "graphics/texture.h"
+#include "utils/thread_pool.h"
+
+#include <atomic>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <unordered_map>
+
+namespace VEGraphics
+{
+	class BindlessTextures;
+
+	/// @brief Loads models and textures asynchronously
+	/// @note Files are read and parsed on worker threads, the GPU upload is submitted on the main thread in processUploads
+	class AssetLoader
+	{
+	public:
+		static constexpr uint32_t MAX_UPLOADS_PER_FRAME = 4;
+
+		/// @param threadCount Number of worker threads, 0 uses the hardware concurrency minus the main thread
+		AssetLoader(VulkanDevice& device, uint32_t threadCount = 0);
+		~AssetLoader();
+
+		AssetLoader(const AssetLoader&) = delete;
+		AssetLoader& operator=(const AssetLoader&) = delete;
+
+		/// @brief Starts loading a model and returns it immediately
+		/// @return Model which is not ready until its upload was processed
+		/// @note Loading the same path again returns the same model as long as it is still in use
+		std::shared_ptr<Model> loadModel(const std::filesystem::path& filepath);
+
+		/// @brief Starts loading a texture and returns it immediately
+		/// @return Texture which is not ready until its upload was processed, use resolve to get a texture that can be sampled
+		/// @note Loading the same path again returns the same texture as long as it is still in use
+		std::shared_ptr<Texture> loadTexture(const std::filesystem::path& filepath);
+
+		/// @brief Submits the uploads of loaded assets to the transfer queue, has to be called on the main thread between frames
+		/// @param maxUploads Maximum number of uploads to limit the time spent per frame
+		void processUploads(uint32_t maxUploads = MAX_UPLOADS_PER_FRAME);
+
+		/// @brief Blocks until all started loads are uploaded and ready
+		void waitIdle();
+
+		/// @brief Returns the texture if it is ready, otherwise a white placeholder texture
+		Texture& resolve(const std::shared_ptr<Texture>& texture);
+
+		/// @brief Returns the path the model was loaded from or an empty string if it was not loaded by this loader
+		std::string modelPath(const Model* model) const;
+
+		/// @brief Returns the path the texture was loaded from or an empty string if it was not loaded by this loader
+		std::string texturePath(const Texture* texture) const;
+
+		/// @brief Keeps an asset which a component released alive until no frame in flight can draw it anymore
+		void retire(std::shared_ptr<Model> model);
+		void retire(std::shared_ptr<Texture> texture);
+
+		/// @brief Releases the retired assets of frames which have finished, called once per frame before the scene is updated
+		/// @param submittedFrames Number of frames submitted so far
+		/// @param framesInFlight Fences of the frames are waited on this many frames after their submission
+		/// @param textures Array from which released textures are unregistered, so their slots are reused
+		void releaseRetired(uint64_t submittedFrames, uint32_t framesInFlight, BindlessTextures& textures);
+
+		/// @brief Returns the number of assets that are loading or waiting for their upload
+		uint32_t pendingCount() const { return m_pendingCount.load(); }
+
+	private:
+		/// @brief Runs the parse function on a worker thread and queues the upload of the result
+		template<typename Asset, typename Builder>
+		void loadAsync(std::shared_ptr<Asset> asset, const std::filesystem::path& filepath, std::function<void(Builder&)> parse);
+
+		void createPlaceholderTexture();
+
+		VulkanDevice& m_device;
+
+		std::unique_ptr<Texture> m_placeholderTexture;
+
+		// Loaded assets by path, expired entries are replaced on the next load
+		std::unordered_map<std::string, std::weak_ptr<Model>> m_models;
+		std::unordered_map<std::string, std::weak_ptr<Texture>> m_textures;
+
+		/// @brief Assets released by components while frames in flight may still reference their buffers and images
+		struct RetiredAssets
+		{
+			std::shared_ptr<Model> model;
+			std::shared_ptr<Texture> texture;
+			uint64_t submittedFrames; // Frames which were submitted before the assets were retired
+		};
+
+		std::deque<RetiredAssets> m_retiredAssets;
+		uint64_t m_submittedFrames = 0;
+
+		std::mutex m_uploadMutex;
+		std::queue<std::function<void()>> m_uploads;
+		std::atomic<uint32_t> m_pendingCount = 0;
+
+		// Declared last so the workers are stopped before the other members are destroyed
+		VEUtils::ThreadPool m_threadPool;
+	};
+
+} // namespace VEGraphics
@@ -0,0 +1,165 @@
+#include "bindless_textures.h"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace VEGraphics
+{
+	BindlessTextures::BindlessTextures(VulkanDevice& device) : m_device{ device }
+	{
+		const auto& limits = m_device.properties12;
+		m_capacity = std::min({
+			MAX_TEXTURES,
+			limits.maxDescriptorSetUpdateAfterBindSampledImages,
+			limits.maxDescriptorSetUpdateAfterBindSamplers,
+			limits.maxPerStageDescriptorUpdateAfterBindSampledImages,
+			limits.maxPerStageDescriptorUpdateAfterBindSamplers });
+
+		createDescriptorSet();
+
+		// White placeholder at index 0 for textures which are still loading
+		Texture::Builder builder{};
+		builder.format = VK_FORMAT_R8G8B8A8_UNORM;
+		builder.width = 1;
+		builder.height = 1;
+		builder.mipLevels = 1;
+		builder.data = { 255, 255, 255, 255 };
+		builder.levelOffsets = { 0 };
+
+		m_placeholder = std::make_shared<Texture>(m_device, builder);
+		m_slots.push_back({ m_placeholder, false });
+		writeSlot(PLACEHOLDER_INDEX, *m_placeholder);
+	}
+
+	BindlessTextures::~BindlessTextures()
+	{
+		m_pool.reset();
+		vkDestroyDescriptorSetLayout(m_device.device(), m_setLayout, nullptr);
+	}
+
+	uint32_t BindlessTextures::textureIndex(const std::shared_ptr<Texture>& texture)
+	{
+		if (!texture)
+			return PLACEHOLDER_INDEX;
+
+		auto it = m_indices.find(texture.get());
+
+		// A destroyed texture which was not unregistered can share its address with this one
+		if (it != m_indices.end() && m_slots[it->second].texture.expired())
+		{
+			freeSlot(it->second);
+			m_indices.erase(it);
+			it = m_indices.end();
+		}
+
+		uint32_t index;
+		if (it != m_indices.end())
+		{
+			index = it->second;
+		}
+		else if (!m_freeSlots.empty())
+		{
+			index = m_freeSlots.back();
+			m_freeSlots.pop_back();
+			m_slots[index] = { texture, false };
+			m_indices[texture.get()] = index;
+		}
+		else
+		{
+			if (m_slots.size() >= m_capacity)
+				throw std::runtime_error("bindless texture array is full");
+
+			index = static_cast<uint32_t>(m_slots.size());
+			m_slots.push_back({ texture, false });
+			m_indices[texture.get()] = index;
+		}
+
+		Slot& slot = m_slots[index];
+		if (!slot.written)
+		{
+			if (!texture->isReady())
+				return PLACEHOLDER_INDEX;
+
+			writeSlot(index, *texture);
+		}
+
+		return index;
+	}
+
+	void BindlessTextures::unregisterTexture(const Texture* texture)
+	{
+		auto it = m_indices.find(texture);
+		if (it == m_indices.end())
+			return;
+
+		freeSlot(it->second);
+		m_indices.erase(it);
+	}
+
+	void BindlessTextures::freeSlot(uint32_t index)
+	{
+		assert(index != PLACEHOLDER_INDEX && "Cannot free the placeholder");
+		m_slots[index] = {};
+		m_freeSlots.push_back(index);
+	}
+
+	void BindlessTextures::createDescriptorSet()
+	{
+		VkDescriptorSetLayoutBinding binding{};
+		binding.binding = 0;
+		binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		binding.descriptorCount = m_capacity;
+		binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+		// Slots are written while the set is bound by frames in flight which do not use them
+		VkDescriptorBindingFlags bindingFlags =
+			VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+			VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT |
+			VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT;
+
+		VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo{};
+		bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+		bindingFlagsInfo.bindingCount = 1;
+		bindingFlagsInfo.pBindingFlags = &bindingFlags;
+
+		VkDescriptorSetLayoutCreateInfo layoutInfo{};
+		layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		layoutInfo.pNext = &bindingFlagsInfo;
+		layoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+		layoutInfo.bindingCount = 1;
+		layoutInfo.pBindings = &binding;
+
+		if (vkCreateDescriptorSetLayout(m_device.device(), &layoutInfo, nullptr, &m_setLayout) != VK_SUCCESS)
+			throw std::runtime_error("failed to create bindless texture descriptor set layout");
+
+		m_pool = DescriptorPool::Builder(m_device)
+			.setMaxSets(1)
+			.setPoolFlags(VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT)
+			.addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, m_capacity)
+			.build();
+
+		if (!m_pool->allocateDescriptorSet(m_setLayout, m_descriptorSet))
+			throw std::runtime_error("failed to allocate bindless texture descriptor set");
+	}
+
+	void BindlessTextures::writeSlot(uint32_t index, const Texture& texture)
+	{
+		assert(texture.isReady() && "Cannot write a texture which is not uploaded");
+
+		VkDescriptorImageInfo imageInfo = texture.descriptorImageInfo();
+
+		VkWriteDescriptorSet write{};
+		write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		write.dstSet = m_descriptorSet;
+		write.dstBinding = 0;
+		write.dstArrayElement = index;
+		write.descriptorCount = 1;
+		write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		write.pImageInfo = &imageInfo;
+
+		vkUpdateDescriptorSets(m_device.device(), 1, &write, 0, nullptr);
+		m_slots[index].written = true;
+	}
+
+} // namespace VEGraphics
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "graphics/descriptors.h"
+#include "graphics/device.h"
+#include "graphics/texture.h"
+
+#include <vulkan/vulkan.h>
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace VEGraphics
+{
+	/// @brief Global array of all textures which is bound once per frame and indexed in the shaders
+	/// @note Uses descriptor indexing (update after bind, partially bound). Index 0 is a white placeholder which is
+	/// returned for textures which are still loading. The array does not own the textures, their owners unregister them
+	/// once no frame in flight uses them anymore (see AssetLoader::releaseRetired), which frees the slot for reuse.
+	class BindlessTextures
+	{
+	public:
+		static constexpr uint32_t MAX_TEXTURES = 4096;
+		static constexpr uint32_t PLACEHOLDER_INDEX = 0;
+
+		BindlessTextures(VulkanDevice& device);
+		~BindlessTextures();
+
+		BindlessTextures(const BindlessTextures&) = delete;
+		BindlessTextures& operator=(const BindlessTextures&) = delete;
+
+		/// @brief Returns the array index of the texture, the texture is registered on the first call
+		/// @note Returns PLACEHOLDER_INDEX while the texture is not ready. The descriptor is written once it is
+		/// ready, which is allowed while the set is bound because of update after bind.
+		uint32_t textureIndex(const std::shared_ptr<Texture>& texture);
+
+		/// @brief Frees the slot of the texture, does nothing if it is not registered
+		/// @note The descriptor is left as it is, the frames which sampled the texture have to be finished
+		void unregisterTexture(const Texture* texture);
+
+		/// @brief Layout with the texture array as binding 0
+		VkDescriptorSetLayout descriptorSetLayout() const { return m_setLayout; }
+		VkDescriptorSet descriptorSet() const { return m_descriptorSet; }
+
+		/// @brief Number of slots which are in use including the placeholder
+		uint32_t textureCount() const { return static_cast<uint32_t>(m_slots.size() - m_freeSlots.size()); }
+		uint32_t capacity() const { return m_capacity; }
+
+	private:
+		struct Slot
+		{
+			std::weak_ptr<Texture> texture; // Expired if the texture was destroyed without being unregistered
+			bool written = false;
+		};
+
+		void createDescriptorSet();
+		void writeSlot(uint32_t index, const Texture& texture);
+		void freeSlot(uint32_t index);
+
+		VulkanDevice& m_device;
+		uint32_t m_capacity;
+
+		VkDescriptorSetLayout m_setLayout = VK_NULL_HANDLE;
+		std::unique_ptr<DescriptorPool> m_pool;
+		VkDescriptorSet m_descriptorSet = VK_NULL_HANDLE;
+
+		std::shared_ptr<Texture> m_placeholder;
+		std::vector<Slot> m_slots;
+		std::vector<uint32_t> m_freeSlots;
+		std::unordered_map<const Texture*, uint32_t> m_indices;
+	};
+
+} // namespace VEGraphics
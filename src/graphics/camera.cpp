@@ -16,6 +16,8 @@ namespace VEGraphics
 		m_projectionMatrix[3][0] = -(right + left) / (right - left);
 		m_projectionMatrix[3][1] = -(bottom + top) / (bottom - top);
 		m_projectionMatrix[3][2] = -near / (far - near);
+		m_nearPlane = near;
+		m_farPlane = far;
 	}
 
 	void Camera::setPerspectiveProjection(float fovy, float aspect, float near, float far)
@@ -29,6 +31,8 @@ namespace VEGraphics
 		m_projectionMatrix[2][2] = far / (far - near);
 		m_projectionMatrix[2][3] = 1.f;
 		m_projectionMatrix[3][2] = -(far * near) / (far - near);
+		m_nearPlane = near;
+		m_farPlane = far;
 	}
 
 	void Camera::setViewDirection(Vector3 position, Vector3 direction, Vector3 up)
@@ -42,10 +42,16 @@ namespace VEGraphics
 		const Matrix4& inverseViewMatrix() const { return m_inverseViewMatrix; }
 		const Vector3 position() const { return Vector3(m_inverseViewMatrix[3]); }
 
+		/// @brief Clipping planes of the last projection
+		float nearPlane() const { return m_nearPlane; }
+		float farPlane() const { return m_farPlane; }
+
 	private:
 		Matrix4 m_projectionMatrix{ 1.0f };
 		Matrix4 m_viewMatrix{ 1.0f };
 		Matrix4 m_inverseViewMatrix{ 1.0f };
+		float m_nearPlane = 0.1f;
+		float m_farPlane = 100.0f;
 	};
 
 } // namespace vre
@@ -0,0 +1,315 @@
+#include "dataset_capture.h"
+
+#include "graphics/uploader.h"
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+namespace VEGraphics
+{
+	namespace
+	{
+		constexpr uint32_t BYTES_PER_PIXEL = 4;
+	}
+
+	DatasetCapture::DatasetCapture(VulkanDevice& device, const DatasetCaptureSettings& settings)
+		: m_device{ device }, m_settings{ settings }, m_writers{ std::max(settings.writerThreads, 1u) }
+	{
+		assert(m_settings.maxPoses > 0 && m_settings.tileWidth > 0 && m_settings.tileHeight > 0 && "Dataset capture needs at least one tile");
+
+		// Square-ish atlas to stay within the image size limits
+		m_columns = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<float>(m_settings.maxPoses))));
+		m_rows = (m_settings.maxPoses + m_columns - 1) / m_columns;
+
+		VkExtent2D extent{ m_columns * m_settings.tileWidth, m_rows * m_settings.tileHeight };
+		if (extent.width > m_device.properties.limits.maxImageDimension2D || extent.height > m_device.properties.limits.maxImageDimension2D)
+			throw std::runtime_error("dataset capture atlas exceeds the maximum image size");
+
+		VkFormat depthFormat = m_device.findSupportedFormat(
+			{ VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT },
+			VK_IMAGE_TILING_OPTIMAL,
+			VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT);
+		m_atlas = std::make_unique<RenderTarget>(m_device, extent, m_colorFormat, depthFormat);
+
+		std::filesystem::create_directories(m_settings.directory);
+		createSlots();
+
+		std::cout << "Dataset capture: " << m_settings.maxPoses << " poses of " << m_settings.tileWidth << "x" << m_settings.tileHeight
+			<< " in a " << extent.width << "x" << extent.height << " atlas to " << m_settings.directory.string() << std::endl;
+	}
+
+	DatasetCapture::~DatasetCapture()
+	{
+		finish();
+
+		for (Slot& slot : m_slots)
+		{
+			vkFreeCommandBuffers(m_device.device(), m_device.commandPool(), 1, &slot.commandBuffer);
+			vkDestroyFence(m_device.device(), slot.fence, nullptr);
+		}
+	}
+
+	VkCommandBuffer DatasetCapture::beginFrame()
+	{
+		assert(!m_frameStarted && "Cannot call beginFrame while already in progress");
+
+		Slot& slot = m_slots[m_slotIndex];
+		vkWaitForFences(m_device.device(), 1, &slot.fence, VK_TRUE, UINT64_MAX);
+
+		// The GPU has finished the previous frame of this slot, its atlas is in the readback buffer
+		if (slot.pending)
+			queueWrites(slot);
+
+		m_frameAllocator.beginFrame(m_slotIndex);
+		slot.descriptorAllocator->reset();
+		slot.poseCount = 0;
+
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+		if (vkBeginCommandBuffer(slot.commandBuffer, &beginInfo) != VK_SUCCESS)
+			throw std::runtime_error("failed to begin recording command buffer");
+
+		// Take ownership of finished uploads before anything is drawn
+		m_uploadTimelineValue = m_device.uploader().recordAcquires(slot.commandBuffer);
+
+		m_frameStarted = true;
+		return slot.commandBuffer;
+	}
+
+	void DatasetCapture::endFrame()
+	{
+		assert(m_frameStarted && "Cannot call endFrame while frame is not in progress");
+
+		Slot& slot = m_slots[m_slotIndex];
+		if (vkEndCommandBuffer(slot.commandBuffer) != VK_SUCCESS)
+			throw std::runtime_error("failed to record command buffer");
+
+		VkSubmitInfo submitInfo{};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+
+		// Uploads acquired in this frame have to be finished on the transfer queue
+		VkSemaphore waitSemaphore = m_device.uploader().timelineSemaphore();
+		VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+		VkTimelineSemaphoreSubmitInfo timelineInfo{};
+		timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+		if (m_uploadTimelineValue > 0)
+		{
+			submitInfo.waitSemaphoreCount = 1;
+			submitInfo.pWaitSemaphores = &waitSemaphore;
+			submitInfo.pWaitDstStageMask = &waitStage;
+			timelineInfo.waitSemaphoreValueCount = 1;
+			timelineInfo.pWaitSemaphoreValues = &m_uploadTimelineValue;
+			submitInfo.pNext = &timelineInfo;
+		}
+
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &slot.commandBuffer;
+
+		vkResetFences(m_device.device(), 1, &slot.fence);
+		if (vkQueueSubmit(m_device.graphicsQueue(), 1, &submitInfo, slot.fence) != VK_SUCCESS)
+			throw std::runtime_error("failed to submit capture command buffer");
+
+		slot.pending = slot.poseCount > 0;
+		slot.frame = m_capturedFrames++;
+
+		m_frameStarted = false;
+		m_slotIndex = (m_slotIndex + 1) % SLOT_COUNT;
+	}
+
+	void DatasetCapture::beginAtlasPass(VkCommandBuffer commandBuffer)
+	{
+		assert(m_frameStarted && "Cannot call beginAtlasPass while frame is not in progress");
+
+		VkRenderPassBeginInfo renderPassInfo{};
+		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+		renderPassInfo.renderPass = m_atlas->renderPass();
+		renderPassInfo.framebuffer = m_atlas->framebuffer();
+		renderPassInfo.renderArea.offset = { 0,0 };
+		renderPassInfo.renderArea.extent = m_atlas->extent();
+
+		std::array<VkClearValue, 2> clearValues{};
+		clearValues[0].color = { 0.01f, 0.01f, 0.01f, 1.0f };
+		clearValues[1].depthStencil = { 1.0f, 0 };
+		renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
+		renderPassInfo.pClearValues = clearValues.data();
+
+		vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+	}
+
+	void DatasetCapture::setTile(VkCommandBuffer commandBuffer, uint32_t tile)
+	{
+		assert(tile < m_settings.maxPoses && "Tile exceeds the poses of the atlas");
+
+		VkViewport viewport{};
+		viewport.x = static_cast<float>((tile % m_columns) * m_settings.tileWidth);
+		viewport.y = static_cast<float>((tile / m_columns) * m_settings.tileHeight);
+		viewport.width = static_cast<float>(m_settings.tileWidth);
+		viewport.height = static_cast<float>(m_settings.tileHeight);
+		viewport.minDepth = 0.0f;
+		viewport.maxDepth = 1.0f;
+
+		VkRect2D scissor{};
+		scissor.offset = { static_cast<int32_t>(viewport.x), static_cast<int32_t>(viewport.y) };
+		scissor.extent = { m_settings.tileWidth, m_settings.tileHeight };
+
+		vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+		vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+		Slot& slot = m_slots[m_slotIndex];
+		slot.poseCount = std::max(slot.poseCount, tile + 1);
+	}
+
+	void DatasetCapture::endAtlasPass(VkCommandBuffer commandBuffer)
+	{
+		vkCmdEndRenderPass(commandBuffer);
+
+		// The render pass leaves the color image in TRANSFER_SRC_OPTIMAL, its outgoing dependency orders the copy after the writes
+		VkBufferImageCopy region{};
+		region.bufferOffset = 0;
+		region.bufferRowLength = 0; // Tightly packed
+		region.bufferImageHeight = 0;
+		region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+		region.imageOffset = { 0, 0, 0 };
+		region.imageExtent = { m_atlas->extent().width, m_atlas->extent().height, 1 };
+
+		Slot& slot = m_slots[m_slotIndex];
+		vkCmdCopyImageToBuffer(
+			commandBuffer,
+			m_atlas->colorImage(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+			slot.readback->buffer(),
+			1, &region);
+
+		// Make the copy visible to the host once the fence of the slot is signaled
+		VkBufferMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.buffer = slot.readback->buffer();
+		barrier.offset = 0;
+		barrier.size = VK_WHOLE_SIZE;
+		vkCmdPipelineBarrier(
+			commandBuffer,
+			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT,
+			0, 0, nullptr, 1, &barrier, 0, nullptr);
+	}
+
+	void DatasetCapture::finish()
+	{
+		assert(!m_frameStarted && "Cannot finish the capture while a frame is in progress");
+
+		// The slot which is used next holds the older frame
+		for (uint32_t i = 0; i < SLOT_COUNT; i++)
+		{
+			Slot& slot = m_slots[(m_slotIndex + i) % SLOT_COUNT];
+			vkWaitForFences(m_device.device(), 1, &slot.fence, VK_TRUE, UINT64_MAX);
+			if (slot.pending)
+				queueWrites(slot);
+		}
+
+		while (!m_pendingWrites.empty())
+		{
+			m_pendingWrites.front().get();
+			m_pendingWrites.pop_front();
+		}
+	}
+
+	void DatasetCapture::createSlots()
+	{
+		VkExtent2D extent = m_atlas->extent();
+		VkDeviceSize atlasSize = static_cast<VkDeviceSize>(extent.width) * extent.height * BYTES_PER_PIXEL;
+
+		for (Slot& slot : m_slots)
+		{
+			VkCommandBufferAllocateInfo allocInfo{};
+			allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+			allocInfo.commandPool = m_device.commandPool();
+			allocInfo.commandBufferCount = 1;
+			if (vkAllocateCommandBuffers(m_device.device(), &allocInfo, &slot.commandBuffer) != VK_SUCCESS)
+				throw std::runtime_error("failed to allocate capture command buffer");
+
+			// Signaled, so the first wait of the slot returns immediately
+			VkFenceCreateInfo fenceInfo{};
+			fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+			fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+			if (vkCreateFence(m_device.device(), &fenceInfo, nullptr, &slot.fence) != VK_SUCCESS)
+				throw std::runtime_error("failed to create capture fence");
+
+			// Cached memory is read much faster by the CPU, it is invalidated before every read
+			slot.readback = std::make_unique<Buffer>(
+				m_device,
+				atlasSize,
+				1,
+				VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT);
+			slot.readback->map();
+
+			slot.descriptorAllocator = std::make_unique<DescriptorAllocator>(m_device);
+		}
+	}
+
+	void DatasetCapture::queueWrites(Slot& slot)
+	{
+		slot.readback->invalidate();
+		slot.pending = false;
+
+		// The writers work on a copy, so the buffer can be reused by the next frame of the slot right away
+		auto atlas = std::make_shared<std::vector<std::byte>>(slot.readback->bufferSize());
+		std::memcpy(atlas->data(), slot.readback->mappedMemory(), atlas->size());
+
+		size_t rowPitch = static_cast<size_t>(m_atlas->extent().width) * BYTES_PER_PIXEL;
+		for (uint32_t pose = 0; pose < slot.poseCount; pose++)
+		{
+			// Backpressure on the CPU, the GPU keeps working on the submitted frames
+			while (m_pendingWrites.size() >= std::max(m_settings.maxPendingImages, 1u))
+			{
+				m_pendingWrites.front().get();
+				m_pendingWrites.pop_front();
+			}
+
+			char name[64];
+			std::snprintf(name, sizeof(name), "frame_%06u_pose_%02u", slot.frame, pose);
+
+			size_t offset = (pose / m_columns) * m_settings.tileHeight * rowPitch + (pose % m_columns) * m_settings.tileWidth * BYTES_PER_PIXEL;
+			m_pendingWrites.push_back(m_writers.submit([atlas, offset, rowPitch, settings = m_settings, name = std::string(name)]()
+				{
+					const std::byte* tile = atlas->data() + offset;
+					if (settings.format == DatasetCaptureSettings::ImageFormat::Png)
+					{
+						std::filesystem::path path = settings.directory / (name + ".png");
+						if (!stbi_write_png(path.string().c_str(), settings.tileWidth, settings.tileHeight, BYTES_PER_PIXEL, tile, static_cast<int>(rowPitch)))
+							std::cout << "Failed to write " << path.string() << std::endl;
+						return;
+					}
+
+					std::filesystem::path path = settings.directory / (name + ".raw");
+					std::ofstream file{ path, std::ios::binary | std::ios::trunc };
+					if (!file.is_open())
+					{
+						std::cout << "Failed to write " << path.string() << std::endl;
+						return;
+					}
+
+					size_t tileRowSize = static_cast<size_t>(settings.tileWidth) * BYTES_PER_PIXEL;
+					for (uint32_t row = 0; row < settings.tileHeight; row++)
+					{
+						file.write(reinterpret_cast<const char*>(tile + row * rowPitch), static_cast<std::streamsize>(tileRowSize));
+					}
+				}));
+		}
+	}
+
+} // namespace VEGraphics
@@ -0,0 +1,128 @@
+#pragma once
+
+#include "graphics/buffer.h"
+#include "graphics/descriptors.h"
+#include "graphics/device.h"
+#include "graphics/frame_allocator.h"
+#include "graphics/render_target.h"
+#include "utils/thread_pool.h"
+
+#include <vulkan/vulkan.h>
+
+#include <array>
+#include <cstddef>
+#include <deque>
+#include <filesystem>
+#include <future>
+#include <memory>
+#include <vector>
+
+namespace VEGraphics
+{
+	struct DatasetCaptureSettings
+	{
+		enum class ImageFormat
+		{
+			Png,
+			Raw, // Tightly packed RGBA8 rows without a header
+		};
+
+		std::filesystem::path directory; // Created if it does not exist
+		uint32_t tileWidth = 256; // Size of the image of one camera pose
+		uint32_t tileHeight = 256;
+		uint32_t maxPoses = 16; // Tiles of the atlas, cameras beyond it are not captured
+		uint32_t frameCount = 100; // Frames captured before the engine stops
+		ImageFormat format = ImageFormat::Png;
+		uint32_t writerThreads = 2;
+		uint32_t maxPendingImages = 64; // Images queued for the writers before the CPU waits for them
+	};
+
+	/// @brief Renders many camera poses per frame into the tiles of an atlas and writes them to disk without a window
+	/// @note The atlas is copied into one of two host-visible buffers at the end of the frame. The buffer is read when its
+	/// slot comes around again, after its fence was waited on, so the GPU keeps rendering the other slot in the meantime.
+	/// The images are encoded and written on writer threads from a copy of the buffer, the GPU never waits for disk I/O.
+	/// If the writers fall behind, the CPU waits for them before it records the next frame.
+	class DatasetCapture
+	{
+	public:
+		static constexpr uint32_t SLOT_COUNT = 2; // Double-buffered readback, also the frames in flight
+
+		DatasetCapture(VulkanDevice& device, const DatasetCaptureSettings& settings);
+		~DatasetCapture();
+
+		DatasetCapture(const DatasetCapture&) = delete;
+		DatasetCapture& operator=(const DatasetCapture&) = delete;
+
+		/// @brief Render pass of the atlas, pipelines of the render systems are created with it
+		VkRenderPass renderPass() const { return m_atlas->renderPass(); }
+
+		FrameAllocator& frameAllocator() { return m_frameAllocator; }
+		DescriptorAllocator& frameDescriptorAllocator() { return *m_slots[m_slotIndex].descriptorAllocator; }
+		int frameIndex() const { return static_cast<int>(m_slotIndex); }
+
+		uint32_t tileCount() const { return m_settings.maxPoses; }
+		float aspectRatio() const { return static_cast<float>(m_settings.tileWidth) / static_cast<float>(m_settings.tileHeight); }
+
+		/// @brief Returns true once the configured number of frames was captured
+		bool isFinished() const { return m_capturedFrames >= m_settings.frameCount; }
+
+		/// @brief Number of frames submitted so far
+		uint64_t submittedFrames() const { return m_capturedFrames; }
+
+		/// @brief Waits for the slot, queues its images for the writers and begins recording
+		VkCommandBuffer beginFrame();
+
+		/// @brief Submits the frame, its atlas is read back when the slot comes around again
+		void endFrame();
+
+		/// @brief Begins the render pass of the atlas, call setTile before the draws of each pose
+		void beginAtlasPass(VkCommandBuffer commandBuffer);
+
+		/// @brief Restricts the following draws to the tile of the pose
+		void setTile(VkCommandBuffer commandBuffer, uint32_t tile);
+
+		/// @brief Ends the render pass and copies the atlas into the readback buffer of the slot
+		void endAtlasPass(VkCommandBuffer commandBuffer);
+
+		/// @brief Waits for the GPU and the writers, so all captured frames are on disk
+		void finish();
+
+	private:
+		struct Slot
+		{
+			VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+			VkFence fence = VK_NULL_HANDLE;
+			std::unique_ptr<Buffer> readback;
+			std::unique_ptr<DescriptorAllocator> descriptorAllocator;
+
+			bool pending = false; // The readback buffer holds a frame which was not queued for the writers yet
+			uint32_t frame = 0;
+			uint32_t poseCount = 0;
+		};
+
+		void createSlots();
+
+		/// @brief Copies the read back atlas of the slot and writes its tiles on the writer threads
+		void queueWrites(Slot& slot);
+
+		VulkanDevice& m_device;
+		DatasetCaptureSettings m_settings;
+		uint32_t m_columns;
+		uint32_t m_rows;
+		VkFormat m_colorFormat = VK_FORMAT_R8G8B8A8_SRGB; // Byte order of PNG, written without conversion
+
+		std::unique_ptr<RenderTarget> m_atlas;
+		FrameAllocator m_frameAllocator{ m_device, SLOT_COUNT };
+		std::array<Slot, SLOT_COUNT> m_slots;
+		uint32_t m_slotIndex = 0;
+		uint32_t m_capturedFrames = 0; // Frames submitted for capture
+		bool m_frameStarted = false;
+		uint64_t m_uploadTimelineValue = 0; // Uploads acquired in the current frame
+
+		std::deque<std::future<void>> m_pendingWrites; // One per image, oldest first
+
+		// Declared last so the writers finish before the rest is destroyed
+		VEUtils::ThreadPool m_writers;
+	};
+
+} // namespace VEGraphics
@@ -1,5 +1,8 @@
 #include "descriptors.h"
 
+#include "utils/utils.h"
+
+#include <algorithm>
 #include <cassert>
 #include <stdexcept>
 
@@ -120,8 +123,7 @@ namespace VEGraphics
         allocInfo.pSetLayouts = &descriptorSetLayout;
         allocInfo.descriptorSetCount = 1;
 
-        // Todo: Might want to create a "DescriptorPoolManager" class that handles this case, and builds
-        // a new pool whenever an old pool fills up, see https://vkguide.dev/docs/extra-chapter/abstracting_descriptors/
+        // Use DescriptorAllocator for a pool that grows when it is full
         if (vkAllocateDescriptorSets(m_device.device(), &allocInfo, &descriptor) != VK_SUCCESS)
             return false;
 
@@ -142,10 +144,177 @@ namespace VEGraphics
         vkResetDescriptorPool(m_device.device(), m_descriptorPool, 0);
     }
 
+    // *************** Descriptor Allocator *********************
+
+    DescriptorAllocator::DescriptorAllocator(
+        VulkanDevice& device,
+        uint32_t setsPerPool,
+        std::vector<PoolSizeRatio> poolSizeRatios)
+        : m_device{ device }, m_poolSizeRatios{ std::move(poolSizeRatios) }, m_setsPerPool{ setsPerPool }
+    {
+    }
+
+    DescriptorAllocator::~DescriptorAllocator()
+    {
+        for (auto pool : m_usedPools)
+        {
+            vkDestroyDescriptorPool(m_device.device(), pool, nullptr);
+        }
+        for (auto pool : m_freePools)
+        {
+            vkDestroyDescriptorPool(m_device.device(), pool, nullptr);
+        }
+    }
+
+    std::vector<DescriptorAllocator::PoolSizeRatio> DescriptorAllocator::defaultPoolSizeRatios()
+    {
+        return {
+            { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2.0f },
+            { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1.0f },
+            { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2.0f },
+            { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 1.0f },
+            { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4.0f },
+            { VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 1.0f },
+            { VK_DESCRIPTOR_TYPE_SAMPLER, 0.5f },
+        };
+    }
+
+    bool DescriptorAllocator::allocateDescriptorSet(const VkDescriptorSetLayout descriptorSetLayout, VkDescriptorSet& descriptor)
+    {
+        if (m_currentPool == VK_NULL_HANDLE)
+        {
+            m_currentPool = grabPool();
+            m_usedPools.push_back(m_currentPool);
+        }
+
+        VkDescriptorSetAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocInfo.descriptorPool = m_currentPool;
+        allocInfo.pSetLayouts = &descriptorSetLayout;
+        allocInfo.descriptorSetCount = 1;
+
+        VkResult result = vkAllocateDescriptorSets(m_device.device(), &allocInfo, &descriptor);
+        if (result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL)
+        {
+            // Continue with the next pool of the chain
+            m_currentPool = grabPool();
+            m_usedPools.push_back(m_currentPool);
+
+            allocInfo.descriptorPool = m_currentPool;
+            result = vkAllocateDescriptorSets(m_device.device(), &allocInfo, &descriptor);
+        }
+
+        if (result != VK_SUCCESS)
+            return false;
+
+        m_allocationCount++;
+        return true;
+    }
+
+    void DescriptorAllocator::reset()
+    {
+        for (auto pool : m_usedPools)
+        {
+            vkResetDescriptorPool(m_device.device(), pool, 0);
+            m_freePools.push_back(pool);
+        }
+        m_usedPools.clear();
+        m_currentPool = VK_NULL_HANDLE;
+        m_allocationCount = 0;
+    }
+
+    VkDescriptorPool DescriptorAllocator::grabPool()
+    {
+        if (!m_freePools.empty())
+        {
+            VkDescriptorPool pool = m_freePools.back();
+            m_freePools.pop_back();
+            return pool;
+        }
+
+        // Every new pool is larger than the previous one to need fewer pools for large scenes
+        VkDescriptorPool pool = createPool(m_setsPerPool);
+        m_setsPerPool = std::min(m_setsPerPool * 2, MAX_SETS_PER_POOL);
+        return pool;
+    }
+
+    VkDescriptorPool DescriptorAllocator::createPool(uint32_t setCount)
+    {
+        std::vector<VkDescriptorPoolSize> poolSizes;
+        for (const auto& poolSizeRatio : m_poolSizeRatios)
+        {
+            uint32_t count = std::max(1u, static_cast<uint32_t>(poolSizeRatio.ratio * setCount));
+            poolSizes.push_back({ poolSizeRatio.type, count });
+        }
+
+        VkDescriptorPoolCreateInfo descriptorPoolInfo{};
+        descriptorPoolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        descriptorPoolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+        descriptorPoolInfo.pPoolSizes = poolSizes.data();
+        descriptorPoolInfo.maxSets = setCount;
+        descriptorPoolInfo.flags = 0;
+
+        VkDescriptorPool pool;
+        if (vkCreateDescriptorPool(m_device.device(), &descriptorPoolInfo, nullptr, &pool) != VK_SUCCESS)
+            throw std::runtime_error("failed to create descriptor pool!");
+
+        return pool;
+    }
+
+    // *************** Descriptor Layout Cache *********************
+
+    DescriptorSetLayout& DescriptorLayoutCache::layout(const DescriptorSetLayout::Builder& builder)
+    {
+        LayoutInfo info{};
+        for (const auto& kv : builder.m_bindings)
+        {
+            info.bindings.push_back(kv.second);
+        }
+        std::sort(info.bindings.begin(), info.bindings.end(),
+            [](const VkDescriptorSetLayoutBinding& a, const VkDescriptorSetLayoutBinding& b) { return a.binding < b.binding; });
+
+        auto& layout = m_layouts[info];
+        if (!layout)
+            layout = builder.build();
+
+        return *layout;
+    }
+
+    bool DescriptorLayoutCache::LayoutInfo::operator==(const LayoutInfo& other) const
+    {
+        if (bindings.size() != other.bindings.size())
+            return false;
+
+        for (size_t i = 0; i < bindings.size(); i++)
+        {
+            const auto& a = bindings[i];
+            const auto& b = other.bindings[i];
+            if (a.binding != b.binding || a.descriptorType != b.descriptorType ||
+                a.descriptorCount != b.descriptorCount || a.stageFlags != b.stageFlags)
+                return false;
+        }
+        return true;
+    }
+
+    size_t DescriptorLayoutCache::LayoutInfoHash::operator()(const LayoutInfo& info) const
+    {
+        size_t seed = 0;
+        for (const auto& binding : info.bindings)
+        {
+            VEUtils::hashCombine(seed, binding.binding, static_cast<uint32_t>(binding.descriptorType), binding.descriptorCount, binding.stageFlags);
+        }
+        return seed;
+    }
+
     // *************** Descriptor Writer *********************
 
     DescriptorWriter::DescriptorWriter(DescriptorSetLayout& setLayout, DescriptorPool& pool)
-        : m_setLayout{ setLayout }, m_pool{ pool }
+        : m_setLayout{ setLayout }, m_pool{ &pool }
+    {
+    }
+
+    DescriptorWriter::DescriptorWriter(DescriptorSetLayout& setLayout, DescriptorAllocator& allocator)
+        : m_setLayout{ setLayout }, m_allocator{ &allocator }
     {
     }
 
@@ -191,7 +360,10 @@ namespace VEGraphics
 
     bool DescriptorWriter::build(VkDescriptorSet& set)
     {
-        if (!m_pool.allocateDescriptorSet(m_setLayout.descriptorSetLayout(), set))
+        bool success = m_pool
+            ? m_pool->allocateDescriptorSet(m_setLayout.descriptorSetLayout(), set)
+            : m_allocator->allocateDescriptorSet(m_setLayout.descriptorSetLayout(), set);
+        if (!success)
             return false;
 
         overwrite(set);
@@ -205,7 +377,7 @@ namespace VEGraphics
             write.dstSet = set;
         }
         vkUpdateDescriptorSets(
-            m_pool.m_device.device(), 
+            m_setLayout.m_device.device(), 
             static_cast<uint32_t>(m_writes.size()), 
             m_writes.data(), 
             0, 
@@ -26,6 +26,8 @@ namespace VEGraphics
         private:
             VulkanDevice& m_device;
             std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> m_bindings{};
+
+            friend class DescriptorLayoutCache;
         };
 
         DescriptorSetLayout(VulkanDevice& lveDevice, std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings);
@@ -85,10 +87,94 @@ namespace VEGraphics
         friend class DescriptorWriter;
     };
 
+    /// @brief Allocates descriptor sets from a chain of pools which grows when a pool runs out of memory
+    /// @note reset() recycles all pools with vkResetDescriptorPool, individual sets can not be freed
+    class DescriptorAllocator
+    {
+    public:
+        /// @brief Number of descriptors of a type per set in a pool
+        struct PoolSizeRatio
+        {
+            VkDescriptorType type;
+            float ratio;
+        };
+
+        static constexpr uint32_t DEFAULT_SETS_PER_POOL = 64;
+        static constexpr uint32_t MAX_SETS_PER_POOL = 4096;
+
+        DescriptorAllocator(
+            VulkanDevice& device,
+            uint32_t setsPerPool = DEFAULT_SETS_PER_POOL,
+            std::vector<PoolSizeRatio> poolSizeRatios = defaultPoolSizeRatios());
+        ~DescriptorAllocator();
+        DescriptorAllocator(const DescriptorAllocator&) = delete;
+        DescriptorAllocator& operator=(const DescriptorAllocator&) = delete;
+
+        /// @brief Allocates a set, a new pool is created if the current pool is full or fragmented
+        bool allocateDescriptorSet(const VkDescriptorSetLayout descriptorSetLayout, VkDescriptorSet& descriptor);
+
+        /// @brief Frees all sets allocated since the last reset, the pools are kept for reuse
+        void reset();
+
+        /// @brief Returns the number of sets allocated since the last reset
+        uint32_t allocationCount() const { return m_allocationCount; }
+
+        /// @brief Returns the number of pools created by the allocator
+        uint32_t poolCount() const { return static_cast<uint32_t>(m_usedPools.size() + m_freePools.size()); }
+
+        static std::vector<PoolSizeRatio> defaultPoolSizeRatios();
+
+    private:
+        VkDescriptorPool grabPool();
+        VkDescriptorPool createPool(uint32_t setCount);
+
+        VulkanDevice& m_device;
+        std::vector<PoolSizeRatio> m_poolSizeRatios;
+        uint32_t m_setsPerPool;
+
+        VkDescriptorPool m_currentPool = VK_NULL_HANDLE;
+        std::vector<VkDescriptorPool> m_usedPools;
+        std::vector<VkDescriptorPool> m_freePools;
+
+        uint32_t m_allocationCount = 0;
+    };
+
+    /// @brief Creates every distinct descriptor set layout only once
+    class DescriptorLayoutCache
+    {
+    public:
+        DescriptorLayoutCache() = default;
+        DescriptorLayoutCache(const DescriptorLayoutCache&) = delete;
+        DescriptorLayoutCache& operator=(const DescriptorLayoutCache&) = delete;
+
+        /// @brief Returns the layout of the bindings of the builder, it is created on the first request
+        /// @note The layout is owned by the cache and lives as long as the cache
+        DescriptorSetLayout& layout(const DescriptorSetLayout::Builder& builder);
+
+        size_t size() const { return m_layouts.size(); }
+
+    private:
+        /// @brief Bindings sorted by binding number
+        struct LayoutInfo
+        {
+            std::vector<VkDescriptorSetLayoutBinding> bindings;
+
+            bool operator==(const LayoutInfo& other) const;
+        };
+
+        struct LayoutInfoHash
+        {
+            size_t operator()(const LayoutInfo& info) const;
+        };
+
+        std::unordered_map<LayoutInfo, std::unique_ptr<DescriptorSetLayout>, LayoutInfoHash> m_layouts;
+    };
+
     class DescriptorWriter
     {
     public:
         DescriptorWriter(DescriptorSetLayout& setLayout, DescriptorPool& pool);
+        DescriptorWriter(DescriptorSetLayout& setLayout, DescriptorAllocator& allocator);
 
         DescriptorWriter& writeBuffer(uint32_t binding, VkDescriptorBufferInfo* bufferInfo);
         DescriptorWriter& writeImage(uint32_t binding, VkDescriptorImageInfo* imageInfo);
@@ -98,7 +184,8 @@ namespace VEGraphics
 
     private:
         DescriptorSetLayout& m_setLayout;
-        DescriptorPool& m_pool;
+        DescriptorPool* m_pool = nullptr;
+        DescriptorAllocator* m_allocator = nullptr;
         std::vector<VkWriteDescriptorSet> m_writes;
     };
 
@@ -1,5 +1,7 @@
 #include "device.h"
 
+#include "graphics/uploader.h"
+
 #include <cstring>
 #include <iostream>
 #include <set>
@@ -52,18 +54,25 @@ namespace VEGraphics
 	}
 
 	// class member functions
-	VulkanDevice::VulkanDevice(Window& window) : m_window{ window }
+	VulkanDevice::VulkanDevice(Window* window) : m_window{ window }
 	{
+		if (isHeadless())
+			deviceExtensions.clear();
+
 		createInstance();
 		setupDebugMessenger();
 		createSurface();
 		pickPhysicalDevice();
 		createLogicalDevice();
 		createCommandPool();
+
+		m_uploader = std::make_unique<Uploader>(*this);
 	}
 
 	VulkanDevice::~VulkanDevice()
 	{
+		m_uploader.reset();
+
 		vkDestroyCommandPool(m_device, m_commandPool, nullptr);
 		vkDestroyDevice(m_device, nullptr);
 
@@ -72,7 +81,8 @@ namespace VEGraphics
 			DestroyDebugUtilsMessengerEXT(m_instance, m_debugMessenger, nullptr);
 		}
 
-		vkDestroySurfaceKHR(m_instance, m_surface, nullptr);
+		if (m_surface != VK_NULL_HANDLE)
+			vkDestroySurfaceKHR(m_instance, m_surface, nullptr);
 		vkDestroyInstance(m_instance, nullptr);
 	}
 
@@ -87,7 +97,7 @@ namespace VEGraphics
 		appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
 		appInfo.pEngineName = "No Engine";
 		appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-		appInfo.apiVersion = VK_API_VERSION_1_0; 
+		appInfo.apiVersion = VK_API_VERSION_1_2; // Timeline semaphores
 
 		VkInstanceCreateInfo createInfo = {};
 		createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
@@ -143,6 +153,12 @@ namespace VEGraphics
 			throw std::runtime_error("failed to find a suitable GPU");
 
 		vkGetPhysicalDeviceProperties(m_physicalDevice, &properties);
+
+		properties12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES;
+		VkPhysicalDeviceProperties2 properties2{};
+		properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+		properties2.pNext = &properties12;
+		vkGetPhysicalDeviceProperties2(m_physicalDevice, &properties2);
 		std::cout << "Physical device: " << properties.deviceName << std::endl;
 	}
 
@@ -151,7 +167,7 @@ namespace VEGraphics
 		QueueFamilyIndices indices = findQueueFamilies(m_physicalDevice);
 
 		std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
-		std::set<uint32_t> uniqueQueueFamilies = { indices.graphicsFamily, indices.presentFamily };
+		std::set<uint32_t> uniqueQueueFamilies = { indices.graphicsFamily, indices.presentFamily, indices.transferFamily };
 
 		float queuePriority = 1.0f;
 		for (uint32_t queueFamily : uniqueQueueFamilies)
@@ -164,11 +180,26 @@ namespace VEGraphics
 			queueCreateInfos.push_back(queueCreateInfo);
 		}
 
+		VkPhysicalDeviceFeatures supportedFeatures;
+		vkGetPhysicalDeviceFeatures(m_physicalDevice, &supportedFeatures);
+
 		VkPhysicalDeviceFeatures deviceFeatures = {};
 		deviceFeatures.samplerAnisotropy = VK_TRUE;
+		deviceFeatures.textureCompressionBC = supportedFeatures.textureCompressionBC; // Optional for BC textures
+
+		VkPhysicalDeviceVulkan12Features vulkan12Features = {};
+		vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+		vulkan12Features.timelineSemaphore = VK_TRUE;
+		// Descriptor indexing for the bindless texture array
+		vulkan12Features.runtimeDescriptorArray = VK_TRUE;
+		vulkan12Features.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+		vulkan12Features.descriptorBindingPartiallyBound = VK_TRUE;
+		vulkan12Features.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+		vulkan12Features.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
 
 		VkDeviceCreateInfo createInfo = {};
 		createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+		createInfo.pNext = &vulkan12Features;
 		createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
 		createInfo.pQueueCreateInfos = queueCreateInfos.data();
 		createInfo.pEnabledFeatures = &deviceFeatures;
@@ -189,8 +220,14 @@ namespace VEGraphics
 		if (vkCreateDevice(m_physicalDevice, &createInfo, nullptr, &m_device) != VK_SUCCESS)
 			throw std::runtime_error("failed to create logical device!");
 
+		features = deviceFeatures;
+
 		vkGetDeviceQueue(m_device, indices.graphicsFamily, 0, &m_graphicsQueue);
 		vkGetDeviceQueue(m_device, indices.presentFamily, 0, &m_presentQueue);
+		vkGetDeviceQueue(m_device, indices.transferFamily, 0, &m_transferQueue);
+
+		if (indices.transferFamily != indices.graphicsFamily)
+			std::cout << "Using dedicated transfer queue family " << indices.transferFamily << std::endl;
 	}
 
 	void VulkanDevice::createCommandPool()
@@ -208,7 +245,8 @@ namespace VEGraphics
 
 	void VulkanDevice::createSurface() 
 	{ 
-		m_window.createWindowSurface(m_instance, &m_surface); 
+		if (!isHeadless())
+			m_window->createWindowSurface(m_instance, &m_surface); 
 	}
 
 	bool VulkanDevice::isDeviceSuitable(VkPhysicalDevice device)
@@ -217,17 +255,34 @@ namespace VEGraphics
 
 		bool extensionsSupported = checkDeviceExtensionSupport(device);
 
-		bool swapChainAdequate = false;
-		if (extensionsSupported)
+		// Headless devices render offscreen only
+		bool swapChainAdequate = isHeadless();
+		if (extensionsSupported && !isHeadless())
 		{
 			SwapChainSupportDetails swapChainSupport = querySwapChainSupport(device);
 			swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
 		}
 
-		VkPhysicalDeviceFeatures supportedFeatures;
-		vkGetPhysicalDeviceFeatures(device, &supportedFeatures);
-
-		return indices.isComplete() && extensionsSupported && swapChainAdequate && supportedFeatures.samplerAnisotropy;
+		VkPhysicalDeviceVulkan12Features vulkan12Features{};
+		vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+
+		VkPhysicalDeviceFeatures2 supportedFeatures{};
+		supportedFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		supportedFeatures.pNext = &vulkan12Features;
+		vkGetPhysicalDeviceFeatures2(device, &supportedFeatures);
+
+		VkPhysicalDeviceProperties deviceProperties;
+		vkGetPhysicalDeviceProperties(device, &deviceProperties);
+
+		return indices.isComplete() && extensionsSupported && swapChainAdequate &&
+			deviceProperties.apiVersion >= VK_API_VERSION_1_2 &&
+			supportedFeatures.features.samplerAnisotropy &&
+			vulkan12Features.timelineSemaphore &&
+			vulkan12Features.runtimeDescriptorArray &&
+			vulkan12Features.shaderSampledImageArrayNonUniformIndexing &&
+			vulkan12Features.descriptorBindingPartiallyBound &&
+			vulkan12Features.descriptorBindingSampledImageUpdateAfterBind &&
+			vulkan12Features.descriptorBindingUpdateUnusedWhilePending;
 	}
 
 	void VulkanDevice::populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT& createInfo)
@@ -286,11 +341,14 @@ namespace VEGraphics
 
 	std::vector<const char*> VulkanDevice::getRequiredExtensions()
 	{
-		uint32_t glfwExtensionCount = 0;
-		const char** glfwExtensions;
-		glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
-
-		std::vector<const char*> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
+		// glfw is not initialized without a window
+		std::vector<const char*> extensions;
+		if (!isHeadless())
+		{
+			uint32_t glfwExtensionCount = 0;
+			const char** glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+			extensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+		}
 
 		if (enableValidationLayers)
 		{
@@ -365,8 +423,12 @@ namespace VEGraphics
 				indices.graphicsFamily = i;
 				indices.graphicsFamilyHasValue = true;
 			}
+			// Without a surface the present family is never used, the graphics family stands in for it
 			VkBool32 presentSupport = false;
-			vkGetPhysicalDeviceSurfaceSupportKHR(device, i, m_surface, &presentSupport);
+			if (isHeadless())
+				presentSupport = (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) ? VK_TRUE : VK_FALSE;
+			else
+				vkGetPhysicalDeviceSurfaceSupportKHR(device, i, m_surface, &presentSupport);
 			if (queueFamily.queueCount > 0 && presentSupport)
 			{
 				indices.presentFamily = i;
@@ -380,6 +442,23 @@ namespace VEGraphics
 			i++;
 		}
 
+		// Prefer a transfer only family (DMA engine), then any family without graphics
+		indices.transferFamily = indices.graphicsFamily;
+		int bestTransferScore = 0;
+		for (uint32_t family = 0; family < queueFamilyCount; family++)
+		{
+			VkQueueFlags flags = queueFamilies[family].queueFlags;
+			if (queueFamilies[family].queueCount == 0 || !(flags & VK_QUEUE_TRANSFER_BIT) || (flags & VK_QUEUE_GRAPHICS_BIT))
+				continue;
+
+			int score = (flags & VK_QUEUE_COMPUTE_BIT) ? 1 : 2;
+			if (score > bestTransferScore)
+			{
+				bestTransferScore = score;
+				indices.transferFamily = family;
+			}
+		}
+
 		return indices;
 	}
 
@@ -432,6 +511,13 @@ namespace VEGraphics
 		throw std::runtime_error("failed to find supported format!");
 	}
 
+	VkFormatProperties VulkanDevice::formatProperties(VkFormat format)
+	{
+		VkFormatProperties props;
+		vkGetPhysicalDeviceFormatProperties(m_physicalDevice, format, &props);
+		return props;
+	}
+
 	uint32_t VulkanDevice::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties)
 	{
 		VkPhysicalDeviceMemoryProperties memProperties;
@@ -590,7 +676,7 @@ namespace VEGraphics
 		barrier.image = image;
 		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
 		barrier.subresourceRange.baseMipLevel = 0;
-		barrier.subresourceRange.levelCount = 1;
+		barrier.subresourceRange.levelCount = mipLevels;
 		barrier.subresourceRange.baseArrayLayer = 0;
 		barrier.subresourceRange.layerCount = 1;
 		barrier.srcAccessMask = 0;
@@ -7,11 +7,14 @@
 
 #include "window.h"
 
+#include <memory>
 #include <string>
 #include <vector>
 
 namespace VEGraphics
 {
+	class Uploader;
+
 	struct SwapChainSupportDetails
 	{
 		VkSurfaceCapabilitiesKHR capabilities;
@@ -24,6 +27,7 @@ namespace VEGraphics
 		// Todo: use std::optional
 		uint32_t graphicsFamily;
 		uint32_t presentFamily;
+		uint32_t transferFamily; // Dedicated transfer family if available, otherwise the graphics family
 		bool graphicsFamilyHasValue = false;
 		bool presentFamilyHasValue = false;
 		bool isComplete() { return graphicsFamilyHasValue && presentFamilyHasValue; }
@@ -38,7 +42,9 @@ namespace VEGraphics
 		const bool enableValidationLayers = true;
 #endif
 
-		VulkanDevice(Window& window);
+		/// @param window Window to present to, nullptr creates a headless device without a surface or swap chain support
+		/// @note Headless devices accept any device type including software implementations like lavapipe
+		VulkanDevice(Window* window);
 		~VulkanDevice();
 
 		// Not copyable or movable
@@ -50,13 +56,19 @@ namespace VEGraphics
 		VkCommandPool commandPool() { return m_commandPool; }
 		VkDevice device() { return m_device; }
 		VkSurfaceKHR surface() { return m_surface; }
+		bool isHeadless() const { return m_window == nullptr; }
 		VkQueue graphicsQueue() { return m_graphicsQueue; }
 		VkQueue presentQueue() { return m_presentQueue; }
+		VkQueue transferQueue() { return m_transferQueue; }
+
+		/// @brief Returns the uploader for asynchronous resource uploads on the transfer queue
+		Uploader& uploader() { return *m_uploader; }
 
 		SwapChainSupportDetails querySwapChainSupport() { return querySwapChainSupport(m_physicalDevice); }
 		uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
 		QueueFamilyIndices findPhysicalQueueFamilies() { return findQueueFamilies(m_physicalDevice); }
 		VkFormat findSupportedFormat(const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
+		VkFormatProperties formatProperties(VkFormat format);
 
 		// Buffer Helper Functions
 		void createBuffer(
@@ -75,6 +87,8 @@ namespace VEGraphics
 		void transitionImageLayout(VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout, uint32_t mipLevels);
 
 		VkPhysicalDeviceProperties properties;
+		VkPhysicalDeviceVulkan12Properties properties12{}; // Descriptor indexing limits
+		VkPhysicalDeviceFeatures features{}; // Enabled features of the logical device
 
 	private:
 		void createInstance();
@@ -97,16 +111,19 @@ namespace VEGraphics
 		VkInstance m_instance;
 		VkDebugUtilsMessengerEXT m_debugMessenger;
 		VkPhysicalDevice m_physicalDevice = VK_NULL_HANDLE;
-		Window& m_window;
+		Window* m_window;
 		VkCommandPool m_commandPool;
 
 		VkDevice m_device;
-		VkSurfaceKHR m_surface;
+		VkSurfaceKHR m_surface = VK_NULL_HANDLE;
 		VkQueue m_graphicsQueue;
 		VkQueue m_presentQueue;
+		VkQueue m_transferQueue;
+
+		std::unique_ptr<Uploader> m_uploader;
 
 		const std::vector<const char*> validationLayers = { "VK_LAYER_KHRONOS_validation" };
-		const std::vector<const char*> deviceExtensions = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
+		std::vector<const char*> deviceExtensions = { VK_KHR_SWAPCHAIN_EXTENSION_NAME }; // Empty for headless devices
 	};
 
 } // namespace vre
\ No newline at end of file
@@ -0,0 +1,53 @@
+#include "dynamic_resolution.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace VEGraphics
+{
+	DynamicResolution::DynamicResolution(const Settings& settings)
+	{
+		setSettings(settings);
+	}
+
+	void DynamicResolution::setSettings(const Settings& settings)
+	{
+		assert(settings.minScale > 0.0f && settings.minScale <= settings.maxScale && "Invalid dynamic resolution bounds");
+		m_settings = settings;
+		m_settings.maxScale = std::min(m_settings.maxScale, 1.0f);
+		m_settings.minScale = std::min(m_settings.minScale, m_settings.maxScale);
+		m_scale = std::clamp(m_scale, m_settings.minScale, m_settings.maxScale);
+	}
+
+	void DynamicResolution::update(float gpuFrameTime)
+	{
+		if (gpuFrameTime <= 0.0f)
+			return;
+
+		m_averageFrameTime = m_averageFrameTime > 0.0f
+			? m_averageFrameTime + (gpuFrameTime - m_averageFrameTime) * m_settings.smoothing
+			: gpuFrameTime;
+
+		if (!m_settings.enabled)
+			return;
+
+		float ratio = m_settings.targetFrameTime / m_averageFrameTime;
+		if (std::abs(ratio - 1.0f) < m_settings.tolerance)
+			return;
+
+		// GPU time is roughly proportional to the pixel count
+		float desiredScale = m_scale * std::sqrt(ratio);
+		float step = std::clamp(desiredScale - m_scale, -m_settings.maxStep, m_settings.maxStep);
+		m_scale = std::clamp(m_scale + step, m_settings.minScale, m_settings.maxScale);
+	}
+
+	VkExtent2D DynamicResolution::renderExtent(VkExtent2D outputExtent) const
+	{
+		float currentScale = scale();
+		return {
+			std::max(1u, static_cast<uint32_t>(outputExtent.width * currentScale + 0.5f)),
+			std::max(1u, static_cast<uint32_t>(outputExtent.height * currentScale + 0.5f)) };
+	}
+
+} // namespace VEGraphics
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+namespace VEGraphics
+{
+	/// @brief Controls the internal render resolution to hold a target GPU frame time
+	/// @note The scale applies to both axes, so the pixel count and roughly the GPU time change with its square
+	class DynamicResolution
+	{
+	public:
+		struct Settings
+		{
+			bool enabled = true;
+			float targetFrameTime = 1000.0f / 60.0f; // Milliseconds of GPU time per frame
+			float minScale = 0.5f;
+			float maxScale = 1.0f;  // Values above 1 are clamped, the render target has the size of the swap chain
+			float smoothing = 0.1f; // Weight of a new measurement in the moving average
+			float tolerance = 0.05f; // Relative deviation from the target which does not change the scale
+			float maxStep = 0.05f;  // Maximum scale change per frame
+		};
+
+		DynamicResolution(const Settings& settings = Settings{});
+
+		/// @brief Feeds the GPU time of a finished frame to the controller
+		void update(float gpuFrameTime);
+
+		/// @brief Returns the render extent for the output extent at the current scale
+		VkExtent2D renderExtent(VkExtent2D outputExtent) const;
+
+		float scale() const { return m_settings.enabled ? m_scale : 1.0f; }
+		float averageFrameTime() const { return m_averageFrameTime; }
+
+		const Settings& settings() const { return m_settings; }
+		void setSettings(const Settings& settings);
+		void setEnabled(bool enabled) { m_settings.enabled = enabled; }
+		bool isEnabled() const { return m_settings.enabled; }
+
+	private:
+		Settings m_settings;
+		float m_scale = 1.0f;
+		float m_averageFrameTime = 0.0f;
+	};
+
+} // namespace VEGraphics
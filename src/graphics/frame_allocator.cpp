@@ -0,0 +1,125 @@
+#include "frame_allocator.h"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+#include <string>
+
+namespace VEGraphics
+{
+	FrameAllocator::FrameAllocator(VulkanDevice& device, uint32_t frameCount, VkDeviceSize frameSize)
+		: m_device{ device }, m_frameCount{ frameCount }, m_frameSize{ frameSize }
+	{
+		const auto& limits = m_device.properties.limits;
+		m_uniformRange = std::min<VkDeviceSize>({ limits.maxUniformBufferRange, 64 * 1024, m_frameSize });
+		m_storageRange = std::min<VkDeviceSize>({ limits.maxStorageBufferRange, MAX_STORAGE_RANGE, m_frameSize });
+
+		// The descriptors cover a fixed range behind every dynamic offset, so the last frame region is padded by that range
+		VkDeviceSize bufferSize = m_frameSize * m_frameCount + std::max(m_uniformRange, m_storageRange);
+
+		m_buffer = std::make_unique<Buffer>(
+			m_device,
+			bufferSize,
+			1,
+			VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+		);
+		m_buffer->map();
+
+		m_statistics.frameSize = m_frameSize;
+
+		createDescriptorSet();
+	}
+
+	FrameAllocator::~FrameAllocator()
+	{
+	}
+
+	void FrameAllocator::beginFrame(uint32_t frameIndex)
+	{
+		assert(frameIndex < m_frameCount && "Frame index exceeds the frames of the allocator");
+
+		m_frameBegin = frameIndex * m_frameSize;
+		m_frameOffset = 0;
+		m_statistics.usedBytes = 0;
+		m_statistics.allocationCount = 0;
+	}
+
+	FrameAllocator::Allocation FrameAllocator::allocateUniform(VkDeviceSize size)
+	{
+		assert(size <= m_uniformRange && "Uniform allocation exceeds the uniform range of the descriptor");
+		return allocate(size, m_device.properties.limits.minUniformBufferOffsetAlignment);
+	}
+
+	FrameAllocator::Allocation FrameAllocator::allocateStorage(VkDeviceSize size)
+	{
+		// Checked in release too, shaders would index past the bound range
+		if (size > m_storageRange)
+			throw std::runtime_error("Storage allocation of " + std::to_string(size) + " bytes exceeds the storage range of the descriptor");
+		return allocate(size, m_device.properties.limits.minStorageBufferOffsetAlignment);
+	}
+
+	FrameAllocator::Allocation FrameAllocator::allocate(VkDeviceSize size, VkDeviceSize alignment)
+	{
+		VkDeviceSize offset = m_frameBegin + m_frameOffset;
+		if (alignment > 0)
+			offset = (offset + alignment - 1) & ~(alignment - 1);
+
+		VkDeviceSize end = offset + size - m_frameBegin;
+		if (end > m_frameSize)
+			throw std::runtime_error("Frame allocator is out of memory (" + std::to_string(end) + " of " + std::to_string(m_frameSize) + " bytes)");
+
+		m_frameOffset = end;
+		m_statistics.usedBytes = end;
+		m_statistics.highWaterMark = std::max(m_statistics.highWaterMark, end);
+		m_statistics.allocationCount++;
+
+		Allocation allocation{};
+		allocation.data = static_cast<char*>(m_buffer->mappedMemory()) + offset;
+		allocation.offset = static_cast<uint32_t>(offset);
+		allocation.size = size;
+		return allocation;
+	}
+
+	void FrameAllocator::bind(
+		VkCommandBuffer commandBuffer,
+		VkPipelineLayout pipelineLayout,
+		uint32_t setIndex,
+		const Allocation& uniform,
+		const Allocation& storage) const
+	{
+		// Dynamic offsets are ordered by binding
+		uint32_t dynamicOffsets[] = { uniform.offset, storage.offset };
+		vkCmdBindDescriptorSets(
+			commandBuffer,
+			VK_PIPELINE_BIND_POINT_GRAPHICS,
+			pipelineLayout,
+			setIndex, 1,
+			&m_descriptorSet,
+			2, dynamicOffsets
+		);
+	}
+
+	void FrameAllocator::createDescriptorSet()
+	{
+		m_setLayout = DescriptorSetLayout::Builder(m_device)
+			.addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_ALL_GRAPHICS)
+			.addBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, VK_SHADER_STAGE_ALL_GRAPHICS)
+			.build();
+
+		m_pool = DescriptorPool::Builder(m_device)
+			.setMaxSets(1)
+			.addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1)
+			.addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 1)
+			.build();
+
+		auto uniformInfo = m_buffer->descriptorInfo(m_uniformRange, 0);
+		auto storageInfo = m_buffer->descriptorInfo(m_storageRange, 0);
+		if (!DescriptorWriter(*m_setLayout, *m_pool)
+			.writeBuffer(0, &uniformInfo)
+			.writeBuffer(1, &storageInfo)
+			.build(m_descriptorSet))
+			throw std::runtime_error("failed to allocate frame allocator descriptor set");
+	}
+
+} // namespace VEGraphics
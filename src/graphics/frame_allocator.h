@@ -0,0 +1,119 @@
+#pragma once
+
+#include "graphics/buffer.h"
+#include "graphics/descriptors.h"
+#include "graphics/device.h"
+
+#include <vulkan/vulkan.h>
+
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace VEGraphics
+{
+	/// @brief Persistently mapped ring buffer for data which is written every frame (uniform and storage data)
+	/// @note The buffer is split into one region per frame in flight. Allocations are linear within the region of the current frame
+	/// and the region is reset in beginFrame, after the fence of the frame which used it last has been waited on.
+	/// Allocations are bound with dynamic offsets on the descriptor set of the allocator.
+	class FrameAllocator
+	{
+	public:
+		static constexpr VkDeviceSize DEFAULT_FRAME_SIZE = 4 * 1024 * 1024;
+		static constexpr VkDeviceSize MAX_STORAGE_RANGE = 1024 * 1024; // Maximum size of one storage allocation
+
+		/// @brief Sub-allocation of the current frame region
+		struct Allocation
+		{
+			void* data = nullptr;    // Mapped memory of the allocation
+			uint32_t offset = 0;     // Dynamic offset to bind the allocation
+			VkDeviceSize size = 0;
+		};
+
+		struct Statistics
+		{
+			VkDeviceSize frameSize = 0;      // Available bytes per frame
+			VkDeviceSize usedBytes = 0;      // Bytes allocated in the current frame including alignment padding
+			VkDeviceSize highWaterMark = 0;  // Maximum of used bytes over all frames
+			uint32_t allocationCount = 0;    // Allocations in the current frame
+		};
+
+		/// @param frameCount Number of frames in flight
+		/// @param frameSize Size of the region per frame in bytes
+		FrameAllocator(VulkanDevice& device, uint32_t frameCount, VkDeviceSize frameSize = DEFAULT_FRAME_SIZE);
+		~FrameAllocator();
+
+		FrameAllocator(const FrameAllocator&) = delete;
+		FrameAllocator& operator=(const FrameAllocator&) = delete;
+
+		/// @brief Resets the region of the frame, the frame must not be used by the GPU anymore
+		void beginFrame(uint32_t frameIndex);
+
+		/// @brief Allocates memory for uniform data aligned to minUniformBufferOffsetAlignment
+		/// @note The size must not exceed uniformRange()
+		Allocation allocateUniform(VkDeviceSize size);
+
+		/// @brief Allocates memory for storage data aligned to minStorageBufferOffsetAlignment
+		/// @note The size must not exceed storageRange()
+		Allocation allocateStorage(VkDeviceSize size);
+
+		/// @brief Allocates and writes uniform data
+		template<typename T>
+		Allocation pushUniform(const T& data)
+		{
+			Allocation allocation = allocateUniform(sizeof(T));
+			std::memcpy(allocation.data, &data, sizeof(T));
+			return allocation;
+		}
+
+		/// @brief Allocates and writes an array of storage data
+		template<typename T>
+		Allocation pushStorage(const std::vector<T>& data)
+		{
+			Allocation allocation = allocateStorage(sizeof(T) * data.size());
+			std::memcpy(allocation.data, data.data(), sizeof(T) * data.size());
+			return allocation;
+		}
+
+		/// @brief Binds the descriptor set with the dynamic offsets of the given allocations
+		/// @param uniform Allocation for binding 0 (uniform buffer)
+		/// @param storage Allocation for binding 1 (storage buffer)
+		void bind(
+			VkCommandBuffer commandBuffer,
+			VkPipelineLayout pipelineLayout,
+			uint32_t setIndex,
+			const Allocation& uniform,
+			const Allocation& storage = {}) const;
+
+		/// @brief Layout with a dynamic uniform buffer (binding 0) and a dynamic storage buffer (binding 1)
+		VkDescriptorSetLayout descriptorSetLayout() const { return m_setLayout->descriptorSetLayout(); }
+		VkDescriptorSet descriptorSet() const { return m_descriptorSet; }
+
+		VkDeviceSize uniformRange() const { return m_uniformRange; }
+		VkDeviceSize storageRange() const { return m_storageRange; }
+
+		const Statistics& statistics() const { return m_statistics; }
+
+	private:
+		Allocation allocate(VkDeviceSize size, VkDeviceSize alignment);
+		void createDescriptorSet();
+
+		VulkanDevice& m_device;
+
+		uint32_t m_frameCount;
+		VkDeviceSize m_frameSize;
+		VkDeviceSize m_uniformRange;
+		VkDeviceSize m_storageRange;
+
+		std::unique_ptr<Buffer> m_buffer;
+		VkDeviceSize m_frameBegin = 0;  // Offset of the current frame region
+		VkDeviceSize m_frameOffset = 0; // Offset of the next allocation within the current frame region
+
+		std::unique_ptr<DescriptorSetLayout> m_setLayout;
+		std::unique_ptr<DescriptorPool> m_pool;
+		VkDescriptorSet m_descriptorSet = VK_NULL_HANDLE;
+
+		Statistics m_statistics{};
+	};
+
+} // namespace VEGraphics
@@ -1,6 +1,9 @@
 #pragma once
 
 #include "camera.h"
+#include "graphics/descriptors.h"
+#include "graphics/frame_allocator.h"
+#include "graphics/render_queue.h"
 #include "scene/scene.h"
 
 #include <vulkan/vulkan.h>
@@ -33,6 +36,9 @@ namespace VEGraphics
 		Camera* camera;
 		VkDescriptorSet globalDescriptorSet;
 		VEScene::Scene* scene;
+		FrameAllocator* frameAllocator; // Per-frame uniform and storage data
+		DescriptorAllocator* descriptorAllocator; // Per-frame descriptor sets, released when the frame index comes around again
+		RenderQueue* renderQueue; // Draws of the frame, recorded sorted after all systems submitted
 	};
 
 } // namespace VEGraphics
\ No newline at end of file
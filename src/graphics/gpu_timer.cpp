@@ -0,0 +1,69 @@
+#include "gpu_timer.h"
+
+#include <stdexcept>
+
+namespace VEGraphics
+{
+	GpuTimer::GpuTimer(VulkanDevice& device, uint32_t frameCount) : m_device{ device }, m_written(frameCount, false)
+	{
+		m_supported = m_device.properties.limits.timestampComputeAndGraphics == VK_TRUE;
+		if (!m_supported)
+			return;
+
+		VkQueryPoolCreateInfo queryPoolInfo{};
+		queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+		queryPoolInfo.queryCount = 2 * frameCount;
+
+		if (vkCreateQueryPool(m_device.device(), &queryPoolInfo, nullptr, &m_queryPool) != VK_SUCCESS)
+			throw std::runtime_error("failed to create timestamp query pool");
+	}
+
+	GpuTimer::~GpuTimer()
+	{
+		vkDestroyQueryPool(m_device.device(), m_queryPool, nullptr);
+	}
+
+	bool GpuTimer::beginFrame(VkCommandBuffer commandBuffer, uint32_t frameIndex)
+	{
+		if (!m_supported)
+			return false;
+
+		bool newResult = false;
+		uint32_t firstQuery = 2 * frameIndex;
+		if (m_written[frameIndex])
+		{
+			uint64_t timestamps[2]{};
+			VkResult result = vkGetQueryPoolResults(
+				m_device.device(),
+				m_queryPool,
+				firstQuery, 2,
+				sizeof(timestamps), timestamps,
+				sizeof(uint64_t),
+				VK_QUERY_RESULT_64_BIT);
+
+			if (result == VK_SUCCESS)
+			{
+				double nanoseconds = static_cast<double>(timestamps[1] - timestamps[0]) * m_device.properties.limits.timestampPeriod;
+				m_lastFrameTime = static_cast<float>(nanoseconds * 1e-6);
+				m_hasResult = true;
+				newResult = true;
+			}
+			m_written[frameIndex] = false;
+		}
+
+		vkCmdResetQueryPool(commandBuffer, m_queryPool, firstQuery, 2);
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_queryPool, firstQuery);
+		return newResult;
+	}
+
+	void GpuTimer::endFrame(VkCommandBuffer commandBuffer, uint32_t frameIndex)
+	{
+		if (!m_supported)
+			return;
+
+		vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_queryPool, 2 * frameIndex + 1);
+		m_written[frameIndex] = true;
+	}
+
+} // namespace VEGraphics
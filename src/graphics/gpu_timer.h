@@ -0,0 +1,48 @@
+#pragma once
+
+#include "graphics/device.h"
+
+#include <vulkan/vulkan.h>
+
+#include <vector>
+
+namespace VEGraphics
+{
+	/// @brief Measures the GPU time of whole frames with timestamp queries
+	/// @note Every frame in flight has its own pair of queries. The result of a frame is read when its
+	/// slot is used again, after the fence of the frame has been waited on, so reading never stalls.
+	class GpuTimer
+	{
+	public:
+		GpuTimer(VulkanDevice& device, uint32_t frameCount);
+		~GpuTimer();
+
+		GpuTimer(const GpuTimer&) = delete;
+		GpuTimer& operator=(const GpuTimer&) = delete;
+
+		/// @brief Reads the result of the previous use of the slot and writes the begin timestamp
+		/// @return True if a new frame time was read
+		/// @note Has to be recorded outside of a render pass
+		bool beginFrame(VkCommandBuffer commandBuffer, uint32_t frameIndex);
+		void endFrame(VkCommandBuffer commandBuffer, uint32_t frameIndex);
+
+		/// @brief Returns false if the graphics queue does not support timestamps
+		bool isSupported() const { return m_supported; }
+
+		/// @brief Returns true once the first frame has been measured
+		bool hasResult() const { return m_hasResult; }
+
+		/// @brief GPU time in milliseconds of the most recently finished frame
+		float lastFrameTime() const { return m_lastFrameTime; }
+
+	private:
+		VulkanDevice& m_device;
+		VkQueryPool m_queryPool = VK_NULL_HANDLE;
+		bool m_supported = false;
+
+		std::vector<bool> m_written; // Queries of the slot were written and not read yet
+		bool m_hasResult = false;
+		float m_lastFrameTime = 0.0f;
+	};
+
+} // namespace VEGraphics
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+
+// Minimal subset of the KTX 2.0 container (https://registry.khronos.org/KTX/specs/2.0/ktxspec.v2.html)
+// Only single layer, single face 2D textures without supercompression are supported
+
+namespace VEGraphics
+{
+	/// @brief Every KTX2 file starts with this identifier
+	constexpr uint8_t KTX2_IDENTIFIER[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+	/// @brief File header following the identifier
+	struct Ktx2Header
+	{
+		uint32_t vkFormat;
+		uint32_t typeSize;
+		uint32_t pixelWidth;
+		uint32_t pixelHeight;
+		uint32_t pixelDepth;
+		uint32_t layerCount;
+		uint32_t faceCount;
+		uint32_t levelCount;
+		uint32_t supercompressionScheme;
+	};
+
+	/// @brief Byte ranges of the data format descriptor, key/value data and supercompression global data
+	struct Ktx2Index
+	{
+		uint32_t dfdByteOffset;
+		uint32_t dfdByteLength;
+		uint32_t kvdByteOffset;
+		uint32_t kvdByteLength;
+		uint64_t sgdByteOffset;
+		uint64_t sgdByteLength;
+	};
+
+	/// @brief Byte range of one mip level, the level index is stored for level 0 first
+	struct Ktx2LevelIndex
+	{
+		uint64_t byteOffset;
+		uint64_t byteLength;
+		uint64_t uncompressedByteLength;
+	};
+
+	static_assert(sizeof(Ktx2Header) == 36, "Unexpected KTX2 header size");
+	static_assert(sizeof(Ktx2Index) == 32, "Unexpected KTX2 index size");
+	static_assert(sizeof(Ktx2LevelIndex) == 24, "Unexpected KTX2 level index size");
+
+	/// @brief Returns the size in bytes of a 4x4 block for BC formats and 0 for all other formats
+	inline uint32_t blockCompressedBlockSize(VkFormat format)
+	{
+		switch (format)
+		{
+		case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+		case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+			return 8;
+		case VK_FORMAT_BC3_UNORM_BLOCK:
+		case VK_FORMAT_BC3_SRGB_BLOCK:
+		case VK_FORMAT_BC7_UNORM_BLOCK:
+		case VK_FORMAT_BC7_SRGB_BLOCK:
+			return 16;
+		default:
+			return 0;
+		}
+	}
+
+	/// @brief Returns the size in bytes of one mip level of a supported texture format
+	/// @note Only BC1, BC3, BC7 and 8 bit RGBA formats are supported
+	inline uint64_t textureLevelSize(VkFormat format, uint32_t width, uint32_t height)
+	{
+		uint32_t blockSize = blockCompressedBlockSize(format);
+		if (blockSize > 0)
+			return static_cast<uint64_t>((width + 3) / 4) * ((height + 3) / 4) * blockSize;
+
+		return static_cast<uint64_t>(width) * height * 4;
+	}
+
+} // namespace VEGraphics
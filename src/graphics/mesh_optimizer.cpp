@@ -0,0 +1,349 @@
+#include "mesh_optimizer.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace VEGraphics
+{
+	namespace
+	{
+		// Tuning values from Tom Forsyth's "Linear-Speed Vertex Cache Optimisation"
+		constexpr uint32_t FORSYTH_CACHE_SIZE = 32;
+		constexpr float FORSYTH_CACHE_DECAY_POWER = 1.5f;
+		constexpr float FORSYTH_LAST_TRIANGLE_SCORE = 0.75f;
+		constexpr float FORSYTH_VALENCE_BOOST_SCALE = 2.0f;
+		constexpr float FORSYTH_VALENCE_BOOST_POWER = 0.5f;
+
+		float forsythVertexScore(int cachePosition, uint32_t activeTriangles)
+		{
+			if (activeTriangles == 0)
+				return -1.0f; // No triangle needs this vertex anymore
+
+			float score = 0.0f;
+			if (cachePosition >= 0)
+			{
+				if (cachePosition < 3)
+				{
+					// Used by the last triangle, a fixed score prevents favouring one of its edges
+					score = FORSYTH_LAST_TRIANGLE_SCORE;
+				}
+				else
+				{
+					const float scaler = 1.0f / (FORSYTH_CACHE_SIZE - 3);
+					score = std::pow(1.0f - (cachePosition - 3) * scaler, FORSYTH_CACHE_DECAY_POWER);
+				}
+			}
+
+			// Boost vertices with few remaining triangles to get rid of lone triangles early
+			score += FORSYTH_VALENCE_BOOST_SCALE * std::pow(static_cast<float>(activeTriangles), -FORSYTH_VALENCE_BOOST_POWER);
+			return score;
+		}
+
+		struct TriangleCluster
+		{
+			size_t firstTriangle = 0;
+			size_t triangleCount = 0;
+			float sortKey = 0.0f;
+		};
+	}
+
+	MeshOptimizer::VertexCacheStatistics MeshOptimizer::analyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize)
+	{
+		VertexCacheStatistics statistics{};
+		if (indices.empty() || vertexCount == 0)
+			return statistics;
+
+		// A vertex is in the FIFO cache if it was inserted less than cacheSize insertions ago
+		std::vector<uint32_t> timestamps(vertexCount, 0);
+		std::vector<bool> referenced(vertexCount, false);
+		uint32_t time = cacheSize + 1;
+		size_t referencedCount = 0;
+
+		for (uint32_t index : indices)
+		{
+			assert(index < vertexCount && "Index out of range");
+			if (time - timestamps[index] > cacheSize)
+			{
+				timestamps[index] = time++;
+				statistics.vertexTransforms++;
+			}
+
+			if (!referenced[index])
+			{
+				referenced[index] = true;
+				referencedCount++;
+			}
+		}
+
+		statistics.acmr = static_cast<float>(statistics.vertexTransforms) / static_cast<float>(indices.size() / 3);
+		statistics.atvr = static_cast<float>(statistics.vertexTransforms) / static_cast<float>(referencedCount);
+		return statistics;
+	}
+
+	void MeshOptimizer::optimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount)
+	{
+		assert(indices.size() % 3 == 0 && "Index count must be a multiple of 3");
+		const size_t triangleCount = indices.size() / 3;
+		if (triangleCount == 0)
+			return;
+
+		// Vertex to triangle adjacency, the first activeTriangles[v] entries of each range are the unemitted triangles
+		std::vector<uint32_t> activeTriangles(vertexCount, 0);
+		for (uint32_t index : indices)
+		{
+			assert(index < vertexCount && "Index out of range");
+			activeTriangles[index]++;
+		}
+
+		std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+		for (size_t v = 0; v < vertexCount; v++)
+		{
+			adjacencyOffsets[v + 1] = adjacencyOffsets[v] + activeTriangles[v];
+		}
+
+		std::vector<uint32_t> adjacency(indices.size());
+		std::vector<uint32_t> fillOffsets(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+		for (size_t t = 0; t < triangleCount; t++)
+		{
+			for (size_t k = 0; k < 3; k++)
+			{
+				adjacency[fillOffsets[indices[3 * t + k]]++] = static_cast<uint32_t>(t);
+			}
+		}
+
+		// Initial scores
+		std::vector<int> cachePositions(vertexCount, -1);
+		std::vector<float> vertexScores(vertexCount);
+		for (size_t v = 0; v < vertexCount; v++)
+		{
+			vertexScores[v] = forsythVertexScore(-1, activeTriangles[v]);
+		}
+
+		std::vector<float> triangleScores(triangleCount);
+		std::vector<bool> emitted(triangleCount, false);
+		int64_t bestTriangle = -1;
+		float bestScore = -1.0f;
+		for (size_t t = 0; t < triangleCount; t++)
+		{
+			triangleScores[t] = vertexScores[indices[3 * t + 0]] + vertexScores[indices[3 * t + 1]] + vertexScores[indices[3 * t + 2]];
+			if (triangleScores[t] > bestScore)
+			{
+				bestScore = triangleScores[t];
+				bestTriangle = static_cast<int64_t>(t);
+			}
+		}
+
+		std::vector<uint32_t> cache;
+		std::vector<uint32_t> newCache;
+		cache.reserve(FORSYTH_CACHE_SIZE + 3);
+		newCache.reserve(FORSYTH_CACHE_SIZE + 3);
+
+		std::vector<uint32_t> result;
+		result.reserve(indices.size());
+		size_t inputCursor = 0;
+
+		while (result.size() < indices.size())
+		{
+			if (bestTriangle < 0)
+			{
+				// No candidate in the cache, continue with the next unemitted triangle in input order
+				while (emitted[inputCursor])
+					inputCursor++;
+
+				bestTriangle = static_cast<int64_t>(inputCursor);
+			}
+
+			const size_t triangle = static_cast<size_t>(bestTriangle);
+			const uint32_t* triangleIndices = &indices[3 * triangle];
+			emitted[triangle] = true;
+			result.insert(result.end(), triangleIndices, triangleIndices + 3);
+
+			// Emitted vertices move to the front of the cache
+			newCache.clear();
+			newCache.insert(newCache.end(), triangleIndices, triangleIndices + 3);
+			for (uint32_t vertex : cache)
+			{
+				if (vertex != triangleIndices[0] && vertex != triangleIndices[1] && vertex != triangleIndices[2])
+					newCache.push_back(vertex);
+			}
+
+			// Remove the triangle from the active adjacency of its vertices
+			for (size_t k = 0; k < 3; k++)
+			{
+				const uint32_t vertex = triangleIndices[k];
+				auto begin = adjacency.begin() + adjacencyOffsets[vertex];
+				auto end = begin + activeTriangles[vertex];
+				auto it = std::find(begin, end, static_cast<uint32_t>(triangle));
+				assert(it != end && "Triangle missing in adjacency");
+				std::iter_swap(it, end - 1);
+				activeTriangles[vertex]--;
+			}
+
+			// Rescore all vertices whose cache position changed (including evicted ones)
+			for (size_t i = 0; i < newCache.size(); i++)
+			{
+				const uint32_t vertex = newCache[i];
+				cachePositions[vertex] = i < FORSYTH_CACHE_SIZE ? static_cast<int>(i) : -1;
+
+				const float newScore = forsythVertexScore(cachePositions[vertex], activeTriangles[vertex]);
+				const float delta = newScore - vertexScores[vertex];
+				vertexScores[vertex] = newScore;
+
+				const uint32_t begin = adjacencyOffsets[vertex];
+				for (uint32_t a = begin; a < begin + activeTriangles[vertex]; a++)
+				{
+					triangleScores[adjacency[a]] += delta;
+				}
+			}
+
+			// Next triangle is the best one touching the cache
+			bestTriangle = -1;
+			bestScore = -1.0f;
+			for (uint32_t vertex : newCache)
+			{
+				const uint32_t begin = adjacencyOffsets[vertex];
+				for (uint32_t a = begin; a < begin + activeTriangles[vertex]; a++)
+				{
+					const uint32_t candidate = adjacency[a];
+					if (triangleScores[candidate] > bestScore)
+					{
+						bestScore = triangleScores[candidate];
+						bestTriangle = candidate;
+					}
+				}
+			}
+
+			if (newCache.size() > FORSYTH_CACHE_SIZE)
+				newCache.resize(FORSYTH_CACHE_SIZE);
+
+			cache.swap(newCache);
+		}
+
+		indices.swap(result);
+	}
+
+	void MeshOptimizer::optimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<Vector3>& positions, float threshold)
+	{
+		assert(indices.size() % 3 == 0 && "Index count must be a multiple of 3");
+		const size_t triangleCount = indices.size() / 3;
+		if (triangleCount == 0)
+			return;
+
+		const uint32_t cacheSize = 16;
+		const float meshAcmr = analyzeVertexCache(indices, positions.size(), cacheSize).acmr;
+
+		// Split at triangles which miss all three vertices (cache restart), as long as
+		// the cluster does not exceed the allowed ACMR
+		std::vector<TriangleCluster> clusters;
+		std::vector<uint32_t> timestamps(positions.size(), 0);
+		uint32_t time = cacheSize + 1;
+		size_t clusterMisses = 0;
+
+		clusters.push_back({ 0, 0, 0.0f });
+		for (size_t t = 0; t < triangleCount; t++)
+		{
+			uint32_t misses = 0;
+			for (size_t k = 0; k < 3; k++)
+			{
+				const uint32_t index = indices[3 * t + k];
+				if (time - timestamps[index] > cacheSize)
+				{
+					timestamps[index] = time++;
+					misses++;
+				}
+			}
+
+			auto& current = clusters.back();
+			if (misses == 3 && current.triangleCount > 0)
+			{
+				const float clusterAcmr = static_cast<float>(clusterMisses) / static_cast<float>(current.triangleCount);
+				if (clusterAcmr <= meshAcmr * threshold)
+				{
+					clusters.push_back({ t, 0, 0.0f });
+					clusterMisses = 0;
+				}
+			}
+
+			clusters.back().triangleCount++;
+			clusterMisses += misses;
+		}
+
+		if (clusters.size() <= 1)
+			return;
+
+		// Mesh centroid weighted by triangle area
+		Vector3 meshCentroid{ 0.0f };
+		float meshArea = 0.0f;
+		for (size_t t = 0; t < triangleCount; t++)
+		{
+			const Vector3& p0 = positions[indices[3 * t + 0]];
+			const Vector3& p1 = positions[indices[3 * t + 1]];
+			const Vector3& p2 = positions[indices[3 * t + 2]];
+			const float area = glm::length(glm::cross(p1 - p0, p2 - p0));
+			meshCentroid += (p0 + p1 + p2) * (area / 3.0f);
+			meshArea += area;
+		}
+		meshCentroid = meshArea > 0.0f ? meshCentroid / meshArea : Vector3{ 0.0f };
+
+		// Clusters facing away from the center are likely to occlude others and are drawn first
+		for (auto& cluster : clusters)
+		{
+			Vector3 centroid{ 0.0f };
+			Vector3 normal{ 0.0f };
+			float area = 0.0f;
+			for (size_t t = cluster.firstTriangle; t < cluster.firstTriangle + cluster.triangleCount; t++)
+			{
+				const Vector3& p0 = positions[indices[3 * t + 0]];
+				const Vector3& p1 = positions[indices[3 * t + 1]];
+				const Vector3& p2 = positions[indices[3 * t + 2]];
+				const Vector3 crossProduct = glm::cross(p1 - p0, p2 - p0);
+				const float triangleArea = glm::length(crossProduct);
+				centroid += (p0 + p1 + p2) * (triangleArea / 3.0f);
+				normal += crossProduct;
+				area += triangleArea;
+			}
+
+			if (area <= 0.0f || glm::length(normal) <= 0.0f)
+			{
+				cluster.sortKey = 0.0f;
+				continue;
+			}
+
+			centroid /= area;
+			cluster.sortKey = glm::dot(centroid - meshCentroid, glm::normalize(normal));
+		}
+
+		std::stable_sort(clusters.begin(), clusters.end(), [](const TriangleCluster& a, const TriangleCluster& b)
+			{
+				return a.sortKey > b.sortKey;
+			});
+
+		std::vector<uint32_t> result;
+		result.reserve(indices.size());
+		for (const auto& cluster : clusters)
+		{
+			auto begin = indices.begin() + 3 * cluster.firstTriangle;
+			result.insert(result.end(), begin, begin + 3 * cluster.triangleCount);
+		}
+		indices.swap(result);
+	}
+
+	std::vector<uint32_t> MeshOptimizer::buildVertexFetchRemap(std::vector<uint32_t>& indices, size_t vertexCount, size_t& uniqueCount)
+	{
+		std::vector<uint32_t> remap(vertexCount, INVALID_INDEX);
+		uint32_t nextVertex = 0;
+		for (auto& index : indices)
+		{
+			assert(index < vertexCount && "Index out of range");
+			if (remap[index] == INVALID_INDEX)
+				remap[index] = nextVertex++;
+
+			index = remap[index];
+		}
+
+		uniqueCount = nextVertex;
+		return remap;
+	}
+
+} // namespace VEGraphics
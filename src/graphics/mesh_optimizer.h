@@ -0,0 +1,67 @@
+#pragma once
+
+#include "utils/math_utils.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace VEGraphics
+{
+	/// @brief Import-time optimizations for indexed triangle lists
+	/// @note Intended order: optimizeVertexCache -> optimizeOverdraw -> optimizeVertexFetch
+	class MeshOptimizer
+	{
+	public:
+		/// @brief Post-transform vertex cache statistics of an index buffer
+		struct VertexCacheStatistics
+		{
+			uint32_t vertexTransforms = 0;
+			float acmr = 0.0f; // Average cache miss ratio (transformed vertices per triangle)
+			float atvr = 0.0f; // Average transform to vertex ratio (1.0 is optimal)
+		};
+
+		/// @brief Simulates a FIFO post-transform cache and returns the resulting statistics
+		/// @param indices Triangle list indices
+		/// @param vertexCount Number of vertices referenced by the indices
+		/// @param cacheSize Size of the simulated FIFO cache
+		static VertexCacheStatistics analyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize = 16);
+
+		/// @brief Reorders triangles to improve post-transform cache hits (Tom Forsyth's linear-speed algorithm)
+		/// @param indices Triangle list indices which are reordered in place
+		/// @param vertexCount Number of vertices referenced by the indices
+		static void optimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount);
+
+		/// @brief Reorders clusters of triangles so outward facing clusters are drawn first to reduce overdraw
+		/// @param indices Vertex cache optimized triangle list indices which are reordered in place
+		/// @param positions Vertex positions
+		/// @param threshold Allowed increase of the ACMR in favour of smaller clusters (1.05 means 5% worse)
+		/// @note Based on the clustering and sorting of Sander et al. "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw"
+		static void optimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<Vector3>& positions, float threshold = 1.05f);
+
+		/// @brief Reorders the vertices in the order of their first use and drops unreferenced vertices
+		/// @param vertices Vertices which are reordered in place
+		/// @param indices Triangle list indices which are remapped to the new vertex order
+		template<typename Vertex>
+		static void optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+		{
+			size_t uniqueCount = 0;
+			auto remap = buildVertexFetchRemap(indices, vertices.size(), uniqueCount);
+
+			std::vector<Vertex> result(uniqueCount);
+			for (size_t i = 0; i < vertices.size(); i++)
+			{
+				if (remap[i] != INVALID_INDEX)
+					result[remap[i]] = vertices[i];
+			}
+			vertices.swap(result);
+		}
+
+	private:
+		static constexpr uint32_t INVALID_INDEX = ~0u;
+
+		/// @brief Remaps the indices to the order of first use
+		/// @return Remap table from old to new vertex index (INVALID_INDEX for unreferenced vertices)
+		static std::vector<uint32_t> buildVertexFetchRemap(std::vector<uint32_t>& indices, size_t vertexCount, size_t& uniqueCount);
+	};
+
+} // namespace VEGraphics
@@ -1,5 +1,7 @@
 #include "model.h"
 
+#include "graphics/mesh_optimizer.h"
+#include "graphics/uploader.h"
 #include "utils/utils.h"
 
 #define TINYOBJLOADER_IMPLEMENTATION
@@ -7,8 +9,11 @@
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtx/hash.hpp>
 
+#include <atomic>
 #include <cassert>
 #include <cstring>
+#include <iomanip>
+#include <iostream>
 #include <unordered_map>
 
 namespace std
@@ -28,26 +33,59 @@ namespace std
 
 namespace VEGraphics
 {
-	Model::Model(VulkanDevice& device, const Model::Builder& builder) : m_device{ device }
+	static std::atomic<uint32_t> s_nextModelId{ 0 };
+
+	Model::Model(VulkanDevice& device, const Model::Builder& builder) : m_device{ device }, m_id{ s_nextModelId++ }
+	{
+		upload(builder);
+		m_device.uploader().flush();
+	}
+
+	Model::Model(VulkanDevice& device) : m_device{ device }, m_id{ s_nextModelId++ }
 	{
-		createVertexBuffers(builder.vertices);
-		createIndexBuffers(builder.indices);
 	}
 
 	Model::~Model()
 	{
+		// The buffers are still used by the transfer queue
+		if (m_uploadPending)
+			m_device.uploader().flush();
 	}
 
 	std::unique_ptr<Model> Model::createModelFromFile(VulkanDevice& device, const std::filesystem::path& filepath)
 	{
 		Builder builder{};
 		builder.loadModel(filepath);
+		builder.printStatistics(filepath);
 
 		return std::make_unique<Model>(device, builder);
 	}
 
+	void Model::upload(const Model::Builder& builder)
+	{
+		assert(!m_ready && !m_uploadPending && "Model is already uploaded");
+
+		auto& uploader = m_device.uploader();
+		VkCommandBuffer commandBuffer = uploader.beginTransfer();
+
+		std::vector<std::unique_ptr<Buffer>> stagingBuffers;
+		stagingBuffers.push_back(createVertexBuffers(commandBuffer, builder.vertices));
+		stagingBuffers.push_back(createPositionBuffer(commandBuffer, builder.vertices));
+		if (auto indexStagingBuffer = createIndexBuffers(commandBuffer, builder.indices))
+			stagingBuffers.push_back(std::move(indexStagingBuffer));
+
+		m_uploadPending = true;
+		uploader.submit(
+			commandBuffer,
+			std::move(stagingBuffers),
+			[this](VkCommandBuffer graphicsCommandBuffer) { acquireBuffers(graphicsCommandBuffer); },
+			[this]() { m_uploadPending = false; m_ready = true; });
+	}
+
 	void Model::bind(VkCommandBuffer commandBuffer)
 	{
+		assert(m_ready && "Cannot bind a model before it is uploaded");
+
 		VkBuffer buffers[] = { m_vertexBuffer->buffer() };
 		VkDeviceSize offsets[] = { 0 };
 		vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
@@ -56,6 +94,18 @@ namespace VEGraphics
 			vkCmdBindIndexBuffer(commandBuffer, m_indexBuffer->buffer(), 0, VK_INDEX_TYPE_UINT32);
 	}
 
+	void Model::bindPositions(VkCommandBuffer commandBuffer)
+	{
+		assert(m_ready && "Cannot bind a model before it is uploaded");
+
+		VkBuffer buffers[] = { m_positionBuffer->buffer() };
+		VkDeviceSize offsets[] = { 0 };
+		vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
+
+		if (m_hasIndexBuffer)
+			vkCmdBindIndexBuffer(commandBuffer, m_indexBuffer->buffer(), 0, VK_INDEX_TYPE_UINT32);
+	}
+
 	void Model::draw(VkCommandBuffer commandBuffer)
 	{
 		if (m_hasIndexBuffer)
@@ -68,7 +118,7 @@ namespace VEGraphics
 		}
 	}
 
-	void Model::createVertexBuffers(const std::vector<Vertex>& vertices)
+	std::unique_ptr<Buffer> Model::createVertexBuffers(VkCommandBuffer transferCommandBuffer, const std::vector<Vertex>& vertices)
 	{
 		m_vertexCount = static_cast<uint32_t>(vertices.size());
 		assert(m_vertexCount >= 3 && "Vertex count must be atleast 3");
@@ -76,16 +126,16 @@ namespace VEGraphics
 		VkDeviceSize bufferSize = sizeof(vertices[0]) * m_vertexCount;
 		uint32_t vertexSize = sizeof(vertices[0]);
 
-		Buffer stagingBuffer{
+		auto stagingBuffer = std::make_unique<Buffer>(
 			m_device,
 			vertexSize,
 			m_vertexCount,
 			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-		};
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+		);
 
-		stagingBuffer.map();
-		stagingBuffer.writeToBuffer((void*)vertices.data());
+		stagingBuffer->map();
+		stagingBuffer->writeToBuffer((void*)vertices.data());
 
 		m_vertexBuffer = std::make_unique<Buffer>(
 			m_device,
@@ -95,29 +145,70 @@ namespace VEGraphics
 			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
 		);
 
-		m_device.copyBuffer(stagingBuffer.buffer(), m_vertexBuffer->buffer(), bufferSize);
+		VkBufferCopy copyRegion{ 0, 0, bufferSize };
+		vkCmdCopyBuffer(transferCommandBuffer, stagingBuffer->buffer(), m_vertexBuffer->buffer(), 1, &copyRegion);
+		m_device.uploader().releaseBuffer(transferCommandBuffer, m_vertexBuffer->buffer());
+
+		return stagingBuffer;
 	}
 
-	void Model::createIndexBuffers(const std::vector<uint32_t>& indices)
+	std::unique_ptr<Buffer> Model::createPositionBuffer(VkCommandBuffer transferCommandBuffer, const std::vector<Vertex>& vertices)
+	{
+		std::vector<Vector3> positions(vertices.size());
+		for (size_t i = 0; i < vertices.size(); i++)
+		{
+			positions[i] = vertices[i].position;
+		}
+
+		VkDeviceSize bufferSize = sizeof(positions[0]) * m_vertexCount;
+		uint32_t positionSize = sizeof(positions[0]);
+
+		auto stagingBuffer = std::make_unique<Buffer>(
+			m_device,
+			positionSize,
+			m_vertexCount,
+			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
+		);
+
+		stagingBuffer->map();
+		stagingBuffer->writeToBuffer((void*)positions.data());
+
+		m_positionBuffer = std::make_unique<Buffer>(
+			m_device,
+			positionSize,
+			m_vertexCount,
+			VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
+		);
+
+		VkBufferCopy copyRegion{ 0, 0, bufferSize };
+		vkCmdCopyBuffer(transferCommandBuffer, stagingBuffer->buffer(), m_positionBuffer->buffer(), 1, &copyRegion);
+		m_device.uploader().releaseBuffer(transferCommandBuffer, m_positionBuffer->buffer());
+
+		return stagingBuffer;
+	}
+
+	std::unique_ptr<Buffer> Model::createIndexBuffers(VkCommandBuffer transferCommandBuffer, const std::vector<uint32_t>& indices)
 	{
 		m_indexCount = static_cast<uint32_t>(indices.size());
 		m_hasIndexBuffer = m_indexCount > 0;
 		if (!m_hasIndexBuffer)
-			return;
+			return nullptr;
 
 		VkDeviceSize bufferSize = sizeof(indices[0]) * m_indexCount;
 		uint32_t indexSize = sizeof(indices[0]);
 
-		Buffer stagingBuffer{
+		auto stagingBuffer = std::make_unique<Buffer>(
 			m_device,
 			indexSize,
 			m_indexCount,
 			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
 			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-		};
+		);
 
-		stagingBuffer.map();
-		stagingBuffer.writeToBuffer((void*)indices.data());
+		stagingBuffer->map();
+		stagingBuffer->writeToBuffer((void*)indices.data());
 
 		m_indexBuffer = std::make_unique<Buffer>(
 			m_device,
@@ -127,7 +218,21 @@ namespace VEGraphics
 			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT
 		);
 
-		m_device.copyBuffer(stagingBuffer.buffer(), m_indexBuffer->buffer(), bufferSize);
+		VkBufferCopy copyRegion{ 0, 0, bufferSize };
+		vkCmdCopyBuffer(transferCommandBuffer, stagingBuffer->buffer(), m_indexBuffer->buffer(), 1, &copyRegion);
+		m_device.uploader().releaseBuffer(transferCommandBuffer, m_indexBuffer->buffer());
+
+		return stagingBuffer;
+	}
+
+	void Model::acquireBuffers(VkCommandBuffer graphicsCommandBuffer)
+	{
+		auto& uploader = m_device.uploader();
+		uploader.acquireBuffer(graphicsCommandBuffer, m_vertexBuffer->buffer(), VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT);
+		uploader.acquireBuffer(graphicsCommandBuffer, m_positionBuffer->buffer(), VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT);
+
+		if (m_hasIndexBuffer)
+			uploader.acquireBuffer(graphicsCommandBuffer, m_indexBuffer->buffer(), VK_ACCESS_INDEX_READ_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT);
 	}
 
 	std::vector<VkVertexInputBindingDescription> Model::Vertex::bindingDescriptions()
@@ -149,6 +254,20 @@ namespace VEGraphics
 		return attributeDescriptions;
 	}
 
+	std::vector<VkVertexInputBindingDescription> Model::Vertex::positionBindingDescriptions()
+	{
+		std::vector<VkVertexInputBindingDescription> bindingDescriptions(1);
+		bindingDescriptions[0].binding = 0;
+		bindingDescriptions[0].stride = sizeof(Vector3);
+		bindingDescriptions[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+		return bindingDescriptions;
+	}
+
+	std::vector<VkVertexInputAttributeDescription> Model::Vertex::positionAttributeDescriptions()
+	{
+		return { { 0, 0, VK_FORMAT_R32G32B32_SFLOAT, 0 } };
+	}
+
 	void Model::Builder::loadModel(const std::filesystem::path& filepath)
 	{
 		tinyobj::attrib_t attrib;
@@ -210,6 +329,39 @@ namespace VEGraphics
 				indices.push_back(uniqueVertices[vertex]);
 			}
 		}
+
+		optimization = optimize();
+	}
+
+	Model::Builder::OptimizationStatistics Model::Builder::optimize()
+	{
+		if (indices.empty())
+			return {};
+
+		auto before = MeshOptimizer::analyzeVertexCache(indices, vertices.size());
+
+		std::vector<Vector3> positions(vertices.size());
+		for (size_t i = 0; i < vertices.size(); i++)
+		{
+			positions[i] = vertices[i].position;
+		}
+
+		MeshOptimizer::optimizeVertexCache(indices, vertices.size());
+		MeshOptimizer::optimizeOverdraw(indices, positions);
+		MeshOptimizer::optimizeVertexFetch(vertices, indices);
+
+		auto after = MeshOptimizer::analyzeVertexCache(indices, vertices.size());
+		return { before, after };
+	}
+
+	void Model::Builder::printStatistics(const std::filesystem::path& filepath) const
+	{
+		std::cout << "Optimized model " << filepath << std::endl;
+		std::cout << std::fixed << std::setprecision(3)
+			<< "\tACMR: " << optimization.before.acmr << " -> " << optimization.after.acmr
+			<< ", ATVR: " << optimization.before.atvr << " -> " << optimization.after.atvr
+			<< " (" << indices.size() / 3 << " triangles, " << vertices.size() << " vertices)"
+			<< std::defaultfloat << std::endl;
 	}
 
 } // namespace vre
\ No newline at end of file
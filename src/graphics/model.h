@@ -2,6 +2,7 @@
 
 #include "graphics/buffer.h"
 #include "graphics/device.h"
+#include "graphics/mesh_optimizer.h"
 #include "utils/math_utils.h"
 
 #include <filesystem>
@@ -23,6 +24,10 @@ namespace VEGraphics
 			static std::vector<VkVertexInputBindingDescription> bindingDescriptions();
 			static std::vector<VkVertexInputAttributeDescription> attributeDescriptions();
 
+			/// @brief Descriptions of the position-only stream which is used by depth-only passes
+			static std::vector<VkVertexInputBindingDescription> positionBindingDescriptions();
+			static std::vector<VkVertexInputAttributeDescription> positionAttributeDescriptions();
+
 			bool operator==(const Vertex& other) const 
 			{
 				return position == other.position && color == other.color && normal == other.normal && uv == other.uv;
@@ -31,13 +36,33 @@ namespace VEGraphics
 
 		struct Builder
 		{
+			/// @brief Vertex cache statistics of the indices before and after optimize
+			struct OptimizationStatistics
+			{
+				MeshOptimizer::VertexCacheStatistics before;
+				MeshOptimizer::VertexCacheStatistics after;
+			};
+
 			std::vector<Vertex> vertices{};
 			std::vector<uint32_t> indices{};
+			OptimizationStatistics optimization{}; // Set by loadModel
 
+			/// @brief Loads and optimizes the model, can be called on a worker thread
 			void loadModel(const std::filesystem::path& filepath);
+
+			/// @brief Reorders indices and vertices for post-transform cache, overdraw and vertex fetch efficiency
+			/// @return The ACMR and ATVR before and after optimization, printed by the caller
+			OptimizationStatistics optimize();
+
+			/// @brief Prints the optimization statistics, called on the main thread so the output of parallel loads does not interleave
+			void printStatistics(const std::filesystem::path& filepath) const;
 		};
 
 		Model(VulkanDevice& device, const Model::Builder& builder);
+
+		/// @brief Creates an empty model which can not be drawn until upload was called
+		/// @note Used by the AssetLoader to hand out models before their data is loaded
+		Model(VulkanDevice& device);
 		~Model();
 
 		Model(const Model&) = delete;
@@ -45,21 +70,45 @@ namespace VEGraphics
 
 		static std::unique_ptr<Model> createModelFromFile(VulkanDevice& device, const std::filesystem::path& filepath);
 
+		/// @brief Creates the GPU buffers and submits the data to the transfer queue
+		/// @note The model is ready once the upload was acquired on the graphics queue at the beginning of a frame
+		void upload(const Model::Builder& builder);
+
+		/// @brief Returns true if the model data is uploaded and it can be drawn
+		bool isReady() const { return m_ready; }
+
+		/// @brief Returns a unique id of the model, used to sort draws by mesh
+		uint32_t id() const { return m_id; }
+
 		void bind(VkCommandBuffer commandBuffer);
+
+		/// @brief Binds the position-only vertex stream and the index buffer for depth-only passes
+		void bindPositions(VkCommandBuffer commandBuffer);
+
 		void draw(VkCommandBuffer commandBuffer);
 
 	private:
-		void createVertexBuffers(const std::vector<Vertex>& vertices);
-		void createIndexBuffers(const std::vector<uint32_t>& indices);
+		/// @brief Creates the vertex buffer and records the copy from the returned staging buffer
+		std::unique_ptr<Buffer> createVertexBuffers(VkCommandBuffer transferCommandBuffer, const std::vector<Vertex>& vertices);
+		/// @brief Creates the position-only vertex buffer and records the copy from the returned staging buffer
+		std::unique_ptr<Buffer> createPositionBuffer(VkCommandBuffer transferCommandBuffer, const std::vector<Vertex>& vertices);
+		/// @brief Creates the index buffer and records the copy from the returned staging buffer (nullptr without indices)
+		std::unique_ptr<Buffer> createIndexBuffers(VkCommandBuffer transferCommandBuffer, const std::vector<uint32_t>& indices);
+		void acquireBuffers(VkCommandBuffer graphicsCommandBuffer);
 
 		VulkanDevice& m_device;
+		uint32_t m_id;
 
 		std::unique_ptr<Buffer> m_vertexBuffer;
+		std::unique_ptr<Buffer> m_positionBuffer; // Tightly packed positions for better cache use in depth-only passes
 		uint32_t m_vertexCount;
 
 		bool m_hasIndexBuffer = false;
 		std::unique_ptr<Buffer> m_indexBuffer;
 		uint32_t m_indexCount;
+
+		bool m_ready = false;
+		bool m_uploadPending = false;
 	};
 
 } // namespace vre
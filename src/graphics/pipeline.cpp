@@ -7,6 +7,7 @@
 #include <fstream>
 #include <iostream>
 #include <stdexcept>
+#include <utility>
 
 namespace VEGraphics
 {
@@ -14,10 +15,11 @@ namespace VEGraphics
 		VulkanDevice& device, 
 		const std::string& vertShaderPath, 
 		const std::string& fragShaderPath, 
-		const PipelineConfigInfo& configInfo)
+		const PipelineConfigInfo& configInfo,
+		VkPipelineCache pipelineCache)
 		: m_device{ device }
 	{
-		createGraphicsPipeline(vertShaderPath, fragShaderPath, configInfo);
+		createGraphicsPipeline(vertShaderPath, fragShaderPath, configInfo, pipelineCache);
 	}
 
 	Pipeline::~Pipeline()
@@ -32,6 +34,14 @@ namespace VEGraphics
 		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_graphicsPipeline);
 	}
 
+	void Pipeline::swap(Pipeline& other)
+	{
+		assert(&m_device == &other.m_device && "Cannot swap pipelines of different devices");
+		std::swap(m_graphicsPipeline, other.m_graphicsPipeline);
+		std::swap(m_vertShaderModule, other.m_vertShaderModule);
+		std::swap(m_fragShaderModule, other.m_fragShaderModule);
+	}
+
 	void Pipeline::defaultPipelineConfigInfo(PipelineConfigInfo& configInfo)
 	{
 		configInfo.inputAssemblyInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
@@ -116,6 +126,22 @@ namespace VEGraphics
 		configInfo.colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
 	}
 
+	void Pipeline::enableDepthPrepass(PipelineConfigInfo& configInfo)
+	{
+		configInfo.colorBlendAttachment.colorWriteMask = 0;
+		configInfo.depthStencilInfo.depthWriteEnable = VK_TRUE;
+		configInfo.depthStencilInfo.depthCompareOp = VK_COMPARE_OP_LESS;
+
+		configInfo.bindingDescriptions = Model::Vertex::positionBindingDescriptions();
+		configInfo.attributeDescriptions = Model::Vertex::positionAttributeDescriptions();
+	}
+
+	void Pipeline::enableDepthEqual(PipelineConfigInfo& configInfo)
+	{
+		configInfo.depthStencilInfo.depthWriteEnable = VK_FALSE;
+		configInfo.depthStencilInfo.depthCompareOp = VK_COMPARE_OP_EQUAL;
+	}
+
 	std::vector<char> Pipeline::readFile(const std::string& filePath)
 	{
 		std::ifstream file{filePath, std::ios::ate | std::ios::binary};
@@ -132,15 +158,25 @@ namespace VEGraphics
 		return buffer;
 	}
 
-	void Pipeline::createGraphicsPipeline(const std::string& vertShaderPath, const std::string& fragShaderPath, const PipelineConfigInfo& configInfo)
+	void Pipeline::createGraphicsPipeline(const std::string& vertShaderPath, const std::string& fragShaderPath, const PipelineConfigInfo& configInfo, VkPipelineCache pipelineCache)
 	{
 		assert(configInfo.pipelineLayout != VK_NULL_HANDLE && "Cannot create graphics pipeline: no pipelineLayout provided in configInfo");
 		assert(configInfo.renderPass != VK_NULL_HANDLE && "Cannot create graphics pipeline: no renderPass provided in configInfo");
 
 		auto vertCode = readFile(vertShaderPath);
-		auto fragCode = readFile(fragShaderPath);
 		createShaderModule(vertCode, &m_vertShaderModule);
-		createShaderModule(fragCode, &m_fragShaderModule);
+
+		// Depth-only pipelines have no fragment shader
+		bool hasFragmentShader = !fragShaderPath.empty();
+		if (hasFragmentShader)
+		{
+			auto fragCode = readFile(fragShaderPath);
+			createShaderModule(fragCode, &m_fragShaderModule);
+		}
+
+		// Lets the compiler fold constants, unroll loops and remove branches per variant
+		VkSpecializationInfo specializationInfo = configInfo.specialization.info();
+		const VkSpecializationInfo* pSpecializationInfo = configInfo.specialization.empty() ? nullptr : &specializationInfo;
 
 		std::array<VkPipelineShaderStageCreateInfo, 2> shaderStages{};
 		shaderStages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
@@ -149,7 +185,7 @@ namespace VEGraphics
 		shaderStages[0].pName = "main";
 		shaderStages[0].flags = 0;
 		shaderStages[0].pNext = nullptr;
-		shaderStages[0].pSpecializationInfo = nullptr;
+		shaderStages[0].pSpecializationInfo = pSpecializationInfo;
 
 		shaderStages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
 		shaderStages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
@@ -157,7 +193,7 @@ namespace VEGraphics
 		shaderStages[1].pName = "main";
 		shaderStages[1].flags = 0;
 		shaderStages[1].pNext = nullptr;
-		shaderStages[1].pSpecializationInfo = nullptr;
+		shaderStages[1].pSpecializationInfo = pSpecializationInfo;
 
 		auto& bindingDescriptions = configInfo.bindingDescriptions;
 		auto& attributeDescriptions = configInfo.attributeDescriptions;
@@ -170,7 +206,7 @@ namespace VEGraphics
 
 		VkGraphicsPipelineCreateInfo pipelineInfo{};
 		pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-		pipelineInfo.stageCount = static_cast<uint32_t>(shaderStages.size());
+		pipelineInfo.stageCount = hasFragmentShader ? 2 : 1;
 		pipelineInfo.pStages = shaderStages.data();
 		pipelineInfo.pVertexInputState = &vertexInputInfo;
 		pipelineInfo.pInputAssemblyState = &configInfo.inputAssemblyInfo;
@@ -186,7 +222,7 @@ namespace VEGraphics
 		pipelineInfo.basePipelineIndex = -1;
 		pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 
-		if (vkCreateGraphicsPipelines(m_device.device(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &m_graphicsPipeline) != VK_SUCCESS)
+		if (vkCreateGraphicsPipelines(m_device.device(), pipelineCache, 1, &pipelineInfo, nullptr, &m_graphicsPipeline) != VK_SUCCESS)
 			throw std::runtime_error("failed to create graphics pipeline");
 	}
 
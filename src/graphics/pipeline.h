@@ -2,11 +2,42 @@
 
 #include "graphics/device.h"
 
+#include <cstddef>
+#include <cstring>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 namespace VEGraphics
 {
+	/// @brief Values of the specialization constants, shared by all shader stages of a pipeline
+	/// @note Constant ids which a stage does not declare are ignored by that stage
+	struct SpecializationConstants
+	{
+		/// @note Booleans have to be passed as VkBool32
+		template<typename T>
+		void set(uint32_t constantId, const T& value)
+		{
+			static_assert(std::is_trivially_copyable_v<T> && !std::is_same_v<T, bool>, "Use VkBool32 for boolean constants");
+
+			VkSpecializationMapEntry entry{ constantId, static_cast<uint32_t>(data.size()), sizeof(T) };
+			data.resize(data.size() + sizeof(T));
+			std::memcpy(data.data() + entry.offset, &value, sizeof(T));
+			entries.push_back(entry);
+		}
+
+		bool empty() const { return entries.empty(); }
+
+		/// @brief Points into this object, it has to outlive the pipeline creation
+		VkSpecializationInfo info() const
+		{
+			return { static_cast<uint32_t>(entries.size()), entries.data(), data.size(), data.data() };
+		}
+
+		std::vector<VkSpecializationMapEntry> entries;
+		std::vector<std::byte> data;
+	};
+
 	struct PipelineConfigInfo
 	{
 		PipelineConfigInfo() = default;
@@ -27,12 +58,20 @@ namespace VEGraphics
 		VkPipelineLayout pipelineLayout = nullptr;
 		VkRenderPass renderPass = nullptr;
 		uint32_t subpass = 0;
+		SpecializationConstants specialization{};
 	};
 
 	class Pipeline
 	{
 	public:
-		Pipeline(VulkanDevice& device, const std::string& vertShaderPath, const std::string& fragShaderPath, const PipelineConfigInfo& configInfo);
+		/// @param fragShaderPath Can be empty for depth-only pipelines
+		/// @param pipelineCache Cache the compilation is looked up in and stored to, can be VK_NULL_HANDLE
+		Pipeline(
+			VulkanDevice& device,
+			const std::string& vertShaderPath,
+			const std::string& fragShaderPath,
+			const PipelineConfigInfo& configInfo,
+			VkPipelineCache pipelineCache = VK_NULL_HANDLE);
 		~Pipeline();
 
 		Pipeline(const Pipeline&) = delete;
@@ -40,20 +79,30 @@ namespace VEGraphics
 
 		void bind(VkCommandBuffer commandBuffer);
 
+		/// @brief Exchanges the compiled pipelines, used to replace a pipeline in place when its shaders were reloaded
+		/// @note Pointers to this pipeline stay valid. The other pipeline has to outlive the frames which used this one.
+		void swap(Pipeline& other);
+
 		static void defaultPipelineConfigInfo(PipelineConfigInfo& configInfo);
 		static void enableAlphaBlending(PipelineConfigInfo& configInfo);
 
+		/// @brief Configures a depth pre-pass: position-only vertex stream, depth writes and no color writes
+		static void enableDepthPrepass(PipelineConfigInfo& configInfo);
+
+		/// @brief Configures shading after a depth pre-pass: only fragments with the pre-pass depth pass, no depth writes
+		static void enableDepthEqual(PipelineConfigInfo& configInfo);
+
 	private:
 		static std::vector<char> readFile(const std::string& filePath);
 
-		void createGraphicsPipeline(const std::string& vertShaderPath, const std::string& fragShaderPath, const PipelineConfigInfo& configInfo);
+		void createGraphicsPipeline(const std::string& vertShaderPath, const std::string& fragShaderPath, const PipelineConfigInfo& configInfo, VkPipelineCache pipelineCache);
 
 		void createShaderModule(const std::vector<char>& code, VkShaderModule* shaderModule);
 
 		VulkanDevice& m_device;
 		VkPipeline m_graphicsPipeline;
 		VkShaderModule m_vertShaderModule;
-		VkShaderModule m_fragShaderModule;
+		VkShaderModule m_fragShaderModule = VK_NULL_HANDLE;
 	};
 
 } // namespace vre
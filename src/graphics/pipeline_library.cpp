@@ -0,0 +1,169 @@
+#include "pipeline_library.h"
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+namespace VEGraphics
+{
+	PipelineLibrary::PipelineLibrary(VulkanDevice& device, const std::string& cachePath, uint32_t threadCount)
+		: m_device{ device }, m_cachePath{ cachePath }
+	{
+		createPipelineCache();
+		m_threadPool = std::make_unique<VEUtils::ThreadPool>(threadCount);
+	}
+
+	PipelineLibrary::~PipelineLibrary()
+	{
+		// Waits for running compilations, queued ones are dropped
+		m_threadPool.reset();
+
+		saveCache();
+		vkDestroyPipelineCache(m_device.device(), m_pipelineCache, nullptr);
+	}
+
+	PipelineHandle PipelineLibrary::request(
+		const std::string& name,
+		const std::string& vertShaderPath,
+		const std::string& fragShaderPath,
+		ConfigFunction configure)
+	{
+		std::lock_guard lock{ m_mutex };
+
+		auto it = m_pipelines.find(name);
+		if (it != m_pipelines.end())
+			return it->second.handle;
+
+		Entry& entry = m_pipelines[name];
+		entry.vertShaderPath = vertShaderPath;
+		entry.fragShaderPath = fragShaderPath;
+		entry.configure = std::move(configure);
+		entry.handle.m_future = compile(entry).share();
+		return entry.handle;
+	}
+
+	void PipelineLibrary::release(const std::string& name)
+	{
+		std::lock_guard lock{ m_mutex };
+
+		auto it = m_pipelines.find(name);
+		if (it == m_pipelines.end())
+			return;
+
+		// The reload calls the config function, which references objects of the owner
+		if (it->second.reload.valid())
+			it->second.reload.wait();
+		m_pipelines.erase(it);
+	}
+
+	void PipelineLibrary::reloadShader(const std::string& spirvPath)
+	{
+		std::lock_guard lock{ m_mutex };
+
+		auto path = std::filesystem::path(spirvPath).lexically_normal();
+		for (auto& [name, entry] : m_pipelines)
+		{
+			bool usesShader =
+				std::filesystem::path(entry.vertShaderPath).lexically_normal() == path ||
+				(!entry.fragShaderPath.empty() && std::filesystem::path(entry.fragShaderPath).lexically_normal() == path);
+
+			// A pending reload is superseded, its result is dropped when the future is replaced
+			if (usesShader && entry.handle.isReady())
+				entry.reload = compile(entry);
+		}
+	}
+
+	void PipelineLibrary::update()
+	{
+		std::lock_guard lock{ m_mutex };
+
+		// Hold the previous pipelines after the swap, they are destroyed at the end of the update
+		std::vector<std::shared_ptr<Pipeline>> replaced;
+		for (auto& [name, entry] : m_pipelines)
+		{
+			if (!entry.reload.valid() || entry.reload.wait_for(std::chrono::seconds{ 0 }) != std::future_status::ready)
+				continue;
+
+			try
+			{
+				std::shared_ptr<Pipeline> pipeline = entry.reload.get();
+
+				// Frames in flight still use the previous pipelines, reloading is rare enough to wait for them
+				if (replaced.empty())
+					vkDeviceWaitIdle(m_device.device());
+
+				entry.handle.wait().swap(*pipeline);
+				replaced.push_back(std::move(pipeline));
+				std::cout << "Reloaded pipeline " << name << std::endl;
+			}
+			catch (const std::exception& e)
+			{
+				std::cout << "Failed to reload pipeline " << name << ": " << e.what() << std::endl;
+			}
+		}
+	}
+
+	void PipelineLibrary::saveCache()
+	{
+		if (m_cachePath.empty())
+			return;
+
+		size_t size = 0;
+		if (vkGetPipelineCacheData(m_device.device(), m_pipelineCache, &size, nullptr) != VK_SUCCESS || size == 0)
+			return;
+
+		std::vector<char> data(size);
+		if (vkGetPipelineCacheData(m_device.device(), m_pipelineCache, &size, data.data()) != VK_SUCCESS)
+			return;
+
+		std::ofstream file{ m_cachePath, std::ios::binary | std::ios::trunc };
+		if (!file.is_open())
+		{
+			std::cout << "Failed to write pipeline cache: " << m_cachePath << std::endl;
+			return;
+		}
+		file.write(data.data(), static_cast<std::streamsize>(size));
+	}
+
+	std::future<std::shared_ptr<Pipeline>> PipelineLibrary::compile(const Entry& entry)
+	{
+		return m_threadPool->submit([this, vertShaderPath = entry.vertShaderPath, fragShaderPath = entry.fragShaderPath, configure = entry.configure]()
+		{
+			PipelineConfigInfo configInfo{};
+			configure(configInfo);
+
+			// The pipeline cache is internally synchronized, all workers can compile into it at the same time
+			return std::make_shared<Pipeline>(m_device, vertShaderPath, fragShaderPath, configInfo, m_pipelineCache);
+		});
+	}
+
+	void PipelineLibrary::createPipelineCache()
+	{
+		// The driver validates the header and ignores data from another device or driver version
+		std::vector<char> initialData;
+		if (!m_cachePath.empty())
+		{
+			std::ifstream file{ m_cachePath, std::ios::ate | std::ios::binary };
+			if (file.is_open())
+			{
+				initialData.resize(static_cast<size_t>(file.tellg()));
+				file.seekg(0);
+				file.read(initialData.data(), initialData.size());
+			}
+		}
+
+		VkPipelineCacheCreateInfo cacheInfo{};
+		cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+		cacheInfo.initialDataSize = initialData.size();
+		cacheInfo.pInitialData = initialData.empty() ? nullptr : initialData.data();
+
+		if (vkCreatePipelineCache(m_device.device(), &cacheInfo, nullptr, &m_pipelineCache) != VK_SUCCESS)
+			throw std::runtime_error("failed to create pipeline cache");
+
+		if (!initialData.empty())
+			std::cout << "Pipeline cache loaded: " << initialData.size() / 1024 << " KiB" << std::endl;
+	}
+
+} // namespace VEGraphics
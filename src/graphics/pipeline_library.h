@@ -0,0 +1,128 @@
+#pragma once
+
+#include "graphics/device.h"
+#include "graphics/pipeline.h"
+#include "utils/thread_pool.h"
+
+#include <vulkan/vulkan.h>
+
+#include <chrono>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace VEGraphics
+{
+	/// @brief Pipeline which is compiled by the PipelineLibrary
+	/// @note Cheap to copy, all copies refer to the same pipeline
+	class PipelineHandle
+	{
+	public:
+		PipelineHandle() = default;
+
+		/// @brief Returns true once the pipeline was compiled
+		bool isReady() const
+		{
+			return m_future.valid() && m_future.wait_for(std::chrono::seconds{ 0 }) == std::future_status::ready;
+		}
+
+		/// @brief Returns the pipeline or nullptr while it is still compiling
+		/// @note Rethrows the exception if the compilation failed
+		Pipeline* get() const { return isReady() ? m_future.get().get() : nullptr; }
+
+		/// @brief Blocks until the pipeline is compiled
+		/// @note Rethrows the exception if the compilation failed
+		Pipeline& wait() const { return *m_future.get(); }
+
+		/// @brief Blocks until the compilation has finished or failed without accessing the result
+		/// @note Owners of the pipeline layout or render pass call it before destroying them
+		void waitForCompilation() const
+		{
+			if (m_future.valid())
+				m_future.wait();
+		}
+
+	private:
+		friend class PipelineLibrary;
+
+		std::shared_future<std::shared_ptr<Pipeline>> m_future;
+	};
+
+	/// @brief Compiles pipelines on worker threads so new shaders and config variants do not stall the frame
+	/// @note All pipelines share one VkPipelineCache which is stored on disk, later runs compile from the cache.
+	/// Render systems keep drawing with a generic pipeline until the specialized one is ready.
+	class PipelineLibrary
+	{
+	public:
+		static constexpr const char* DEFAULT_CACHE_PATH = ENGINE_DIR "pipeline_cache.bin";
+
+		/// @brief Fills the config of a pipeline, called on the worker thread which compiles it
+		/// @note The config is not copyable because it points into itself, so it is built where it is used
+		using ConfigFunction = std::function<void(PipelineConfigInfo&)>;
+
+		/// @param cachePath File the pipeline cache is loaded from and saved to, empty to not persist the cache
+		/// @param threadCount Number of compile threads, 0 uses the hardware concurrency minus the main thread
+		PipelineLibrary(VulkanDevice& device, const std::string& cachePath = DEFAULT_CACHE_PATH, uint32_t threadCount = 0);
+		~PipelineLibrary();
+
+		PipelineLibrary(const PipelineLibrary&) = delete;
+		PipelineLibrary& operator=(const PipelineLibrary&) = delete;
+
+		/// @brief Starts compiling a pipeline and returns immediately
+		/// @param name Unique name of the pipeline, requesting the same name again returns the same handle
+		/// @param fragShaderPath Can be empty for depth-only pipelines
+		/// @note The config function is kept for reloads, owners release the pipeline before destroying the render pass
+		/// or pipeline layout it references
+		PipelineHandle request(
+			const std::string& name,
+			const std::string& vertShaderPath,
+			const std::string& fragShaderPath,
+			ConfigFunction configure);
+
+		/// @brief Removes the pipeline from the library, so it is not reloaded anymore and a later request compiles it again
+		/// @note Waits for a running reload, handles of the owner keep the pipeline alive
+		void release(const std::string& name);
+
+		/// @brief Recompiles all pipelines which use the SPIR-V file in the background
+		/// @note The pipelines are replaced in update once they are compiled, handles and pointers stay valid
+		void reloadShader(const std::string& spirvPath);
+
+		/// @brief Replaces reloaded pipelines, has to be called on the main thread between frames
+		/// @note Failed reloads are reported and the pipeline keeps its previous shaders
+		void update();
+
+		/// @brief Writes the pipeline cache to the cache path, also called on destruction
+		void saveCache();
+
+		VkPipelineCache pipelineCache() const { return m_pipelineCache; }
+
+	private:
+		struct Entry
+		{
+			PipelineHandle handle;
+			std::string vertShaderPath;
+			std::string fragShaderPath;
+			ConfigFunction configure;
+			std::future<std::shared_ptr<Pipeline>> reload; // Valid while the pipeline is recompiled
+		};
+
+		void createPipelineCache();
+
+		/// @brief Queues the compilation of the pipeline on a worker thread
+		std::future<std::shared_ptr<Pipeline>> compile(const Entry& entry);
+
+		VulkanDevice& m_device;
+		std::string m_cachePath;
+		VkPipelineCache m_pipelineCache = VK_NULL_HANDLE;
+
+		std::mutex m_mutex;
+		std::unordered_map<std::string, Entry> m_pipelines;
+
+		// Stopped first in the destructor, running compilations still use the cache
+		std::unique_ptr<VEUtils::ThreadPool> m_threadPool;
+	};
+
+} // namespace VEGraphics
@@ -0,0 +1,80 @@
+#include "pipeline_variants.h"
+
+#include "graphics/model.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace VEGraphics
+{
+	uint32_t PipelineVariantKey::lightCountBucket(uint32_t lightCount)
+	{
+		if (lightCount == 0)
+			return 0;
+
+		return std::min(std::bit_ceil(lightCount), static_cast<uint32_t>(MAX_LIGHTS));
+	}
+
+	void PipelineVariantKey::apply(PipelineConfigInfo& configInfo) const
+	{
+		configInfo.specialization.set(LIGHT_COUNT_CONSTANT, static_cast<int32_t>(lightCount));
+		configInfo.specialization.set(SPECULAR_CONSTANT, static_cast<VkBool32>(specular ? VK_TRUE : VK_FALSE));
+
+		if (vertexFormat == VertexFormat::PositionOnly)
+		{
+			configInfo.bindingDescriptions = Model::Vertex::positionBindingDescriptions();
+			configInfo.attributeDescriptions = Model::Vertex::positionAttributeDescriptions();
+		}
+		else
+		{
+			configInfo.bindingDescriptions = Model::Vertex::bindingDescriptions();
+			configInfo.attributeDescriptions = Model::Vertex::attributeDescriptions();
+		}
+	}
+
+	PipelineVariants::PipelineVariants(
+		PipelineLibrary& pipelineLibrary,
+		const std::string& name,
+		const std::string& vertShaderPath,
+		const std::string& fragShaderPath,
+		PipelineLibrary::ConfigFunction configure)
+		: m_pipelineLibrary{ pipelineLibrary },
+		m_name{ name },
+		m_vertShaderPath{ vertShaderPath },
+		m_fragShaderPath{ fragShaderPath },
+		m_configure{ std::move(configure) }
+	{
+	}
+
+	PipelineVariants::~PipelineVariants()
+	{
+		// The config function can reference objects of the owner which are destroyed next
+		for (const auto& [value, handle] : m_variants)
+		{
+			handle.waitForCompilation();
+			m_pipelineLibrary.release(variantName(value));
+		}
+	}
+
+	const PipelineHandle& PipelineVariants::variant(const PipelineVariantKey& key)
+	{
+		uint32_t value = key.value();
+		auto it = m_variants.find(value);
+		if (it != m_variants.end())
+			return it->second;
+
+		// The library deduplicates by name as well, so owners with the same name share their variants
+		PipelineHandle handle = m_pipelineLibrary.request(
+			variantName(value),
+			m_vertShaderPath,
+			m_fragShaderPath,
+			[configure = m_configure, key](PipelineConfigInfo& configInfo)
+			{
+				configure(configInfo);
+				key.apply(configInfo);
+			});
+
+		return m_variants.emplace(value, std::move(handle)).first->second;
+	}
+
+} // namespace VEGraphics
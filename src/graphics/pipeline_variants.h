@@ -0,0 +1,75 @@
+#pragma once
+
+#include "graphics/frame_info.h"
+#include "graphics/pipeline.h"
+#include "graphics/pipeline_library.h"
+
+#include <string>
+#include <unordered_map>
+
+namespace VEGraphics
+{
+	/// @brief Selects a specialized variant of a pipeline
+	/// @note The constant ids match the layout(constant_id) declarations in the shaders
+	struct PipelineVariantKey
+	{
+		static constexpr uint32_t LIGHT_COUNT_CONSTANT = 0;
+		static constexpr uint32_t SPECULAR_CONSTANT = 1;
+
+		enum class VertexFormat : uint8_t
+		{
+			Standard = 0,
+			PositionOnly = 1, // Only the position stream is bound (depth pre-pass)
+		};
+
+		/// @brief Bound of the light loop, has to be at least the number of lights in the frame
+		uint32_t lightCount = MAX_LIGHTS;
+		bool specular = true;
+		VertexFormat vertexFormat = VertexFormat::Standard;
+
+		/// @brief Rounds up to 0, 1, 2, 4, 8 or MAX_LIGHTS, so a handful of variants cover every light count
+		static uint32_t lightCountBucket(uint32_t lightCount);
+
+		uint32_t value() const
+		{
+			return lightCount | (static_cast<uint32_t>(specular) << 8) | (static_cast<uint32_t>(vertexFormat) << 9);
+		}
+
+		/// @brief Sets the specialization constants and the vertex input of the variant
+		void apply(PipelineConfigInfo& configInfo) const;
+	};
+
+	/// @brief Variants of one pipeline which are compiled on first use and deduplicated by their key
+	class PipelineVariants
+	{
+	public:
+		/// @param configure Base config of all variants, the variant key is applied afterwards
+		PipelineVariants(
+			PipelineLibrary& pipelineLibrary,
+			const std::string& name,
+			const std::string& vertShaderPath,
+			const std::string& fragShaderPath,
+			PipelineLibrary::ConfigFunction configure);
+		~PipelineVariants();
+
+		PipelineVariants(const PipelineVariants&) = delete;
+		PipelineVariants& operator=(const PipelineVariants&) = delete;
+
+		/// @brief Returns the variant and starts compiling it if it was not requested before
+		const PipelineHandle& variant(const PipelineVariantKey& key);
+
+		size_t variantCount() const { return m_variants.size(); }
+
+	private:
+		std::string variantName(uint32_t value) const { return m_name + "#" + std::to_string(value); }
+
+		PipelineLibrary& m_pipelineLibrary;
+		std::string m_name;
+		std::string m_vertShaderPath;
+		std::string m_fragShaderPath;
+		PipelineLibrary::ConfigFunction m_configure;
+
+		std::unordered_map<uint32_t, PipelineHandle> m_variants;
+	};
+
+} // namespace VEGraphics
@@ -0,0 +1,175 @@
+#include "render_queue.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+
+namespace VEGraphics
+{
+	namespace
+	{
+		constexpr uint32_t PIPELINE_BITS = 12;
+		constexpr uint32_t FIELD_BITS = 16;
+
+		uint64_t field(uint32_t value, uint32_t bits, uint32_t shift)
+		{
+			return (static_cast<uint64_t>(value) & ((1ull << bits) - 1)) << shift;
+		}
+	}
+
+	RenderState::RenderState()
+	{
+		static std::atomic<uint32_t> nextId{ 0 };
+		m_id = nextId++;
+		assert(m_id < (1u << PIPELINE_BITS) && "Too many render states for the pipeline field of the sort key");
+	}
+
+	uint16_t RenderQueue::quantizeDepth(float distance, const DepthRange& range)
+	{
+		// Maps [near, far] to [0, 1] with more precision close to the camera, draws outside are clamped
+		float nearPlane = std::max(range.nearPlane, 1e-4f);
+		float farPlane = std::max(range.farPlane, nearPlane * 1.001f);
+		float normalized = std::log(std::max(distance, nearPlane) / nearPlane) / std::log(farPlane / nearPlane);
+		return static_cast<uint16_t>(std::clamp(normalized, 0.0f, 1.0f) * 65535.0f);
+	}
+
+	uint64_t RenderQueue::opaqueSortKey(uint32_t pipeline, uint32_t material, uint32_t mesh, float distance, const DepthRange& range, bool coarseFrontToBack)
+	{
+		uint16_t depth = quantizeDepth(distance, range);
+		uint32_t coarseDepth = coarseFrontToBack ? depth >> 12 : 0;
+		return field(static_cast<uint32_t>(Pass::Opaque), 4, 60) |
+			field(pipeline, PIPELINE_BITS, 48) |
+			field(coarseDepth, 4, 44) |
+			field(material, FIELD_BITS, 28) |
+			field(mesh, FIELD_BITS, 12) |
+			field(depth >> 4, 12, 0);
+	}
+
+	uint64_t RenderQueue::depthPrepassSortKey(uint32_t pipeline, uint32_t mesh, float distance, const DepthRange& range)
+	{
+		return field(static_cast<uint32_t>(Pass::DepthPrepass), 4, 60) |
+			field(pipeline, PIPELINE_BITS, 48) |
+			field(mesh, FIELD_BITS, 16) |
+			field(quantizeDepth(distance, range), FIELD_BITS, 0);
+	}
+
+	uint64_t RenderQueue::transparentSortKey(uint32_t pipeline, float distance, const DepthRange& range)
+	{
+		uint16_t invertedDepth = static_cast<uint16_t>(0xFFFF - quantizeDepth(distance, range));
+		return field(static_cast<uint32_t>(Pass::Transparent), 4, 60) |
+			field(invertedDepth, FIELD_BITS, 44) |
+			field(pipeline, PIPELINE_BITS, 32);
+	}
+
+	void RenderQueue::clear()
+	{
+		m_packets.clear();
+		m_entries.clear();
+		m_pushConstants.clear();
+	}
+
+	uint32_t RenderQueue::storePushConstants(const void* data, size_t size)
+	{
+		assert(size <= 128 && "Push constants exceed the guaranteed 128 bytes");
+		uint32_t offset = static_cast<uint32_t>(m_pushConstants.size());
+		m_pushConstants.resize(m_pushConstants.size() + size);
+		std::memcpy(m_pushConstants.data() + offset, data, size);
+		return offset;
+	}
+
+	void RenderQueue::sort()
+	{
+		m_sortBuffer.resize(m_entries.size());
+
+		for (uint32_t shift = 0; shift < 64; shift += 8)
+		{
+			std::array<uint32_t, 256> counts{};
+			for (const auto& entry : m_entries)
+			{
+				counts[(entry.key >> shift) & 0xFF]++;
+			}
+
+			// All keys have the same digit, the pass would not change the order
+			if (counts[(m_entries.front().key >> shift) & 0xFF] == m_entries.size())
+				continue;
+
+			uint32_t offset = 0;
+			for (auto& count : counts)
+			{
+				uint32_t digitCount = count;
+				count = offset;
+				offset += digitCount;
+			}
+
+			for (const auto& entry : m_entries)
+			{
+				m_sortBuffer[counts[(entry.key >> shift) & 0xFF]++] = entry;
+			}
+			m_entries.swap(m_sortBuffer);
+		}
+	}
+
+	void RenderQueue::execute(VkCommandBuffer commandBuffer)
+	{
+		m_statistics = {};
+		if (m_entries.empty())
+			return;
+
+		sort();
+
+		const RenderState* boundState = nullptr;
+		Model* boundModel = nullptr;
+		bool boundPositionsOnly = false;
+		for (const auto& entry : m_entries)
+		{
+			const Packet& packet = m_packets[entry.packet];
+
+			if (packet.state != boundState)
+			{
+				packet.state->pipeline->bind(commandBuffer);
+				m_statistics.pipelineBinds++;
+
+				if (packet.state->bindDescriptors)
+				{
+					packet.state->bindDescriptors(commandBuffer);
+					m_statistics.descriptorBinds++;
+				}
+				boundState = packet.state;
+			}
+
+			vkCmdPushConstants(
+				commandBuffer,
+				packet.state->pipelineLayout,
+				packet.state->pushConstantStages,
+				0,
+				packet.pushConstantSize,
+				m_pushConstants.data() + packet.pushConstantOffset);
+
+			if (packet.model)
+			{
+				// Vertex and index buffer bindings are kept across pipeline changes
+				bool positionsOnly = packet.state->positionsOnly;
+				if (packet.model != boundModel || positionsOnly != boundPositionsOnly)
+				{
+					if (positionsOnly)
+						packet.model->bindPositions(commandBuffer);
+					else
+						packet.model->bind(commandBuffer);
+
+					m_statistics.vertexBufferBinds++;
+					boundModel = packet.model;
+					boundPositionsOnly = positionsOnly;
+				}
+				packet.model->draw(commandBuffer);
+			}
+			else
+			{
+				vkCmdDraw(commandBuffer, packet.vertexCount, 1, 0, 0);
+			}
+			m_statistics.drawCalls++;
+		}
+	}
+
+} // namespace VEGraphics
@@ -0,0 +1,138 @@
+#pragma once
+
+#include "graphics/model.h"
+#include "graphics/pipeline.h"
+
+#include <vulkan/vulkan.h>
+
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+namespace VEGraphics
+{
+	/// @brief Pipeline and descriptor state which is shared by the draws of a render system
+	/// @note Owned by the render system, it has to outlive the packets which reference it
+	struct RenderState
+	{
+		RenderState();
+
+		Pipeline* pipeline = nullptr;
+		VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+		VkShaderStageFlags pushConstantStages = 0;
+		bool positionsOnly = false; // Models are bound with their position-only stream (depth pre-pass)
+
+		/// @brief Binds the descriptor sets after the pipeline was bound
+		std::function<void(VkCommandBuffer)> bindDescriptors;
+
+		/// @brief Unique id which is used as the pipeline field of the sort keys
+		uint32_t id() const { return m_id; }
+
+	private:
+		uint32_t m_id;
+	};
+
+	/// @brief Collects the draws of all render systems, sorts them by a 64-bit key and records them
+	/// with as few pipeline, descriptor and vertex buffer binds as possible
+	/// @note Opaque keys are laid out as | pass 4 | pipeline 12 | coarse depth 4 | material 16 | mesh 16 | depth 12 |,
+	/// so state changes are minimized within coarse front to back buckets and equal state is drawn front to back.
+	/// Depth pre-pass keys are | pass 4 | pipeline 12 | mesh 16 | depth 16 |, shading after a pre-pass has no
+	/// overdraw so it drops the coarse depth. Transparent keys put the inverted depth right after the pass to draw back to front.
+	class RenderQueue
+	{
+	public:
+		enum class Pass : uint8_t
+		{
+			DepthPrepass = 0,
+			Opaque = 1,
+			Transparent = 2,
+		};
+
+		struct Statistics
+		{
+			uint32_t drawCalls = 0;
+			uint32_t pipelineBinds = 0;
+			uint32_t descriptorBinds = 0;
+			uint32_t vertexBufferBinds = 0;
+		};
+
+		RenderQueue() = default;
+
+		RenderQueue(const RenderQueue&) = delete;
+		RenderQueue& operator=(const RenderQueue&) = delete;
+
+		/// @brief Clipping planes of the view, the sort depth is spread over them
+		struct DepthRange
+		{
+			float nearPlane;
+			float farPlane;
+		};
+
+		/// @brief Maps a view distance logarithmically between the clipping planes to 16 bits, closer draws get smaller values
+		/// @note Each of the 16 coarse depth buckets of the opaque key covers the same distance ratio
+		static uint16_t quantizeDepth(float distance, const DepthRange& range);
+
+		/// @param coarseFrontToBack Sort by coarse depth before material to reduce overdraw, not needed after a depth pre-pass
+		static uint64_t opaqueSortKey(uint32_t pipeline, uint32_t material, uint32_t mesh, float distance, const DepthRange& range, bool coarseFrontToBack = true);
+		static uint64_t depthPrepassSortKey(uint32_t pipeline, uint32_t mesh, float distance, const DepthRange& range);
+		static uint64_t transparentSortKey(uint32_t pipeline, float distance, const DepthRange& range);
+
+		/// @brief Removes all packets, called at the beginning of every frame
+		void clear();
+
+		/// @brief Adds a draw of an indexed or non-indexed model
+		template<typename PushConstants>
+		void submit(uint64_t sortKey, const RenderState& state, Model* model, const PushConstants& push)
+		{
+			m_packets.push_back({ &state, model, 0, storePushConstants(&push, sizeof(PushConstants)), sizeof(PushConstants) });
+			m_entries.push_back({ sortKey, static_cast<uint32_t>(m_packets.size() - 1) });
+		}
+
+		/// @brief Adds a draw without vertex buffers, the vertices are generated in the vertex shader
+		template<typename PushConstants>
+		void submit(uint64_t sortKey, const RenderState& state, uint32_t vertexCount, const PushConstants& push)
+		{
+			m_packets.push_back({ &state, nullptr, vertexCount, storePushConstants(&push, sizeof(PushConstants)), sizeof(PushConstants) });
+			m_entries.push_back({ sortKey, static_cast<uint32_t>(m_packets.size() - 1) });
+		}
+
+		/// @brief Sorts the packets and records them into the command buffer
+		/// @note Has to be called inside of the render pass
+		void execute(VkCommandBuffer commandBuffer);
+
+		/// @brief Returns the bind and draw counts of the last execute
+		const Statistics& statistics() const { return m_statistics; }
+
+		size_t size() const { return m_packets.size(); }
+
+	private:
+		struct Packet
+		{
+			const RenderState* state;
+			Model* model;
+			uint32_t vertexCount;
+			uint32_t pushConstantOffset;
+			uint32_t pushConstantSize;
+		};
+
+		struct Entry
+		{
+			uint64_t key;
+			uint32_t packet;
+		};
+
+		uint32_t storePushConstants(const void* data, size_t size);
+
+		/// @brief LSD radix sort with 8-bit digits, digits which are equal for all keys are skipped
+		void sort();
+
+		std::vector<Packet> m_packets;
+		std::vector<Entry> m_entries;
+		std::vector<Entry> m_sortBuffer;
+		std::vector<std::byte> m_pushConstants;
+
+		Statistics m_statistics{};
+	};
+
+} // namespace VEGraphics
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "graphics/device.h"
+
+#include <vulkan/vulkan.h>
+
+namespace VEGraphics
+{
+	/// @brief Offscreen color and depth images the scene is rendered into before it is copied to the swap chain
+	/// @note The render pass is compatible with the swap chain render pass, so the same pipelines can be used.
+	/// The images have the full output extent, a lower render resolution only uses the top left part of them.
+	/// Cameras which render offscreen get their own target.
+	class RenderTarget
+	{
+	public:
+		RenderTarget(VulkanDevice& device, VkExtent2D extent, VkFormat colorFormat, VkFormat depthFormat);
+		~RenderTarget();
+
+		RenderTarget(const RenderTarget&) = delete;
+		RenderTarget& operator=(const RenderTarget&) = delete;
+
+		/// @brief The color image is in TRANSFER_SRC_OPTIMAL layout after the render pass
+		VkRenderPass renderPass() const { return m_renderPass; }
+		VkFramebuffer framebuffer() const { return m_framebuffer; }
+		VkImage colorImage() const { return m_colorImage; }
+		VkFormat colorFormat() const { return m_colorFormat; }
+		VkExtent2D extent() const { return m_extent; }
+
+	private:
+		void createImage(VkFormat format, VkImageUsageFlags usage, VkImageAspectFlags aspect, VkImage& image, VkDeviceMemory& memory, VkImageView& view);
+		void createRenderPass(VkFormat depthFormat);
+		void createFramebuffer();
+
+		VulkanDevice& m_device;
+		VkExtent2D m_extent;
+		VkFormat m_colorFormat;
+
+		VkImage m_colorImage = VK_NULL_HANDLE;
+		VkDeviceMemory m_colorImageMemory = VK_NULL_HANDLE;
+		VkImageView m_colorImageView = VK_NULL_HANDLE;
+
+		VkImage m_depthImage = VK_NULL_HANDLE;
+		VkDeviceMemory m_depthImageMemory = VK_NULL_HANDLE;
+		VkImageView m_depthImageView = VK_NULL_HANDLE;
+
+		VkRenderPass m_renderPass = VK_NULL_HANDLE;
+		VkFramebuffer m_framebuffer = VK_NULL_HANDLE;
+	};
+
+} // namespace VEGraphics
@@ -1,14 +1,28 @@
 #include "renderer.h"
 
+#include "graphics/uploader.h"
+
+#include <algorithm>
 #include <array>
+#include <iostream>
 #include <stdexcept>
 
 namespace VEGraphics
 {
-	Renderer::Renderer(Window& window, VulkanDevice& device) : m_window{ window }, m_device{ device }
+	Renderer::Renderer(Window& window, VulkanDevice& device, const PresentSettings& presentSettings)
+		: m_window{ window }, m_device{ device }, m_presentSettings{ presentSettings },
+		m_framesInFlight{ std::clamp(presentSettings.framesInFlight, 1u, SwapChain::MAX_FRAMES_IN_FLIGHT) }
 	{
+		m_presentSettings.framesInFlight = m_framesInFlight;
+		m_pendingInputTimes.resize(m_framesInFlight);
 		recreateSwapChain();
 		createCommandBuffers();
+
+		m_frameDescriptorAllocators.resize(m_framesInFlight);
+		for (auto& allocator : m_frameDescriptorAllocators)
+		{
+			allocator = std::make_unique<DescriptorAllocator>(m_device);
+		}
 	}
 
 	Renderer::~Renderer()
@@ -16,11 +30,13 @@ namespace VEGraphics
 		freeCommandBuffers();
 	}
 
-	VkCommandBuffer Renderer::beginFrame()
+	VkCommandBuffer Renderer::beginFrame(std::chrono::steady_clock::time_point inputTime)
 	{
 		assert(!m_isFrameStarted && "Cannot call beginFrame while already in progress");
 
 		auto result = m_swapChain->acquireNextImage(&m_currentImageIndex);
+		collectLatencySamples();
+		releaseRetiredResources();
 		if (result == VK_ERROR_OUT_OF_DATE_KHR)
 		{
 			recreateSwapChain();
@@ -31,6 +47,11 @@ namespace VEGraphics
 			throw std::runtime_error("failed to aquire swap chain image");
 
 		m_isFrameStarted = true;
+		m_frameInputTime = inputTime;
+
+		// The fence of this frame was waited on in acquireNextImage
+		m_frameAllocator.beginFrame(m_currentFrameIndex);
+		m_frameDescriptorAllocators[m_currentFrameIndex]->reset();
 
 		auto commandBuffer = currentCommandBuffer();
 		VkCommandBufferBeginInfo beginInfo{};
@@ -39,6 +60,18 @@ namespace VEGraphics
 		if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
 			throw std::runtime_error("failed to begin recording command buffer");
 
+		// The frame of this slot has finished, its GPU time drives the render resolution of this frame
+		if (m_gpuTimer.beginFrame(commandBuffer, m_currentFrameIndex))
+			m_dynamicResolution.update(m_gpuTimer.lastFrameTime());
+
+		m_offscreenFrame = m_dynamicResolution.isEnabled();
+		m_renderExtent = m_offscreenFrame
+			? m_dynamicResolution.renderExtent(m_swapChain->swapChainExtent())
+			: m_swapChain->swapChainExtent();
+
+		// Take ownership of finished uploads before anything is drawn
+		m_uploadTimelineValue = m_device.uploader().recordAcquires(commandBuffer);
+
 		return commandBuffer;
 	}
 
@@ -46,10 +79,14 @@ namespace VEGraphics
 	{
 		assert(m_isFrameStarted && "Cannot call endFrame while frame is not in progress");
 		auto commandBuffer = currentCommandBuffer();
+		m_gpuTimer.endFrame(commandBuffer, m_currentFrameIndex);
 		if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
 			throw std::runtime_error("failed to record command buffer");
 
-		auto result = m_swapChain->submitCommandBuffers(&commandBuffer, &m_currentImageIndex);
+		size_t syncSlot = m_swapChain->currentFrame();
+		auto result = m_swapChain->submitCommandBuffers(&commandBuffer, &m_currentImageIndex, m_uploadTimelineValue);
+		m_pendingInputTimes[syncSlot] = m_frameInputTime;
+		m_submittedFrames++;
 		if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || m_window.wasWindowResized())
 		{
 			m_window.resetWindowResizedFlag();
@@ -61,7 +98,7 @@ namespace VEGraphics
 		}
 
 		m_isFrameStarted = false;
-		m_currentFrameIndex = (m_currentFrameIndex + 1) % SwapChain::MAX_FRAMES_IN_FLIGHT;
+		m_currentFrameIndex = (m_currentFrameIndex + 1) % m_framesInFlight;
 	}
 
 	void Renderer::beginSwapChainRenderPass(VkCommandBuffer commandBuffer)
@@ -106,9 +143,199 @@ namespace VEGraphics
 
 	}
 
+	void Renderer::beginScenePass(VkCommandBuffer commandBuffer)
+	{
+		if (!m_offscreenFrame)
+		{
+			beginSwapChainRenderPass(commandBuffer);
+			return;
+		}
+
+		assert(m_isFrameStarted && "Cannot call beginScenePass while frame is not in progress");
+		assert(commandBuffer == currentCommandBuffer() && "Cannot begin render pass on a command buffer from a diffrent frame");
+
+		// Only the part of the target at the render resolution is used
+		beginRenderPass(commandBuffer, m_renderTarget->renderPass(), m_renderTarget->framebuffer(), m_renderExtent);
+	}
+
+	void Renderer::endScenePass(VkCommandBuffer commandBuffer)
+	{
+		if (!m_offscreenFrame)
+		{
+			endSwapChainRenderPass(commandBuffer);
+			return;
+		}
+
+		assert(m_isFrameStarted && "Cannot call endScenePass while frame is not in progress");
+		assert(commandBuffer == currentCommandBuffer() && "Cannot end render pass on a command buffer from a diffrent frame");
+
+		vkCmdEndRenderPass(commandBuffer);
+		blitToSwapChain(commandBuffer);
+	}
+
+	void Renderer::setViewport(VkCommandBuffer commandBuffer, const Vector4& region)
+	{
+		assert(m_isFrameStarted && "Cannot call setViewport while frame is not in progress");
+
+		VkViewport viewport{};
+		viewport.x = region.x * m_renderExtent.width;
+		viewport.y = region.y * m_renderExtent.height;
+		viewport.width = region.z * m_renderExtent.width;
+		viewport.height = region.w * m_renderExtent.height;
+		viewport.minDepth = 0.0f;
+		viewport.maxDepth = 1.0f;
+
+		VkRect2D scissor{};
+		scissor.offset = { static_cast<int32_t>(viewport.x), static_cast<int32_t>(viewport.y) };
+		scissor.extent = { static_cast<uint32_t>(viewport.width), static_cast<uint32_t>(viewport.height) };
+
+		vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+		vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+	}
+
+	std::unique_ptr<RenderTarget> Renderer::createRenderTarget(VkExtent2D extent)
+	{
+		return std::make_unique<RenderTarget>(m_device, extent, m_swapChain->swapChainImageFormat(), m_swapChain->findDepthFormat());
+	}
+
+	void Renderer::beginTargetPass(VkCommandBuffer commandBuffer, RenderTarget& target)
+	{
+		assert(m_isFrameStarted && "Cannot call beginTargetPass while frame is not in progress");
+		assert(commandBuffer == currentCommandBuffer() && "Cannot begin render pass on a command buffer from a diffrent frame");
+
+		beginRenderPass(commandBuffer, target.renderPass(), target.framebuffer(), target.extent());
+	}
+
+	void Renderer::endTargetPass(VkCommandBuffer commandBuffer)
+	{
+		assert(m_isFrameStarted && "Cannot call endTargetPass while frame is not in progress");
+		assert(commandBuffer == currentCommandBuffer() && "Cannot end render pass on a command buffer from a diffrent frame");
+
+		vkCmdEndRenderPass(commandBuffer);
+	}
+
+	void Renderer::beginRenderPass(VkCommandBuffer commandBuffer, VkRenderPass renderPass, VkFramebuffer framebuffer, VkExtent2D extent)
+	{
+		VkRenderPassBeginInfo renderPassInfo{};
+		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+		renderPassInfo.renderPass = renderPass;
+		renderPassInfo.framebuffer = framebuffer;
+		renderPassInfo.renderArea.offset = { 0,0 };
+		renderPassInfo.renderArea.extent = extent;
+
+		std::array<VkClearValue, 2> clearValues{};
+		clearValues[0].color = { 0.01f, 0.01f, 0.01f, 1.0f };
+		clearValues[1].depthStencil = { 1.0f, 0 };
+		renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
+		renderPassInfo.pClearValues = clearValues.data();
+
+		vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+		VkViewport viewport{};
+		viewport.x = 0.0f;
+		viewport.y = 0.0f;
+		viewport.width = static_cast<float>(extent.width);
+		viewport.height = static_cast<float>(extent.height);
+		viewport.minDepth = 0.0f;
+		viewport.maxDepth = 1.0f;
+		VkRect2D scissor{ {0,0}, extent };
+		vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+		vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+	}
+
+	void Renderer::toggleDynamicResolution()
+	{
+		m_dynamicResolution.setEnabled(m_blitSupported && !m_dynamicResolution.isEnabled());
+		std::cout << "Dynamic resolution " << (m_dynamicResolution.isEnabled() ? "enabled" : "disabled") << std::endl;
+	}
+
+	void Renderer::collectLatencySamples()
+	{
+		// Fences are only polled once per frame, a sample can be late by up to one frame when the CPU is the bottleneck
+		auto now = std::chrono::steady_clock::now();
+		for (size_t slot = 0; slot < m_pendingInputTimes.size(); slot++)
+		{
+			auto& inputTime = m_pendingInputTimes[slot];
+			if (!inputTime || vkGetFenceStatus(m_device.device(), m_swapChain->inFlightFence(slot)) != VK_SUCCESS)
+				continue;
+
+			float latency = std::chrono::duration<float, std::chrono::milliseconds::period>(now - *inputTime).count();
+			m_latency.samples++;
+			m_latency.average += (latency - m_latency.average) / static_cast<float>(m_latency.samples);
+			m_latency.maximum = std::max(m_latency.maximum, latency);
+			inputTime.reset();
+		}
+	}
+
+	void Renderer::retireRenderTarget(std::unique_ptr<RenderTarget> target)
+	{
+		m_retiredResources.push_back({ nullptr, std::move(target), m_submittedFrames });
+	}
+
+	void Renderer::releaseRetiredResources()
+	{
+		// Fences signal in submission order, so once the fence of the last frame which could use the
+		// resources was waited on in acquireNextImage, every earlier frame has finished as well.
+		// That frame's slot comes around again framesInFlight - 1 submissions later.
+		while (!m_retiredResources.empty() &&
+			m_submittedFrames + 1 >= m_retiredResources.front().submittedFrames + m_framesInFlight)
+		{
+			m_retiredResources.pop_front();
+		}
+	}
+
+	void Renderer::blitToSwapChain(VkCommandBuffer commandBuffer)
+	{
+		VkImage swapChainImage = m_swapChain->image(m_currentImageIndex);
+		VkExtent2D outputExtent = m_swapChain->swapChainExtent();
+
+		VkImageMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = swapChainImage;
+		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		barrier.subresourceRange.baseMipLevel = 0;
+		barrier.subresourceRange.levelCount = 1;
+		barrier.subresourceRange.baseArrayLayer = 0;
+		barrier.subresourceRange.layerCount = 1;
+
+		// The acquire semaphore is waited on at the transfer stage
+		barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.srcAccessMask = 0;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		vkCmdPipelineBarrier(
+			commandBuffer,
+			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+			0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+		VkImageBlit blit{};
+		blit.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+		blit.srcOffsets[1] = { static_cast<int32_t>(m_renderExtent.width), static_cast<int32_t>(m_renderExtent.height), 1 };
+		blit.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+		blit.dstOffsets[1] = { static_cast<int32_t>(outputExtent.width), static_cast<int32_t>(outputExtent.height), 1 };
+
+		vkCmdBlitImage(
+			commandBuffer,
+			m_renderTarget->colorImage(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+			swapChainImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			1, &blit,
+			m_blitFilter);
+
+		barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = 0;
+		vkCmdPipelineBarrier(
+			commandBuffer,
+			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+			0, 0, nullptr, 0, nullptr, 1, &barrier);
+	}
+
 	void Renderer::createCommandBuffers()
 	{
-		m_commandBuffers.resize(SwapChain::MAX_FRAMES_IN_FLIGHT);
+		m_commandBuffers.resize(m_framesInFlight);
 
 		VkCommandBufferAllocateInfo allocInfo{};
 		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
@@ -139,20 +366,38 @@ namespace VEGraphics
 			extend = m_window.extend();
 			glfwWaitEvents();
 		}
-		vkDeviceWaitIdle(m_device.device());
 
+		// The GPU is not drained, the old swap chain and render target are kept until the frames in flight
+		// which use them have finished. The sync objects and frame slots are carried over to the new swap chain.
+		std::unique_ptr<RenderTarget> oldRenderTarget = std::move(m_renderTarget);
 		if (m_swapChain == nullptr)
 		{
-			m_swapChain = std::make_unique<SwapChain>(m_device, extend);
+			m_swapChain = std::make_unique<SwapChain>(m_device, extend, m_presentSettings);
 		}
 		else
 		{
 			std::shared_ptr<SwapChain> oldSwapChain = std::move(m_swapChain);
-			m_swapChain = std::make_unique<SwapChain>(m_device, extend, oldSwapChain);
+			m_swapChain = std::make_unique<SwapChain>(m_device, extend, m_presentSettings, oldSwapChain);
 			if (!oldSwapChain->compareSwapFormats(*m_swapChain.get()))
 				throw std::runtime_error("Swap chain image or depth format has changed");
+
+			m_retiredResources.push_back({ std::move(oldSwapChain), std::move(oldRenderTarget), m_submittedFrames });
+		}
+
+		VkFormat colorFormat = m_swapChain->swapChainImageFormat();
+		m_renderTarget = std::make_unique<RenderTarget>(m_device, m_swapChain->swapChainExtent(), colorFormat, m_swapChain->findDepthFormat());
+
+		// Upscaling is filtered if the format supports it
+		VkFormatFeatureFlags features = m_device.formatProperties(colorFormat).optimalTilingFeatures;
+		m_blitSupported = (features & VK_FORMAT_FEATURE_BLIT_SRC_BIT) && (features & VK_FORMAT_FEATURE_BLIT_DST_BIT);
+		if (!m_blitSupported && m_dynamicResolution.isEnabled())
+		{
+			std::cout << "Swap chain format does not support blits, dynamic resolution is disabled" << std::endl;
+			m_dynamicResolution.setEnabled(false);
 		}
 
+		m_blitFilter = (features & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT) ? VK_FILTER_LINEAR : VK_FILTER_NEAREST;
+
 		// Todo
 	}
 
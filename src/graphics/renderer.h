@@ -1,11 +1,20 @@
 #pragma once
 
+#include "graphics/descriptors.h"
 #include "graphics/device.h"
+#include "graphics/dynamic_resolution.h"
+#include "graphics/frame_allocator.h"
+#include "graphics/gpu_timer.h"
+#include "graphics/render_target.h"
 #include "graphics/swap_chain.h"
 #include "graphics/window.h"
+#include "utils/math_utils.h"
 
 #include <cassert>
+#include <chrono>
+#include <deque>
 #include <memory>
+#include <optional>
 #include <vector>
 
 namespace VEGraphics
@@ -13,7 +22,17 @@ namespace VEGraphics
 	class Renderer
 	{
 	public:
-		Renderer(Window& window, VulkanDevice& device);
+		/// @brief Time from sampling the input of a frame until the GPU finished the frame in milliseconds
+		/// @note The image is presented right after, MAILBOX and IMMEDIATE show it with the next refresh or sooner,
+		/// FIFO adds up to one refresh interval per queued image
+		struct LatencyStatistics
+		{
+			float average = 0.0f;
+			float maximum = 0.0f;
+			uint64_t samples = 0;
+		};
+
+		Renderer(Window& window, VulkanDevice& device, const PresentSettings& presentSettings = {});
 		~Renderer();
 
 		Renderer(const Renderer&) = delete;
@@ -34,22 +53,115 @@ namespace VEGraphics
 			return m_currentFrameIndex;
 		}
 
-		VkCommandBuffer beginFrame();
+		/// @brief Number of frames which are recorded ahead, per-frame resources have to be created this many times
+		uint32_t framesInFlight() const { return m_framesInFlight; }
+
+		/// @brief Number of frames submitted so far
+		uint64_t submittedFrames() const { return m_submittedFrames; }
+		VkPresentModeKHR presentMode() const { return m_swapChain->presentMode(); }
+
+		/// @brief Returns the measured input latency of all finished frames
+		const LatencyStatistics& latency() const { return m_latency; }
+
+		/// @brief Returns the per-frame allocator, it is reset in beginFrame
+		FrameAllocator& frameAllocator() { return m_frameAllocator; }
+
+		/// @brief Returns the descriptor allocator of the current frame for transient descriptor sets
+		/// @note All sets of a frame are released at once when the frame index comes around again
+		DescriptorAllocator& frameDescriptorAllocator()
+		{
+			assert(m_isFrameStarted && "Cannot get frame descriptor allocator when frame not in progress");
+			return *m_frameDescriptorAllocators[m_currentFrameIndex];
+		}
+
+		/// @brief Returns the controller of the internal render resolution
+		DynamicResolution& dynamicResolution() { return m_dynamicResolution; }
+		void toggleDynamicResolution();
+
+		/// @brief Returns the extent the scene is rendered at in the current frame
+		VkExtent2D renderExtent() const { return m_renderExtent; }
+
+		/// @brief GPU time of the most recently finished frame in milliseconds, 0 if timestamps are not supported
+		float gpuFrameTime() const { return m_gpuTimer.lastFrameTime(); }
+
+		/// @param inputTime Time the input which drives this frame was polled, used for the latency statistics
+		VkCommandBuffer beginFrame(std::chrono::steady_clock::time_point inputTime = std::chrono::steady_clock::now());
 		void endFrame();
 		void beginSwapChainRenderPass(VkCommandBuffer commandBuffer);
 		void endSwapChainRenderPass(VkCommandBuffer commandBuffer);
 
+		/// @brief Begins the render pass of the scene
+		/// @note With dynamic resolution the scene is rendered offscreen at the render extent,
+		/// otherwise directly into the swap chain render pass
+		void beginScenePass(VkCommandBuffer commandBuffer);
+
+		/// @brief Ends the render pass of the scene and upscales it into the swap chain image if it was rendered offscreen
+		void endScenePass(VkCommandBuffer commandBuffer);
+
+		/// @brief Restricts the following draws of the scene pass to a region of the render extent
+		/// @param region Normalized x, y, width and height
+		void setViewport(VkCommandBuffer commandBuffer, const Vector4& region);
+
+		/// @brief Creates an offscreen target for a view, its render pass is compatible with the scene pipelines
+		std::unique_ptr<RenderTarget> createRenderTarget(VkExtent2D extent);
+
+		/// @brief Keeps a render target until the frames in flight which may use it have finished
+		void retireRenderTarget(std::unique_ptr<RenderTarget> target);
+
+		/// @brief Begins the render pass of an offscreen view, has to be called outside of the scene pass
+		void beginTargetPass(VkCommandBuffer commandBuffer, RenderTarget& target);
+		void endTargetPass(VkCommandBuffer commandBuffer);
+
 	private:
 		void createCommandBuffers();
 		void freeCommandBuffers();
 		void recreateSwapChain();
+		void blitToSwapChain(VkCommandBuffer commandBuffer);
+
+		/// @brief Begins a render pass into the top left extent of a framebuffer and sets the viewport to it
+		void beginRenderPass(VkCommandBuffer commandBuffer, VkRenderPass renderPass, VkFramebuffer framebuffer, VkExtent2D extent);
+
+		/// @brief Records the latency of all submitted frames whose fence is signaled
+		void collectLatencySamples();
+
+		/// @brief Destroys retired swap chains and render targets once no frame in flight can use them anymore
+		void releaseRetiredResources();
 
 		Window& m_window;
 		VulkanDevice& m_device;
+		PresentSettings m_presentSettings;
+		uint32_t m_framesInFlight;
 		std::unique_ptr<SwapChain> m_swapChain;
 		std::vector<VkCommandBuffer> m_commandBuffers;
+		FrameAllocator m_frameAllocator{ m_device, m_framesInFlight };
+		std::vector<std::unique_ptr<DescriptorAllocator>> m_frameDescriptorAllocators;
+
+		std::unique_ptr<RenderTarget> m_renderTarget; // Scene at the dynamic render resolution
+		GpuTimer m_gpuTimer{ m_device, m_framesInFlight };
+		DynamicResolution m_dynamicResolution;
+		VkExtent2D m_renderExtent{};
+		VkFilter m_blitFilter = VK_FILTER_LINEAR;
+		bool m_blitSupported = true;
+		bool m_offscreenFrame = false; // The scene of the current frame is rendered into the render target
+
+		/// @brief Resources replaced by a swap chain recreation or retired which frames in flight may still reference
+		struct RetiredResources
+		{
+			std::shared_ptr<SwapChain> swapChain;
+			std::unique_ptr<RenderTarget> renderTarget;
+			uint64_t submittedFrames; // Frames which were submitted before the resources were retired
+		};
+
+		std::deque<RetiredResources> m_retiredResources;
+		uint64_t m_submittedFrames = 0;
+
+		// Input time of the frame which was last submitted with each sync slot of the swap chain
+		std::vector<std::optional<std::chrono::steady_clock::time_point>> m_pendingInputTimes;
+		std::chrono::steady_clock::time_point m_frameInputTime;
+		LatencyStatistics m_latency;
 
 		uint32_t m_currentImageIndex;
+		uint64_t m_uploadTimelineValue = 0; // Uploads acquired in the current frame
 		int m_currentFrameIndex = 0;
 		bool m_isFrameStarted = false;
 	};
@@ -0,0 +1,174 @@
+#include "shader_watcher.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace VEGraphics
+{
+	namespace
+	{
+		constexpr int WATCH_TIMEOUT_MS = 200; // Interval the stop flag is checked at
+	}
+
+	ShaderWatcher::ShaderWatcher(const std::filesystem::path& shaderDirectory) : m_shaderDirectory{ shaderDirectory }
+	{
+#ifdef __linux__
+		m_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		if (m_inotify < 0)
+			throw std::runtime_error("failed to initialize inotify");
+
+		// Editors either write the file in place or move a temporary file over it
+		if (inotify_add_watch(m_inotify, m_shaderDirectory.string().c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0)
+		{
+			close(m_inotify);
+			throw std::runtime_error("failed to watch shader directory: " + m_shaderDirectory.string());
+		}
+#else
+		for (const auto& entry : std::filesystem::directory_iterator(m_shaderDirectory))
+		{
+			if (isShaderSource(entry.path()))
+				m_writeTimes[entry.path().string()] = entry.last_write_time();
+		}
+#endif
+
+		m_thread = std::thread(&ShaderWatcher::watchLoop, this);
+		std::cout << "Watching shaders in " << m_shaderDirectory.string() << std::endl;
+	}
+
+	ShaderWatcher::~ShaderWatcher()
+	{
+		m_stop = true;
+		m_thread.join();
+
+#ifdef __linux__
+		close(m_inotify);
+#endif
+	}
+
+	std::vector<std::string> ShaderWatcher::poll()
+	{
+		std::lock_guard lock{ m_mutex };
+		return std::exchange(m_rebuilt, {});
+	}
+
+	bool ShaderWatcher::isShaderSource(const std::filesystem::path& path)
+	{
+		static const std::set<std::string> extensions = { ".vert", ".frag", ".comp", ".geom", ".tesc", ".tese" };
+		return extensions.count(path.extension().string()) > 0;
+	}
+
+	void ShaderWatcher::watchLoop()
+	{
+		while (!m_stop)
+		{
+			for (const auto& source : waitForChanges())
+			{
+				if (!compile(source))
+					continue;
+
+				std::lock_guard lock{ m_mutex };
+				m_rebuilt.push_back(source.string() + ".spv");
+			}
+		}
+	}
+
+	std::vector<std::filesystem::path> ShaderWatcher::waitForChanges()
+	{
+		// A save can report several events for the same file, each file is compiled once
+		std::set<std::filesystem::path> changed;
+
+#ifdef __linux__
+		pollfd descriptor{ m_inotify, POLLIN, 0 };
+		if (::poll(&descriptor, 1, WATCH_TIMEOUT_MS) <= 0)
+			return {};
+
+		alignas(inotify_event) char buffer[4096];
+		ssize_t length;
+		while ((length = read(m_inotify, buffer, sizeof(buffer))) > 0)
+		{
+			for (char* pointer = buffer; pointer < buffer + length;)
+			{
+				auto* event = reinterpret_cast<inotify_event*>(pointer);
+				if (event->len > 0)
+				{
+					std::filesystem::path path = m_shaderDirectory / event->name;
+					if (isShaderSource(path))
+						changed.insert(path);
+				}
+				pointer += sizeof(inotify_event) + event->len;
+			}
+		}
+#else
+		std::this_thread::sleep_for(std::chrono::milliseconds(WATCH_TIMEOUT_MS));
+
+		std::error_code error;
+		for (const auto& entry : std::filesystem::directory_iterator(m_shaderDirectory, error))
+		{
+			if (!isShaderSource(entry.path()))
+				continue;
+
+			auto writeTime = entry.last_write_time(error);
+			auto& knownTime = m_writeTimes[entry.path().string()];
+			if (!error && writeTime != knownTime)
+			{
+				knownTime = writeTime;
+				changed.insert(entry.path());
+			}
+		}
+#endif
+
+		return { changed.begin(), changed.end() };
+	}
+
+	bool ShaderWatcher::compile(const std::filesystem::path& source)
+	{
+		// Compiled into a temporary file, so a broken shader does not replace the working SPIR-V
+		std::filesystem::path output = source.string() + ".spv";
+		std::filesystem::path temporary = source.string() + ".spv.tmp";
+		std::filesystem::path log = std::filesystem::temp_directory_path() / "vulkanite_glslc.log";
+
+		std::string command = std::string("\"") + GLSLC_PATH + "\" --target-env=vulkan1.2 \"" + source.string() +
+			"\" -o \"" + temporary.string() + "\" > \"" + log.string() + "\" 2>&1";
+#ifdef _WIN32
+		command = "\"" + command + "\""; // cmd strips the outer quotes
+#endif
+
+		auto beginTime = std::chrono::steady_clock::now();
+		int result = std::system(command.c_str());
+
+		std::error_code error;
+		if (result != 0)
+		{
+			std::stringstream messages;
+			messages << std::ifstream{ log }.rdbuf();
+			std::cout << "Shader compilation failed: " << source.filename().string() << "\n" << messages.str() << std::endl;
+			std::filesystem::remove(temporary, error);
+			return false;
+		}
+
+		std::filesystem::rename(temporary, output, error);
+		if (error)
+		{
+			std::cout << "Failed to replace " << output.string() << ": " << error.message() << std::endl;
+			return false;
+		}
+
+		std::cout << "Compiled " << source.filename().string() << " in "
+			<< std::chrono::duration<float, std::chrono::milliseconds::period>(std::chrono::steady_clock::now() - beginTime).count()
+			<< " ms" << std::endl;
+		return true;
+	}
+
+} // namespace VEGraphics
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "graphics/device.h"
+
+#include <atomic>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Set by CMake to the glslc of the Vulkan SDK
+#ifndef GLSLC_PATH
+#define GLSLC_PATH "glslc"
+#endif
+
+namespace VEGraphics
+{
+	/// @brief Watches the GLSL sources and recompiles changed shaders to SPIR-V in the background
+	/// @note Uses inotify on Linux and polls the modification times on other platforms. Only the changed file
+	/// is compiled, the SPIR-V file is replaced only if the compilation succeeded and errors are printed.
+	class ShaderWatcher
+	{
+	public:
+		ShaderWatcher(const std::filesystem::path& shaderDirectory = SHADER_DIR);
+		~ShaderWatcher();
+
+		ShaderWatcher(const ShaderWatcher&) = delete;
+		ShaderWatcher& operator=(const ShaderWatcher&) = delete;
+
+		/// @brief Returns the paths of the SPIR-V files which were rebuilt since the last call
+		std::vector<std::string> poll();
+
+	private:
+		static bool isShaderSource(const std::filesystem::path& path);
+
+		void watchLoop();
+
+		/// @brief Blocks until shader sources changed or the watcher is stopped
+		std::vector<std::filesystem::path> waitForChanges();
+
+		/// @brief Runs glslc on the source and replaces its SPIR-V file on success
+		bool compile(const std::filesystem::path& source);
+
+		std::filesystem::path m_shaderDirectory;
+
+		std::mutex m_mutex;
+		std::vector<std::string> m_rebuilt;
+
+#ifdef __linux__
+		int m_inotify = -1;
+#else
+		std::unordered_map<std::string, std::filesystem::file_time_type> m_writeTimes;
+#endif
+
+		std::atomic<bool> m_stop = false;
+		std::thread m_thread;
+	};
+
+} // namespace VEGraphics
@@ -1,6 +1,10 @@
 #include "swap_chain.h"
 
+#include "graphics/uploader.h"
+
+#include <algorithm>
 #include <array>
+#include <cassert>
 #include <cstdlib>
 #include <cstring>
 #include <iostream>
@@ -10,15 +14,46 @@
 
 namespace VEGraphics
 {
-	SwapChain::SwapChain(VulkanDevice& deviceRef, VkExtent2D windowExtent)
-		: m_device{ deviceRef }, m_windowExtent{ windowExtent }
+	namespace
+	{
+		const char* presentModeName(VkPresentModeKHR presentMode)
+		{
+			switch (presentMode)
+			{
+			case VK_PRESENT_MODE_IMMEDIATE_KHR: return "Immediate";
+			case VK_PRESENT_MODE_MAILBOX_KHR: return "Mailbox";
+			case VK_PRESENT_MODE_FIFO_KHR: return "V-Sync";
+			case VK_PRESENT_MODE_FIFO_RELAXED_KHR: return "Relaxed V-Sync";
+			default: return "Unknown";
+			}
+		}
+	}
+
+	SwapChain::SwapChain(VulkanDevice& deviceRef, VkExtent2D windowExtent, const PresentSettings& settings)
+		: m_device{ deviceRef }, m_windowExtent{ windowExtent },
+		m_framesInFlight{ std::clamp(settings.framesInFlight, 1u, MAX_FRAMES_IN_FLIGHT) },
+		m_preferredPresentMode{ settings.presentMode }
 	{
 		init();
 	}
 
-	SwapChain::SwapChain(VulkanDevice& deviceRef, VkExtent2D windowExtent, std::shared_ptr<SwapChain> previous)
-		: m_device{ deviceRef }, m_windowExtent{ windowExtent }, m_oldSwapChain{ previous }
+	SwapChain::SwapChain(VulkanDevice& deviceRef, VkExtent2D windowExtent, const PresentSettings& settings, std::shared_ptr<SwapChain> previous)
+		: m_device{ deviceRef }, m_windowExtent{ windowExtent },
+		m_framesInFlight{ std::clamp(settings.framesInFlight, 1u, MAX_FRAMES_IN_FLIGHT) },
+		m_preferredPresentMode{ settings.presentMode },
+		m_oldSwapChain{ previous }
 	{
+		assert(previous->m_framesInFlight == m_framesInFlight && "Frames in flight cannot change with the swap chain");
+
+		// Frames in flight keep using the sync objects, so they are handed over instead of recreated
+		m_imageAvailableSemaphores = std::move(previous->m_imageAvailableSemaphores);
+		m_renderFinishedSemaphores = std::move(previous->m_renderFinishedSemaphores);
+		m_inFlightFences = std::move(previous->m_inFlightFences);
+		m_currentFrame = previous->m_currentFrame;
+		previous->m_imageAvailableSemaphores.clear();
+		previous->m_renderFinishedSemaphores.clear();
+		previous->m_inFlightFences.clear();
+
 		init();
 		m_oldSwapChain = nullptr;
 	}
@@ -52,7 +87,8 @@ namespace VEGraphics
 		vkDestroyRenderPass(m_device.device(), mRenderPass, nullptr);
 
 		// cleanup synchronization objects
-		for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+		// Empty if they were handed over to the next swap chain
+		for (size_t i = 0; i < m_inFlightFences.size(); i++)
 		{
 			vkDestroySemaphore(m_device.device(), m_renderFinishedSemaphores[i], nullptr);
 			vkDestroySemaphore(m_device.device(), m_imageAvailableSemaphores[i], nullptr);
@@ -81,7 +117,7 @@ namespace VEGraphics
 	}
 
 	VkResult SwapChain::submitCommandBuffers(
-		const VkCommandBuffer* buffers, uint32_t* imageIndex)
+		const VkCommandBuffer* buffers, uint32_t* imageIndex, uint64_t uploadTimelineValue)
 	{
 		if (m_imagesInFlight[*imageIndex] != VK_NULL_HANDLE)
 			vkWaitForFences(m_device.device(), 1, &m_imagesInFlight[*imageIndex], VK_TRUE, UINT64_MAX);
@@ -91,12 +127,20 @@ namespace VEGraphics
 		VkSubmitInfo submitInfo = {};
 		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
-		VkSemaphore waitSemaphores[] = { m_imageAvailableSemaphores[m_currentFrame] };
-		VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
-		submitInfo.waitSemaphoreCount = 1;
+		// Uploads acquired in this frame have to be finished on the transfer queue
+		VkSemaphore waitSemaphores[] = { m_imageAvailableSemaphores[m_currentFrame], m_device.uploader().timelineSemaphore() };
+		VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT };
+		uint64_t waitValues[] = { 0, uploadTimelineValue }; // Binary semaphores ignore their value
+		submitInfo.waitSemaphoreCount = uploadTimelineValue > 0 ? 2 : 1;
 		submitInfo.pWaitSemaphores = waitSemaphores;
 		submitInfo.pWaitDstStageMask = waitStages;
 
+		VkTimelineSemaphoreSubmitInfo timelineInfo{};
+		timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+		timelineInfo.waitSemaphoreValueCount = submitInfo.waitSemaphoreCount;
+		timelineInfo.pWaitSemaphoreValues = waitValues;
+		submitInfo.pNext = &timelineInfo;
+
 		submitInfo.commandBufferCount = 1;
 		submitInfo.pCommandBuffers = buffers;
 
@@ -119,7 +163,7 @@ namespace VEGraphics
 
 		auto result = vkQueuePresentKHR(m_device.presentQueue(), &presentInfo);
 
-		m_currentFrame = (m_currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+		m_currentFrame = (m_currentFrame + 1) % m_framesInFlight;
 
 		return result;
 	}
@@ -140,6 +184,7 @@ namespace VEGraphics
 
 		VkSurfaceFormatKHR surfaceFormat = chooseSwapSurfaceFormat(swapChainSupport.formats);
 		VkPresentModeKHR presentMode = chooseSwapPresentMode(swapChainSupport.presentModes);
+		m_presentMode = presentMode;
 		VkExtent2D extent = chooseSwapExtent(swapChainSupport.capabilities);
 
 		uint32_t imageCount = swapChainSupport.capabilities.minImageCount + 1;
@@ -156,7 +201,7 @@ namespace VEGraphics
 		createInfo.imageColorSpace = surfaceFormat.colorSpace;
 		createInfo.imageExtent = extent;
 		createInfo.imageArrayLayers = 1;
-		createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+		createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT; // Scene is copied in with dynamic resolution
 
 		QueueFamilyIndices indices = m_device.findPhysicalQueueFamilies();
 		uint32_t queueFamilyIndices[] = { indices.graphicsFamily, indices.presentFamily };
@@ -214,6 +259,14 @@ namespace VEGraphics
 
 	void SwapChain::createRenderPass()
 	{
+		// Pipelines are compiled in the background against the render pass, so it is kept while the format does not change
+		if (m_oldSwapChain != nullptr && m_oldSwapChain->mSwapChainImageFormat == mSwapChainImageFormat)
+		{
+			mRenderPass = m_oldSwapChain->mRenderPass;
+			m_oldSwapChain->mRenderPass = VK_NULL_HANDLE;
+			return;
+		}
+
 		VkAttachmentDescription depthAttachment{};
 		depthAttachment.format = findDepthFormat();
 		depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
@@ -342,10 +395,14 @@ namespace VEGraphics
 
 	void SwapChain::createSyncObjects()
 	{
-		m_imageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-		m_renderFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-		m_inFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
-		m_imagesInFlight.resize(imageCount(), VK_NULL_HANDLE);
+		// Images are new, no frame has rendered to them yet
+		m_imagesInFlight.assign(imageCount(), VK_NULL_HANDLE);
+		if (!m_inFlightFences.empty())
+			return;
+
+		m_imageAvailableSemaphores.resize(m_framesInFlight);
+		m_renderFinishedSemaphores.resize(m_framesInFlight);
+		m_inFlightFences.resize(m_framesInFlight);
 
 		VkSemaphoreCreateInfo semaphoreInfo = {};
 		semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
@@ -354,7 +411,7 @@ namespace VEGraphics
 		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
 		fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
 
-		for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+		for (size_t i = 0; i < m_framesInFlight; i++)
 		{
 			if (vkCreateSemaphore(m_device.device(), &semaphoreInfo, nullptr, &m_imageAvailableSemaphores[i]) != VK_SUCCESS ||
 				vkCreateSemaphore(m_device.device(), &semaphoreInfo, nullptr, &m_renderFinishedSemaphores[i]) != VK_SUCCESS ||
@@ -381,17 +438,15 @@ namespace VEGraphics
 
 	VkPresentModeKHR SwapChain::chooseSwapPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes)
 	{
-		for (const auto& availablePresentMode : availablePresentModes)
-		{
-			if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR)
-			{
-				std::cout << "Present mode: Mailbox" << std::endl;
-				return availablePresentMode;
-			}
-		}
+		// FIFO is the only mode every surface has to support
+		VkPresentModeKHR presentMode = VK_PRESENT_MODE_FIFO_KHR;
+		if (std::find(availablePresentModes.begin(), availablePresentModes.end(), m_preferredPresentMode) != availablePresentModes.end())
+			presentMode = m_preferredPresentMode;
+		else
+			std::cout << "Present mode " << presentModeName(m_preferredPresentMode) << " is not supported" << std::endl;
 
-		std::cout << "Present mode: V-Sync" << std::endl;
-		return VK_PRESENT_MODE_FIFO_KHR;
+		std::cout << "Present mode: " << presentModeName(presentMode) << ", " << m_framesInFlight << " frames in flight" << std::endl;
+		return presentMode;
 	}
 
 	VkExtent2D SwapChain::chooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities)
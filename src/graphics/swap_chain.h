@@ -10,14 +10,24 @@
 
 namespace VEGraphics
 {
+	/// @brief Trade-off between latency and throughput of the presentation
+	struct PresentSettings
+	{
+		/// @brief Frames the CPU can record ahead of the GPU, fewer frames lower the latency
+		uint32_t framesInFlight = 2;
+
+		/// @brief Preferred present mode, FIFO is used if the surface does not support it
+		/// @note FIFO and FIFO_RELAXED are v-synced, MAILBOX replaces queued images and IMMEDIATE can tear
+		VkPresentModeKHR presentMode = VK_PRESENT_MODE_MAILBOX_KHR;
+	};
 
 	class SwapChain
 	{
 	public:
-		static constexpr int MAX_FRAMES_IN_FLIGHT = 2;
+		static constexpr uint32_t MAX_FRAMES_IN_FLIGHT = 4;
 
-		SwapChain(VulkanDevice& deviceRef, VkExtent2D windowExtent);
-		SwapChain(VulkanDevice& deviceRef, VkExtent2D windowExtent, std::shared_ptr<SwapChain> previous);
+		SwapChain(VulkanDevice& deviceRef, VkExtent2D windowExtent, const PresentSettings& settings);
+		SwapChain(VulkanDevice& deviceRef, VkExtent2D windowExtent, const PresentSettings& settings, std::shared_ptr<SwapChain> previous);
 		~SwapChain();
 
 		SwapChain(const SwapChain&) = delete;
@@ -26,17 +36,29 @@ namespace VEGraphics
 		VkFramebuffer frameBuffer(int index) { return mSwapChainFramebuffers[index]; }
 		VkRenderPass renderPass() { return mRenderPass; }
 		VkImageView imageView(int index) { return mSwapChainImageViews[index]; }
+		VkImage image(int index) { return mSwapChainImages[index]; }
 		size_t imageCount() { return mSwapChainImages.size(); }
 		VkFormat swapChainImageFormat() { return mSwapChainImageFormat; }
 		VkExtent2D swapChainExtent() { return mSwapChainExtent; }
 		uint32_t width() { return mSwapChainExtent.width; }
 		uint32_t height() { return mSwapChainExtent.height; }
 
+		uint32_t framesInFlight() const { return m_framesInFlight; }
+		VkPresentModeKHR presentMode() const { return m_presentMode; }
+
+		/// @brief Slot of the sync objects which is used by the next acquire and submit
+		size_t currentFrame() const { return m_currentFrame; }
+
+		/// @brief Fence which is signaled when the last submission of the frame slot has finished
+		VkFence inFlightFence(size_t frame) const { return m_inFlightFences[frame]; }
+
 		float extentAspectRatio() {	return static_cast<float>(mSwapChainExtent.width) / static_cast<float>(mSwapChainExtent.height); }
 		VkFormat findDepthFormat();
 
 		VkResult acquireNextImage(uint32_t* imageIndex);
-		VkResult submitCommandBuffers(const VkCommandBuffer* buffers, uint32_t* imageIndex);
+		/// @brief Submits the frame command buffer and presents the image
+		/// @param uploadTimelineValue Value of the uploader timeline semaphore the submission waits for, 0 to not wait
+		VkResult submitCommandBuffers(const VkCommandBuffer* buffers, uint32_t* imageIndex, uint64_t uploadTimelineValue = 0);
 
 		bool compareSwapFormats(const SwapChain& swapchain) const 
 		{
@@ -73,6 +95,9 @@ namespace VEGraphics
 
 		VulkanDevice& m_device;
 		VkExtent2D m_windowExtent;
+		uint32_t m_framesInFlight;
+		VkPresentModeKHR m_preferredPresentMode;
+		VkPresentModeKHR m_presentMode = VK_PRESENT_MODE_FIFO_KHR;
 
 		VkSwapchainKHR m_swapChain;
 		std::shared_ptr<SwapChain> m_oldSwapChain;
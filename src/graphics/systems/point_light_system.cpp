@@ -10,6 +10,11 @@
 
 namespace VEGraphics
 {
+	namespace
+	{
+		constexpr const char* PIPELINE_NAME = "point_light";
+	}
+
 	struct PointLightPushConstants
 	{
 		Vector4 position{};
@@ -17,22 +22,38 @@ namespace VEGraphics
 		float radius;
 	};
 
-	PointLightSystem::PointLightSystem(VulkanDevice& device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout) 
-		: m_device{ device }
+	PointLightSystem::PointLightSystem(VulkanDevice& device, PipelineLibrary& pipelineLibrary, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout) 
+		: m_device{ device }, m_pipelineLibrary{ pipelineLibrary }
 	{
 		createPipelineLayout(globalSetLayout);
 		createPipeline(renderPass);
+
+		m_renderState.pipelineLayout = mPipelineLayout;
+		m_renderState.pushConstantStages = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+		m_renderState.bindDescriptors = [this](VkCommandBuffer commandBuffer)
+		{
+			vkCmdBindDescriptorSets(
+				commandBuffer,
+				VK_PIPELINE_BIND_POINT_GRAPHICS,
+				mPipelineLayout,
+				0, 1,
+				&m_globalDescriptorSet,
+				0, nullptr
+			);
+		};
 	}
 
 	PointLightSystem::~PointLightSystem()
 	{
+		mPipeline.waitForCompilation();
+		m_pipelineLibrary.release(PIPELINE_NAME);
 		vkDestroyPipelineLayout(m_device.device(), mPipelineLayout, nullptr);
 	}
 
 	void PointLightSystem::update(FrameInfo& frameInfo, GlobalUbo& ubo)
 	{
 		int lighIndex = 0;
-		for (auto&& [entity, transform, pointLight] : frameInfo.scene->viewEntitiesByType<VEComponent::Transform, VEComponent::PointLight>().each())
+		for (auto&& [entity, transform, pointLight] : frameInfo.scene->viewEntitiesByType<VEComponent::Transform, VEComponent::PointLight>(entt::exclude<VEComponent::Suspended>).each())
 		{
 			assert(lighIndex < MAX_LIGHTS && "Point lights exceed maximum number of point lights");
 			ubo.pointLights[lighIndex].position = Vector4(transform.location, 1.0f);
@@ -42,37 +63,26 @@ namespace VEGraphics
 		ubo.numLights = lighIndex;
 	}
 
-	void PointLightSystem::render(FrameInfo& frameInfo)
+	void PointLightSystem::submit(FrameInfo& frameInfo)
 	{
-		mPipeline->bind(frameInfo.commandBuffer);
-
-		vkCmdBindDescriptorSets(
-			frameInfo.commandBuffer,
-			VK_PIPELINE_BIND_POINT_GRAPHICS,
-			mPipelineLayout,
-			0, 1,
-			&frameInfo.globalDescriptorSet,
-			0, nullptr
-		);
-
-		auto view = frameInfo.scene->viewEntitiesByType<VEComponent::Transform, VEComponent::PointLight>();
-		view.use<VEComponent::Transform>(); // Sort because of Transparency
-		for (auto&& [entity, transform, pointLight] : view.each())
+		m_renderState.pipeline = mPipeline.get();
+		if (!m_renderState.pipeline)
+			return;
+
+		m_globalDescriptorSet = frameInfo.globalDescriptorSet;
+
+		// The transparent pass of the queue draws the billboards back to front
+		Vector3 cameraPosition = frameInfo.camera->position();
+		RenderQueue::DepthRange depthRange{ frameInfo.camera->nearPlane(), frameInfo.camera->farPlane() };
+		for (auto&& [entity, transform, pointLight] : frameInfo.scene->viewEntitiesByType<VEComponent::Transform, VEComponent::PointLight>(entt::exclude<VEComponent::Suspended>).each())
 		{
 			PointLightPushConstants push{};
 			push.position = Vector4(transform.location, 1.0f);
 			push.color = Vector4(pointLight.color.rgb(), 1.0f);
 			push.radius = transform.scale.x;
 
-			vkCmdPushConstants(
-				frameInfo.commandBuffer,
-				mPipelineLayout,
-				VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
-				0,
-				sizeof(PointLightPushConstants),
-				&push);
-
-			vkCmdDraw(frameInfo.commandBuffer, 6, 1, 0, 0);
+			uint64_t sortKey = RenderQueue::transparentSortKey(m_renderState.id(), glm::distance(cameraPosition, transform.location), depthRange);
+			frameInfo.renderQueue->submit(sortKey, m_renderState, 6, push);
 		}
 	}
 
@@ -100,22 +110,20 @@ namespace VEGraphics
 	{
 		assert(mPipelineLayout != nullptr && "Cannot create pipeline before pipeline layout");
 
-		PipelineConfigInfo pipelineConfig{};
-		Pipeline::defaultPipelineConfigInfo(pipelineConfig);
-		Pipeline::enableAlphaBlending(pipelineConfig);
-		pipelineConfig.bindingDescriptions.clear();
-		pipelineConfig.attributeDescriptions.clear();
-		pipelineConfig.renderPass = renderPass;
-		pipelineConfig.pipelineLayout = mPipelineLayout;
-
-		std::string vertShaderPath = SHADER_DIR "point_light.vert.spv";
-		std::string fragShaderPath = SHADER_DIR "point_light.frag.spv";
-
-		mPipeline = std::make_unique<Pipeline>(
-			m_device,
-			vertShaderPath,
-			fragShaderPath,
-			pipelineConfig);
+		VkPipelineLayout pipelineLayout = mPipelineLayout;
+		mPipeline = m_pipelineLibrary.request(
+			PIPELINE_NAME,
+			SHADER_DIR "point_light.vert.spv",
+			SHADER_DIR "point_light.frag.spv",
+			[renderPass, pipelineLayout](PipelineConfigInfo& pipelineConfig)
+			{
+				Pipeline::defaultPipelineConfigInfo(pipelineConfig);
+				Pipeline::enableAlphaBlending(pipelineConfig);
+				pipelineConfig.bindingDescriptions.clear();
+				pipelineConfig.attributeDescriptions.clear();
+				pipelineConfig.renderPass = renderPass;
+				pipelineConfig.pipelineLayout = pipelineLayout;
+			});
 	}
 
 } // namespace VEGraphics
@@ -3,6 +3,8 @@
 #include "graphics/device.h"
 #include "graphics/frame_info.h"
 #include "graphics/pipeline.h"
+#include "graphics/pipeline_library.h"
+#include "graphics/render_queue.h"
 
 #include <memory>
 #include <vector>
@@ -12,23 +14,30 @@ namespace VEGraphics
 	class PointLightSystem
 	{
 	public:
-		PointLightSystem(VulkanDevice& device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout);
+		/// @note The pipeline is compiled in the background, lights are not drawn until it is ready
+		PointLightSystem(VulkanDevice& device, PipelineLibrary& pipelineLibrary, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout);
 		~PointLightSystem();
 
 		PointLightSystem(const PointLightSystem&) = delete;
 		PointLightSystem& operator=(const PointLightSystem&) = delete;
 
 		void update(FrameInfo& frameInfo, GlobalUbo& ubo);
-		void render(FrameInfo& frameInfo);
+
+		/// @brief Adds a billboard for every light to the transparent pass of the render queue
+		void submit(FrameInfo& frameInfo);
 
 	private:
 		void createPipelineLayout(VkDescriptorSetLayout globalSetLayout);
 		void createPipeline(VkRenderPass renderPass);
 
 		VulkanDevice& m_device;
+		PipelineLibrary& m_pipelineLibrary; // Outlives the system, the pipeline is released on destruction
 
-		std::unique_ptr<Pipeline> mPipeline;
+		PipelineHandle mPipeline;
 		VkPipelineLayout mPipelineLayout;
+
+		RenderState m_renderState;
+		VkDescriptorSet m_globalDescriptorSet = VK_NULL_HANDLE; // Bound by the render queue, set in submit
 	};
 
 } // namespace VEGraphics
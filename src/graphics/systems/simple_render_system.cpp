@@ -5,72 +5,241 @@
 #include "utils/math_utils.h"
 
 #include <array>
+#include <functional>
 #include <stdexcept>
 #include <iostream>
+#include <string>
 
 namespace VEGraphics
 {
 	struct SimplePushConstantData
 	{	// max 128 bytes
 		Matrix4 modelMatrix{1.0f};
-		Matrix4 normalMatrix{1.0f};
+		glm::mat3x4 normalMatrix{1.0f}; // mat3 with std430 column padding
+		uint32_t materialIndex = 0;     // Index into the material storage buffer
 	};
 
-	SimpleRenderSystem::SimpleRenderSystem(VulkanDevice& device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout) : m_device{device}
+	SimpleRenderSystem::SimpleRenderSystem(
+		VulkanDevice& device,
+		PipelineLibrary& pipelineLibrary,
+		VkRenderPass renderPass,
+		VkDescriptorSetLayout globalSetLayout,
+		VkDescriptorSetLayout frameSetLayout,
+		BindlessTextures& textures) 
+		: m_device{device}, m_textures{textures}
 	{
-		createPipelineLayout(globalSetLayout);
-		createPipeline(renderPass);
+		createPipelineLayout(globalSetLayout, frameSetLayout);
+		createPipelines(pipelineLibrary, renderPass);
+
+		m_renderState.pipeline = &mPipeline.wait();
+		m_renderState.pipelineLayout = mPipelineLayout;
+		m_renderState.pushConstantStages = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+		m_renderState.bindDescriptors = [this](VkCommandBuffer commandBuffer) { bindDescriptors(commandBuffer); };
+
+		m_depthPrepassState.pipelineLayout = mPipelineLayout;
+		m_depthPrepassState.pushConstantStages = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+		m_depthPrepassState.positionsOnly = true;
+		m_depthPrepassState.bindDescriptors = [this](VkCommandBuffer commandBuffer)
+		{
+			vkCmdBindDescriptorSets(
+				commandBuffer,
+				VK_PIPELINE_BIND_POINT_GRAPHICS,
+				mPipelineLayout,
+				0, 1,
+				&m_globalDescriptorSet,
+				0, nullptr
+			);
+		};
 	}
 
 	SimpleRenderSystem::~SimpleRenderSystem()
 	{
+		// Waits for variants which are still compiling with the pipeline layout
+		m_shadingVariants.reset();
+		m_depthEqualVariants.reset();
+		m_depthPrepassVariants.reset();
 		vkDestroyPipelineLayout(m_device.device(), mPipelineLayout, nullptr);
 	}
 
-	void SimpleRenderSystem::renderGameObjects(FrameInfo& frameInfo)
+	void SimpleRenderSystem::setDepthPrepass(bool enabled)
+	{
+		m_depthPrepass = enabled;
+		std::cout << "Depth pre-pass " << (enabled ? "enabled" : "disabled") << std::endl;
+	}
+
+	size_t SimpleRenderSystem::MaterialHash::operator()(const MaterialData& material) const
+	{
+		size_t hash = std::hash<uint32_t>{}(material.albedoIndex);
+		for (float value : { material.baseColor.r, material.baseColor.g, material.baseColor.b, material.baseColor.a, material.shininess })
+		{
+			hash ^= std::hash<float>{}(value) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+		}
+		return hash;
+	}
+
+	void SimpleRenderSystem::prepare(FrameInfo& frameInfo)
+	{
+		m_materials.clear();
+		m_materialIndices.clear();
+		m_instances.clear();
+
+		// The variants unroll the light loop up to the bucket of the current light count
+		uint32_t lightCount = 0;
+		for ([[maybe_unused]] auto light : frameInfo.scene->viewEntitiesByType<VEComponent::Transform, VEComponent::PointLight>(entt::exclude<VEComponent::Suspended>))
+		{
+			lightCount++;
+		}
+		uint32_t lightCountBucket = PipelineVariantKey::lightCountBucket(lightCount);
+
+		m_depthPrepassState.pipeline = m_depthPrepassPipeline.get();
+		bool depthPrepassReady = m_depthPrepass && m_depthPrepassState.pipeline;
+
+		// The matrices are rebuilt by the scene only for entities whose transform changed
+		for (auto&& [entity, worldTransform, mesh] : frameInfo.scene->viewEntitiesByType<VEComponent::WorldTransform, VEComponent::Mesh>(entt::exclude<VEComponent::Suspended>).each())
+		{
+			// Models which are still loading are skipped
+			if (!mesh.model || !mesh.model->isReady())
+				continue;
+
+			MaterialData material{};
+			if (auto* component = frameInfo.scene->tryGetComponent<VEComponent::Material>(entity))
+			{
+				material.baseColor = component->baseColor.rgba();
+				material.albedoIndex = m_textures.textureIndex(component->albedoTexture);
+				material.shininess = component->shininess;
+			}
+			else
+			{
+				material.baseColor = mesh.color.rgba();
+			}
+
+			PipelineVariantKey variantKey{};
+			variantKey.lightCount = lightCountBucket;
+			variantKey.specular = material.shininess > 0.0f;
+
+			// While its variant compiles a mesh is shaded by the generic pipeline without the pre-pass
+			bool depthPrepass = depthPrepassReady;
+			RenderState* state = variantState(variantKey, depthPrepass);
+			if (!state && depthPrepass)
+			{
+				depthPrepass = false;
+				state = variantState(variantKey, false);
+			}
+			if (!state)
+				state = &m_renderState;
+
+			// Meshes share the entry of an equal material, so the storage range bounds the distinct materials, not the meshes
+			auto [materialIndex, inserted] = m_materialIndices.try_emplace(material, static_cast<uint32_t>(m_materials.size()));
+			if (inserted)
+				m_materials.push_back(material);
+
+			m_instances.push_back({
+				mesh.model.get(),
+				state,
+				depthPrepass,
+				materialIndex->second,
+				material.albedoIndex,
+				worldTransform.modelMatrix,
+				worldTransform.normalMatrix });
+		}
+
+		if (m_materials.empty())
+			return;
+
+		// The shader indexes the bound range, materials past it would be read out of bounds
+		if (m_materials.size() * sizeof(MaterialData) > frameInfo.frameAllocator->storageRange())
+			throw std::runtime_error("Too many distinct materials in one frame (" + std::to_string(m_materials.size()) + ")");
+
+		// Uploaded once, all views bind the same materials
+		m_frameAllocator = frameInfo.frameAllocator;
+		m_materialAllocation = frameInfo.frameAllocator->pushStorage(m_materials);
+	}
+
+	void SimpleRenderSystem::submit(FrameInfo& frameInfo)
 	{
-		mPipeline->bind(frameInfo.commandBuffer);
+		m_globalDescriptorSet = frameInfo.globalDescriptorSet;
 
+		// Only the sort keys depend on the view
+		Vector3 cameraPosition = frameInfo.camera->position();
+		RenderQueue::DepthRange depthRange{ frameInfo.camera->nearPlane(), frameInfo.camera->farPlane() };
+		for (const Instance& instance : m_instances)
+		{
+			SimplePushConstantData push{};
+			push.modelMatrix = instance.modelMatrix;
+			push.normalMatrix = glm::mat3x4(instance.normalMatrix);
+			push.materialIndex = instance.materialIndex;
+
+			float distance = glm::distance(cameraPosition, Vector3(instance.modelMatrix[3]));
+			uint64_t sortKey = RenderQueue::opaqueSortKey(
+				instance.state->id(),
+				instance.albedoIndex,
+				instance.model->id(),
+				distance,
+				depthRange,
+				!instance.depthPrepass);
+
+			frameInfo.renderQueue->submit(sortKey, *instance.state, instance.model, push);
+
+			if (instance.depthPrepass)
+			{
+				uint64_t prepassKey = RenderQueue::depthPrepassSortKey(m_depthPrepassState.id(), instance.model->id(), distance, depthRange);
+				frameInfo.renderQueue->submit(prepassKey, m_depthPrepassState, instance.model, push);
+			}
+		}
+	}
+
+	RenderState* SimpleRenderSystem::variantState(const PipelineVariantKey& key, bool depthEqual)
+	{
+		auto [it, inserted] = m_variantStates.try_emplace(key.value() | (depthEqual ? DEPTH_EQUAL_BIT : 0u));
+		VariantState& variant = it->second;
+		if (inserted)
+		{
+			variant.pipeline = (depthEqual ? m_depthEqualVariants : m_shadingVariants)->variant(key);
+			variant.state.pipelineLayout = mPipelineLayout;
+			variant.state.pushConstantStages = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+			variant.state.bindDescriptors = [this](VkCommandBuffer commandBuffer) { bindDescriptors(commandBuffer); };
+		}
+
+		// Once compiled the pipeline does not change, so the handle is only polled until then
+		if (!variant.state.pipeline)
+			variant.state.pipeline = variant.pipeline.get();
+
+		return variant.state.pipeline ? &variant.state : nullptr;
+	}
+
+	void SimpleRenderSystem::bindDescriptors(VkCommandBuffer commandBuffer)
+	{
+		// Global data, materials of the frame and all textures are bound once for every draw
 		vkCmdBindDescriptorSets(
-			frameInfo.commandBuffer,
+			commandBuffer,
 			VK_PIPELINE_BIND_POINT_GRAPHICS,
 			mPipelineLayout,
 			0, 1,
-			&frameInfo.globalDescriptorSet,
+			&m_globalDescriptorSet,
 			0, nullptr
 		);
 
-		for (auto&& [entity, transform, mesh] : frameInfo.scene->viewEntitiesByType<VEComponent::Transform, VEComponent::Mesh>().each())
-		{
-			// TODO: transfer color as uniform
-			Matrix4 colorNormalMatrix = MathLib::normalMatrix(transform.rotation, transform.scale);
-			colorNormalMatrix[3] = mesh.color.rgba();
+		m_frameAllocator->bind(commandBuffer, mPipelineLayout, 1, {}, m_materialAllocation);
 
-			SimplePushConstantData push{};
-			push.modelMatrix = MathLib::tranformationMatrix(transform.location, transform.rotation, transform.scale);
-			push.normalMatrix = colorNormalMatrix;
-
-			vkCmdPushConstants(
-				frameInfo.commandBuffer,
-				mPipelineLayout,
-				VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
-				0,
-				sizeof(SimplePushConstantData),
-				&push);
-			
-			mesh.model->bind(frameInfo.commandBuffer);
-			mesh.model->draw(frameInfo.commandBuffer);
-		}
+		VkDescriptorSet textureSet = m_textures.descriptorSet();
+		vkCmdBindDescriptorSets(
+			commandBuffer,
+			VK_PIPELINE_BIND_POINT_GRAPHICS,
+			mPipelineLayout,
+			2, 1,
+			&textureSet,
+			0, nullptr
+		);
 	}
 
-	void SimpleRenderSystem::createPipelineLayout(VkDescriptorSetLayout globalSetLayout)
+	void SimpleRenderSystem::createPipelineLayout(VkDescriptorSetLayout globalSetLayout, VkDescriptorSetLayout frameSetLayout)
 	{
 		VkPushConstantRange pushConstantRange{};
 		pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
 		pushConstantRange.offset = 0;
 		pushConstantRange.size = sizeof(SimplePushConstantData);
 
-		std::vector<VkDescriptorSetLayout> descriptorSetLayouts{globalSetLayout};
+		std::vector<VkDescriptorSetLayout> descriptorSetLayouts{globalSetLayout, frameSetLayout, m_textures.descriptorSetLayout()};
 
 		VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
 		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
@@ -83,23 +252,60 @@ namespace VEGraphics
 			throw std::runtime_error("failed to create pipeline layout");
 	}
 
-	void SimpleRenderSystem::createPipeline(VkRenderPass renderPass)
+	void SimpleRenderSystem::createPipelines(PipelineLibrary& pipelineLibrary, VkRenderPass renderPass)
 	{
 		assert(mPipelineLayout != nullptr && "Cannot create pipeline before pipeline layout");
 
-		PipelineConfigInfo pipelineConfig{};
-		Pipeline::defaultPipelineConfigInfo(pipelineConfig);
-		pipelineConfig.renderPass = renderPass;
-		pipelineConfig.pipelineLayout = mPipelineLayout;
-
 		std::string vertShaderPath = SHADER_DIR "simple_shader.vert.spv";
 		std::string fragShaderPath = SHADER_DIR "simple_shader.frag.spv";
+		VkPipelineLayout pipelineLayout = mPipelineLayout;
+
+		m_shadingVariants = std::make_unique<PipelineVariants>(
+			pipelineLibrary,
+			"simple",
+			vertShaderPath,
+			fragShaderPath,
+			[renderPass, pipelineLayout](PipelineConfigInfo& pipelineConfig)
+			{
+				Pipeline::defaultPipelineConfigInfo(pipelineConfig);
+				pipelineConfig.renderPass = renderPass;
+				pipelineConfig.pipelineLayout = pipelineLayout;
+			});
 
-		mPipeline = std::make_unique<Pipeline>(
-			m_device,
+		m_depthEqualVariants = std::make_unique<PipelineVariants>(
+			pipelineLibrary,
+			"simple_depth_equal",
 			vertShaderPath,
 			fragShaderPath,
-			pipelineConfig);
+			[renderPass, pipelineLayout](PipelineConfigInfo& pipelineConfig)
+			{
+				Pipeline::defaultPipelineConfigInfo(pipelineConfig);
+				Pipeline::enableDepthEqual(pipelineConfig);
+				pipelineConfig.renderPass = renderPass;
+				pipelineConfig.pipelineLayout = pipelineLayout;
+			});
+
+		m_depthPrepassVariants = std::make_unique<PipelineVariants>(
+			pipelineLibrary,
+			"depth_prepass",
+			SHADER_DIR "depth_prepass.vert.spv",
+			"",
+			[renderPass, pipelineLayout](PipelineConfigInfo& pipelineConfig)
+			{
+				Pipeline::defaultPipelineConfigInfo(pipelineConfig);
+				Pipeline::enableDepthPrepass(pipelineConfig);
+				pipelineConfig.renderPass = renderPass;
+				pipelineConfig.pipelineLayout = pipelineLayout;
+			});
+
+		// The default key loops over the light count of the frame, so it can shade every mesh
+		mPipeline = m_shadingVariants->variant(PipelineVariantKey{});
+
+		PipelineVariantKey prepassKey{};
+		prepassKey.lightCount = 0;
+		prepassKey.specular = false;
+		prepassKey.vertexFormat = PipelineVariantKey::VertexFormat::PositionOnly;
+		m_depthPrepassPipeline = m_depthPrepassVariants->variant(prepassKey);
 	}
 
 } // namespace VEGraphics
@@ -1,10 +1,15 @@
 #pragma once
 
+#include "graphics/bindless_textures.h"
 #include "graphics/device.h"
 #include "graphics/frame_info.h"
 #include "graphics/pipeline.h"
+#include "graphics/pipeline_library.h"
+#include "graphics/pipeline_variants.h"
+#include "graphics/render_queue.h"
 
 #include <memory>
+#include <unordered_map>
 #include <vector>
 
 namespace VEGraphics
@@ -12,21 +17,106 @@ namespace VEGraphics
 	class SimpleRenderSystem
 	{
 	public:
-		SimpleRenderSystem(VulkanDevice& device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout);
+		/// @param frameSetLayout Layout of the frame allocator, its storage buffer holds the materials of the frame
+		/// @note Waits for the generic pipeline, the depth pre-pass pipelines are compiled in the background
+		SimpleRenderSystem(
+			VulkanDevice& device,
+			PipelineLibrary& pipelineLibrary,
+			VkRenderPass renderPass,
+			VkDescriptorSetLayout globalSetLayout,
+			VkDescriptorSetLayout frameSetLayout,
+			BindlessTextures& textures);
 		~SimpleRenderSystem();
 
 		SimpleRenderSystem(const SimpleRenderSystem&) = delete;
 		SimpleRenderSystem& operator=(const SimpleRenderSystem&) = delete;
 
-		void renderGameObjects(FrameInfo& frameInfo);
+		/// @brief Gathers the meshes of the frame and uploads their materials, called once before the views are submitted
+		void prepare(FrameInfo& frameInfo);
+
+		/// @brief Adds a draw for every prepared mesh to the render queue of the view
+		/// @note With the depth pre-pass every mesh is also drawn depth-only before it is shaded.
+		/// The queue has to be executed before the next view is submitted.
+		void submit(FrameInfo& frameInfo);
+
+		/// @brief Enables the depth-only pre-pass followed by shading with an EQUAL depth test
+		/// @note Meshes are drawn with the generic pipeline until the pre-pass pipelines are compiled
+		void setDepthPrepass(bool enabled);
+		void toggleDepthPrepass() { setDepthPrepass(!m_depthPrepass); }
+		bool depthPrepassEnabled() const { return m_depthPrepass; }
 
 	private:
-		void createPipelineLayout(VkDescriptorSetLayout globalSetLayout);
-		void createPipeline(VkRenderPass renderPass);
+		/// @brief Material in the storage buffer, matches Material in simple_shader.frag (std430)
+		/// @note Instances with equal materials share one entry
+		struct MaterialData
+		{
+			Vector4 baseColor{ 1.0f };
+			uint32_t albedoIndex = BindlessTextures::PLACEHOLDER_INDEX;
+			float shininess = 32.0f;
+			float padding[2]{};
+
+			bool operator==(const MaterialData& other) const
+			{
+				return baseColor == other.baseColor && albedoIndex == other.albedoIndex && shininess == other.shininess;
+			}
+		};
+
+		struct MaterialHash
+		{
+			size_t operator()(const MaterialData& material) const;
+		};
+
+		/// @brief Mesh of the frame, gathered once and submitted to every view
+		struct Instance
+		{
+			Model* model;
+			RenderState* state;
+			bool depthPrepass;
+			uint32_t materialIndex;
+			uint32_t albedoIndex;
+			Matrix4 modelMatrix;
+			Matrix3 normalMatrix;
+		};
+
+		/// @brief Render state of a pipeline variant, its pipeline is set once it is compiled
+		struct VariantState
+		{
+			PipelineHandle pipeline;
+			RenderState state;
+		};
+
+		static constexpr uint32_t DEPTH_EQUAL_BIT = 1u << 16; // Marks depth-equal variants in the state map
+
+		void createPipelineLayout(VkDescriptorSetLayout globalSetLayout, VkDescriptorSetLayout frameSetLayout);
+		void createPipelines(PipelineLibrary& pipelineLibrary, VkRenderPass renderPass);
+		void bindDescriptors(VkCommandBuffer commandBuffer);
+
+		/// @brief Returns the render state of the variant or nullptr while it is compiling
+		/// @param depthEqual Variant for shading after the depth pre-pass
+		RenderState* variantState(const PipelineVariantKey& key, bool depthEqual);
 
 		VulkanDevice& m_device;
+		BindlessTextures& m_textures;
+		RenderState m_renderState; // Generic pipeline, used while the variant of a mesh compiles
+		RenderState m_depthPrepassState;
+		std::unordered_map<uint32_t, VariantState> m_variantStates;
+		bool m_depthPrepass = false;
+
+		// Bound by the render queue, the global set is set per view in submit, the materials in prepare
+		VkDescriptorSet m_globalDescriptorSet = VK_NULL_HANDLE;
+		FrameAllocator* m_frameAllocator = nullptr;
+		FrameAllocator::Allocation m_materialAllocation{};
+
+		// Reused every frame to avoid allocations
+		std::vector<MaterialData> m_materials;
+		std::unordered_map<MaterialData, uint32_t, MaterialHash> m_materialIndices;
+		std::vector<Instance> m_instances;
 
-		std::unique_ptr<Pipeline> mPipeline;
+		std::unique_ptr<PipelineVariants> m_shadingVariants;
+		std::unique_ptr<PipelineVariants> m_depthEqualVariants; // Shading after the depth pre-pass
+		std::unique_ptr<PipelineVariants> m_depthPrepassVariants;
+		PipelineHandle mPipeline; // Generic variant, always ready
+		PipelineHandle m_depthPrepassPipeline;
 		VkPipelineLayout mPipelineLayout;
 	};
 
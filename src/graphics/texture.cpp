@@ -1,32 +1,101 @@
 #include "texture.h"
 
 #include "graphics/buffer.h"
+#include "graphics/ktx2.h"
+#include "graphics/uploader.h"
 
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <fstream>
 #include <stdexcept>
 
 namespace VEGraphics
 {
+	namespace
+	{
+		void recordImageBarrier(
+			VkCommandBuffer commandBuffer,
+			VkImage image,
+			VkImageLayout oldLayout,
+			VkImageLayout newLayout,
+			VkAccessFlags srcAccessMask,
+			VkAccessFlags dstAccessMask,
+			VkPipelineStageFlags srcStage,
+			VkPipelineStageFlags dstStage,
+			uint32_t baseMipLevel,
+			uint32_t levelCount)
+		{
+			VkImageMemoryBarrier barrier{};
+			barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			barrier.oldLayout = oldLayout;
+			barrier.newLayout = newLayout;
+			barrier.srcAccessMask = srcAccessMask;
+			barrier.dstAccessMask = dstAccessMask;
+			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.image = image;
+			barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			barrier.subresourceRange.baseMipLevel = baseMipLevel;
+			barrier.subresourceRange.levelCount = levelCount;
+			barrier.subresourceRange.baseArrayLayer = 0;
+			barrier.subresourceRange.layerCount = 1;
+
+			vkCmdPipelineBarrier(commandBuffer, srcStage, dstStage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+		}
+	}
+
 	Texture::Texture(VulkanDevice& device, const Texture::CreateInfo& createInfo)
 		: m_device{ device }
 	{
-		loadTexture(createInfo.textureFilePath);
-		createImageView();
-		createTextureSampler();
+		Builder builder{};
+		builder.loadTexture(createInfo.textureFilePath);
+
+		upload(builder);
+		m_device.uploader().flush();
+	}
+
+	Texture::Texture(VulkanDevice& device, const Texture::Builder& builder)
+		: m_device{ device }
+	{
+		upload(builder);
+		m_device.uploader().flush();
+	}
+
+	Texture::Texture(VulkanDevice& device)
+		: m_device{ device }
+	{
 	}
 
 	Texture::~Texture()
 	{
+		// The image is still used by the transfer queue
+		if (m_uploadPending)
+			m_device.uploader().flush();
+
 		vkDestroySampler(m_device.device(), m_textureSampler, nullptr);
 		vkDestroyImageView(m_device.device(), m_textureImageView, nullptr);
 		vkDestroyImage(m_device.device(), m_textureImage, nullptr);
 		vkFreeMemory(m_device.device(), m_textureImageMemory, nullptr);
 	}
 
-	VkDescriptorImageInfo Texture::descriptorImageInfo()
+	void Texture::upload(const Texture::Builder& builder)
+	{
+		assert(!m_ready && !m_uploadPending && "Texture is already uploaded");
+
+		createTextureImage(builder);
+		createImageView();
+		createTextureSampler();
+	}
+
+	VkDescriptorImageInfo Texture::descriptorImageInfo() const
 	{
+		assert(m_ready && "Cannot sample a texture before it is uploaded");
+
 		VkDescriptorImageInfo info{};
 		info.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 		info.imageView = m_textureImageView;
@@ -34,36 +103,43 @@ namespace VEGraphics
 		return info;
 	}
 
-	void Texture::loadTexture(const std::string& filePath)
+	void Texture::createTextureImage(const Texture::Builder& builder)
 	{
-		int texWidth, texHeight, texChannels;
-		stbi_uc* pixels = stbi_load(filePath.c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
-		VkDeviceSize imageSize = static_cast<uint64_t>(texWidth) * static_cast<uint64_t>(texHeight) * 4;
+		assert(builder.storedLevels() > 0 && "Texture builder contains no image data");
+		assert(builder.storedLevels() == (builder.generateMipmaps ? 1 : builder.mipLevels) && "Stored levels do not match mip levels");
 
-		if (!pixels)
-			throw std::runtime_error("Failed to load texture image");
+		m_format = builder.format;
+		m_mipLevels = builder.mipLevels;
+
+		if (blockCompressedBlockSize(m_format) > 0 && !m_device.features.textureCompressionBC)
+			throw std::runtime_error("Block compressed textures are not supported by the device");
+
+		if (builder.generateMipmaps)
+		{
+			auto formatProperties = m_device.formatProperties(m_format);
+			if (!(formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT))
+				throw std::runtime_error("Texture image format does not support linear blitting for mipmap generation");
+		}
 
-		Buffer stagingBuffer{
+		auto stagingBuffer = std::make_unique<Buffer>(
 			m_device,
-			imageSize,
+			builder.data.size(),
 			1,
 			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT };
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
 
-		stagingBuffer.map();
-		stagingBuffer.writeToBuffer((void*)pixels);
-
-		stbi_image_free(pixels);
+		stagingBuffer->map();
+		stagingBuffer->writeToBuffer((void*)builder.data.data());
 
 		VkImageCreateInfo imageInfo{};
 		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
 		imageInfo.imageType = VK_IMAGE_TYPE_2D;
-		imageInfo.extent.width = static_cast<uint32_t>(texWidth);
-		imageInfo.extent.height = static_cast<uint32_t>(texHeight);
+		imageInfo.extent.width = builder.width;
+		imageInfo.extent.height = builder.height;
 		imageInfo.extent.depth = 1;
-		imageInfo.mipLevels = 1;
+		imageInfo.mipLevels = m_mipLevels;
 		imageInfo.arrayLayers = 1;
-		imageInfo.format = VK_FORMAT_R8G8B8A8_SRGB;
+		imageInfo.format = m_format;
 		imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
 		imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 		imageInfo.usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
@@ -71,9 +147,127 @@ namespace VEGraphics
 		imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
 
 		m_device.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, m_textureImage, m_textureImageMemory);
-		m_device.transitionImageLayout(m_textureImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1);
-		m_device.copyBufferToImage(stagingBuffer.buffer(), m_textureImage, imageInfo.extent.width, imageInfo.extent.height, 1);
-		m_device.transitionImageLayout(m_textureImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, 1);
+
+		std::vector<VkBufferImageCopy> regions(builder.storedLevels());
+		for (uint32_t level = 0; level < builder.storedLevels(); level++)
+		{
+			auto& region = regions[level];
+			region.bufferOffset = builder.levelOffsets[level];
+			region.bufferRowLength = 0;
+			region.bufferImageHeight = 0;
+			region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			region.imageSubresource.mipLevel = level;
+			region.imageSubresource.baseArrayLayer = 0;
+			region.imageSubresource.layerCount = 1;
+			region.imageOffset = { 0, 0, 0 };
+			region.imageExtent = { std::max(1u, builder.width >> level), std::max(1u, builder.height >> level), 1 };
+		}
+
+		auto& uploader = m_device.uploader();
+		VkCommandBuffer commandBuffer = uploader.beginTransfer();
+
+		recordImageBarrier(commandBuffer, m_textureImage,
+			VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			0, VK_ACCESS_TRANSFER_WRITE_BIT,
+			VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+			0, m_mipLevels);
+
+		vkCmdCopyBufferToImage(
+			commandBuffer,
+			stagingBuffer->buffer(),
+			m_textureImage,
+			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			static_cast<uint32_t>(regions.size()),
+			regions.data());
+
+		// Blits are not supported on transfer queues, so mipmaps are generated on the graphics queue after the acquire
+		Uploader::AcquireFunction acquire;
+		if (builder.generateMipmaps)
+		{
+			uploader.releaseImage(commandBuffer, m_textureImage, m_mipLevels,
+				VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+
+			acquire = [this, width = builder.width, height = builder.height](VkCommandBuffer graphicsCommandBuffer)
+				{
+					m_device.uploader().acquireImage(graphicsCommandBuffer, m_textureImage, m_mipLevels,
+						VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+						VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+					generateMipmaps(graphicsCommandBuffer, width, height);
+				};
+		}
+		else
+		{
+			uploader.releaseImage(commandBuffer, m_textureImage, m_mipLevels,
+				VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+			acquire = [this](VkCommandBuffer graphicsCommandBuffer)
+				{
+					m_device.uploader().acquireImage(graphicsCommandBuffer, m_textureImage, m_mipLevels,
+						VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+						VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+				};
+		}
+
+		std::vector<std::unique_ptr<Buffer>> stagingBuffers;
+		stagingBuffers.push_back(std::move(stagingBuffer));
+
+		m_uploadPending = true;
+		uploader.submit(commandBuffer, std::move(stagingBuffers), std::move(acquire), [this]() { m_uploadPending = false; m_ready = true; });
+	}
+
+	void Texture::generateMipmaps(VkCommandBuffer commandBuffer, uint32_t width, uint32_t height)
+	{
+		int32_t mipWidth = static_cast<int32_t>(width);
+		int32_t mipHeight = static_cast<int32_t>(height);
+
+		for (uint32_t level = 1; level < m_mipLevels; level++)
+		{
+			// Previous level becomes the blit source
+			recordImageBarrier(commandBuffer, m_textureImage,
+				VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+				VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT,
+				VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+				level - 1, 1);
+
+			int32_t nextWidth = std::max(1, mipWidth / 2);
+			int32_t nextHeight = std::max(1, mipHeight / 2);
+
+			VkImageBlit blit{};
+			blit.srcOffsets[0] = { 0, 0, 0 };
+			blit.srcOffsets[1] = { mipWidth, mipHeight, 1 };
+			blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			blit.srcSubresource.mipLevel = level - 1;
+			blit.srcSubresource.baseArrayLayer = 0;
+			blit.srcSubresource.layerCount = 1;
+			blit.dstOffsets[0] = { 0, 0, 0 };
+			blit.dstOffsets[1] = { nextWidth, nextHeight, 1 };
+			blit.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			blit.dstSubresource.mipLevel = level;
+			blit.dstSubresource.baseArrayLayer = 0;
+			blit.dstSubresource.layerCount = 1;
+
+			vkCmdBlitImage(commandBuffer,
+				m_textureImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+				m_textureImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+				1, &blit,
+				VK_FILTER_LINEAR);
+
+			recordImageBarrier(commandBuffer, m_textureImage,
+				VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+				VK_ACCESS_TRANSFER_READ_BIT, VK_ACCESS_SHADER_READ_BIT,
+				VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+				level - 1, 1);
+
+			mipWidth = nextWidth;
+			mipHeight = nextHeight;
+		}
+
+		// Last level was only written to
+		recordImageBarrier(commandBuffer, m_textureImage,
+			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+			VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
+			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+			m_mipLevels - 1, 1);
 	}
 
 	void Texture::createImageView()
@@ -82,10 +276,10 @@ namespace VEGraphics
 		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
 		viewInfo.image = m_textureImage;
 		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
-		viewInfo.format = VK_FORMAT_R8G8B8A8_SRGB;
+		viewInfo.format = m_format;
 		viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
 		viewInfo.subresourceRange.baseMipLevel = 0;
-		viewInfo.subresourceRange.levelCount = 1;
+		viewInfo.subresourceRange.levelCount = m_mipLevels;
 		viewInfo.subresourceRange.baseArrayLayer = 0;
 		viewInfo.subresourceRange.layerCount = 1;
 
@@ -110,11 +304,121 @@ namespace VEGraphics
 		samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
 		samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
 		samplerInfo.minLod = 0.0f;
-		samplerInfo.maxLod = 0.0f;
+		samplerInfo.maxLod = static_cast<float>(m_mipLevels);
 		samplerInfo.mipLodBias = 0.0f;
 
 		if (vkCreateSampler(m_device.device(), &samplerInfo, nullptr, &m_textureSampler) != VK_SUCCESS)
 			throw std::runtime_error("failed to create texture sampler");
 	}
 
-} // namespace vre
\ No newline at end of file
+	void Texture::Builder::loadTexture(const std::filesystem::path& filepath)
+	{
+		data.clear();
+		levelOffsets.clear();
+
+		// Resolved like models, so textures are found independent of the working directory
+		std::filesystem::path path(ENGINE_DIR);
+		path += filepath;
+
+		if (path.extension() == ".ktx2")
+		{
+			loadKtx2(path);
+		}
+		else
+		{
+			loadImage(path);
+		}
+	}
+
+	void Texture::Builder::loadImage(const std::filesystem::path& filepath)
+	{
+		int texWidth, texHeight, texChannels;
+		stbi_uc* pixels = stbi_load(filepath.string().c_str(), &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
+		if (!pixels)
+			throw std::runtime_error("Failed to load texture image: " + filepath.string());
+
+		format = VK_FORMAT_R8G8B8A8_SRGB;
+		width = static_cast<uint32_t>(texWidth);
+		height = static_cast<uint32_t>(texHeight);
+		mipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(width, height)))) + 1;
+		generateMipmaps = mipLevels > 1;
+
+		data.assign(pixels, pixels + textureLevelSize(format, width, height));
+		levelOffsets = { 0 };
+
+		stbi_image_free(pixels);
+	}
+
+	void Texture::Builder::loadKtx2(const std::filesystem::path& filepath)
+	{
+		std::ifstream file{ filepath, std::ios::ate | std::ios::binary };
+		if (!file.is_open())
+			throw std::runtime_error("Failed to open texture file: " + filepath.string());
+
+		std::vector<uint8_t> fileData(static_cast<size_t>(file.tellg()));
+		file.seekg(0);
+		file.read(reinterpret_cast<char*>(fileData.data()), fileData.size());
+		file.close();
+
+		const size_t levelIndexOffset = sizeof(KTX2_IDENTIFIER) + sizeof(Ktx2Header) + sizeof(Ktx2Index);
+		if (fileData.size() < levelIndexOffset || std::memcmp(fileData.data(), KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) != 0)
+			throw std::runtime_error("Invalid KTX2 file: " + filepath.string());
+
+		Ktx2Header header;
+		std::memcpy(&header, fileData.data() + sizeof(KTX2_IDENTIFIER), sizeof(Ktx2Header));
+
+		if (header.supercompressionScheme != 0)
+			throw std::runtime_error("Supercompressed KTX2 files are not supported: " + filepath.string());
+		if (header.layerCount > 1 || header.faceCount != 1 || header.pixelDepth > 1)
+			throw std::runtime_error("Only 2D KTX2 textures are supported: " + filepath.string());
+
+		format = static_cast<VkFormat>(header.vkFormat);
+		switch (format)
+		{
+		case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+		case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+		case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+		case VK_FORMAT_BC3_UNORM_BLOCK:
+		case VK_FORMAT_BC3_SRGB_BLOCK:
+		case VK_FORMAT_BC7_UNORM_BLOCK:
+		case VK_FORMAT_BC7_SRGB_BLOCK:
+		case VK_FORMAT_R8G8B8A8_UNORM:
+		case VK_FORMAT_R8G8B8A8_SRGB:
+			break;
+		default:
+			throw std::runtime_error("Unsupported KTX2 format " + std::to_string(header.vkFormat) + ": " + filepath.string());
+		}
+
+		width = header.pixelWidth;
+		height = header.pixelHeight;
+
+		// A level count of 0 requests mipmap generation from level 0
+		uint32_t storedLevelCount = std::max(1u, header.levelCount);
+		if (fileData.size() < levelIndexOffset + storedLevelCount * sizeof(Ktx2LevelIndex))
+			throw std::runtime_error("Truncated KTX2 file: " + filepath.string());
+
+		generateMipmaps = header.levelCount == 0;
+		mipLevels = generateMipmaps ? static_cast<uint32_t>(std::floor(std::log2(std::max(width, height)))) + 1 : storedLevelCount;
+		if (generateMipmaps && blockCompressedBlockSize(format) > 0)
+			throw std::runtime_error("KTX2 files with block compression must contain all mip levels: " + filepath.string());
+
+		// Copy levels in order of level 0 first (files store the smallest level first)
+		for (uint32_t level = 0; level < storedLevelCount; level++)
+		{
+			Ktx2LevelIndex levelIndex;
+			std::memcpy(&levelIndex, fileData.data() + levelIndexOffset + level * sizeof(Ktx2LevelIndex), sizeof(Ktx2LevelIndex));
+
+			uint64_t expectedSize = textureLevelSize(format, std::max(1u, width >> level), std::max(1u, height >> level));
+			if (levelIndex.byteLength < expectedSize || levelIndex.byteOffset + expectedSize > fileData.size())
+				throw std::runtime_error("Invalid KTX2 level data: " + filepath.string());
+
+			// Keep 16 byte alignment for the buffer to image copy offsets
+			data.resize((data.size() + 15) & ~size_t{ 15 });
+			levelOffsets.push_back(data.size());
+			auto levelBegin = fileData.begin() + static_cast<ptrdiff_t>(levelIndex.byteOffset);
+			data.insert(data.end(), levelBegin, levelBegin + static_cast<ptrdiff_t>(expectedSize));
+		}
+	}
+
+} // namespace vre
@@ -4,7 +4,9 @@
 
 #include <vulkan/vulkan.h>
 
+#include <filesystem>
 #include <string>
+#include <vector>
 
 namespace VEGraphics
 {
@@ -16,25 +18,71 @@ namespace VEGraphics
 			std::string textureFilePath;
 		};
 
+		/// @brief CPU side image data of a texture including all stored mip levels
+		struct Builder
+		{
+			VkFormat format = VK_FORMAT_R8G8B8A8_SRGB;
+			uint32_t width = 0;
+			uint32_t height = 0;
+			uint32_t mipLevels = 1;
+			bool generateMipmaps = false; // Only level 0 is stored, the remaining levels are generated on the GPU
+
+			std::vector<uint8_t> data{};
+			std::vector<VkDeviceSize> levelOffsets{}; // Offset of each stored level in data
+
+			/// @brief Loads an image (png, jpg, ...) or a KTX2 file with pre-compressed levels (BC1, BC3, BC7)
+			/// @param filepath Path relative to the engine directory
+			void loadTexture(const std::filesystem::path& filepath);
+
+			/// @brief Returns the number of mip levels stored in data
+			uint32_t storedLevels() const { return static_cast<uint32_t>(levelOffsets.size()); }
+
+		private:
+			void loadImage(const std::filesystem::path& filepath);
+			void loadKtx2(const std::filesystem::path& filepath);
+		};
+
 		Texture(VulkanDevice& device, const Texture::CreateInfo& createInfo);
+		Texture(VulkanDevice& device, const Texture::Builder& builder);
+
+		/// @brief Creates an empty texture which can not be sampled until upload was called
+		/// @note Used by the AssetLoader to hand out textures before their data is loaded
+		Texture(VulkanDevice& device);
 		~Texture();
 
 		Texture(const Texture&) = delete;
 		Texture& operator=(const Texture&) = delete;
 
-		VkDescriptorImageInfo descriptorImageInfo();
+		/// @brief Creates the image, image view and sampler and submits the data to the transfer queue
+		/// @note The texture is ready once the upload was acquired on the graphics queue at the beginning of a frame
+		void upload(const Texture::Builder& builder);
+
+		/// @brief Returns true if the texture data is uploaded and it can be sampled
+		bool isReady() const { return m_ready; }
+
+		VkDescriptorImageInfo descriptorImageInfo() const;
+
+		uint32_t mipLevels() const { return m_mipLevels; }
+		VkFormat format() const { return m_format; }
 
 	private:
-		void loadTexture(const std::string& filePath);
+		/// @brief Creates the image and submits the copy of the builder data to the transfer queue
+		void createTextureImage(const Texture::Builder& builder);
+		void generateMipmaps(VkCommandBuffer commandBuffer, uint32_t width, uint32_t height);
 		void createImageView();
 		void createTextureSampler();
 
 		VulkanDevice& m_device;
 
-		VkImage m_textureImage;
-		VkDeviceMemory m_textureImageMemory;
-		VkImageView m_textureImageView;
-		VkSampler m_textureSampler;
+		VkImage m_textureImage = VK_NULL_HANDLE;
+		VkDeviceMemory m_textureImageMemory = VK_NULL_HANDLE;
+		VkImageView m_textureImageView = VK_NULL_HANDLE;
+		VkSampler m_textureSampler = VK_NULL_HANDLE;
+
+		VkFormat m_format = VK_FORMAT_R8G8B8A8_SRGB;
+		uint32_t m_mipLevels = 1;
+		bool m_ready = false;
+		bool m_uploadPending = false;
 	};
 
-} // namespace vre
\ No newline at end of file
+} // namespace vre
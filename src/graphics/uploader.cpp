@@ -0,0 +1,270 @@
+#include "uploader.h"
+
+#include <stdexcept>
+
+namespace VEGraphics
+{
+	Uploader::Uploader(VulkanDevice& device) : m_device{ device }
+	{
+		QueueFamilyIndices indices = m_device.findPhysicalQueueFamilies();
+		m_transferFamily = indices.transferFamily;
+		m_graphicsFamily = indices.graphicsFamily;
+
+		createCommandPool();
+		createTimelineSemaphore();
+	}
+
+	Uploader::~Uploader()
+	{
+		// Wait for running transfers before their staging buffers and command buffers are destroyed
+		if (!m_pendingUploads.empty())
+			waitForValue(m_pendingUploads.back().timelineValue);
+
+		m_pendingUploads.clear();
+
+		vkDestroySemaphore(m_device.device(), m_timelineSemaphore, nullptr);
+		vkDestroyCommandPool(m_device.device(), m_commandPool, nullptr);
+	}
+
+	VkCommandBuffer Uploader::beginTransfer()
+	{
+		VkCommandBufferAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocInfo.commandPool = m_commandPool;
+		allocInfo.commandBufferCount = 1;
+
+		VkCommandBuffer commandBuffer;
+		if (vkAllocateCommandBuffers(m_device.device(), &allocInfo, &commandBuffer) != VK_SUCCESS)
+			throw std::runtime_error("failed to allocate transfer command buffer");
+
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+		vkBeginCommandBuffer(commandBuffer, &beginInfo);
+		return commandBuffer;
+	}
+
+	uint64_t Uploader::submit(
+		VkCommandBuffer commandBuffer,
+		std::vector<std::unique_ptr<Buffer>> stagingBuffers,
+		AcquireFunction acquire,
+		std::function<void()> onComplete)
+	{
+		if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+			throw std::runtime_error("failed to record transfer command buffer");
+
+		uint64_t signalValue = ++m_timelineValue;
+
+		VkTimelineSemaphoreSubmitInfo timelineInfo{};
+		timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+		timelineInfo.signalSemaphoreValueCount = 1;
+		timelineInfo.pSignalSemaphoreValues = &signalValue;
+
+		VkSubmitInfo submitInfo{};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.pNext = &timelineInfo;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &commandBuffer;
+		submitInfo.signalSemaphoreCount = 1;
+		submitInfo.pSignalSemaphores = &m_timelineSemaphore;
+
+		if (vkQueueSubmit(m_device.transferQueue(), 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
+			throw std::runtime_error("failed to submit transfer command buffer");
+
+		m_pendingUploads.push_back({ signalValue, commandBuffer, std::move(stagingBuffers), std::move(acquire), std::move(onComplete) });
+		return signalValue;
+	}
+
+	uint64_t Uploader::recordAcquires(VkCommandBuffer graphicsCommandBuffer)
+	{
+		if (m_pendingUploads.empty())
+			return 0;
+
+		uint64_t completedValue = 0;
+		vkGetSemaphoreCounterValue(m_device.device(), m_timelineSemaphore, &completedValue);
+
+		uint64_t waitValue = 0;
+		while (!m_pendingUploads.empty() && m_pendingUploads.front().timelineValue <= completedValue)
+		{
+			auto& upload = m_pendingUploads.front();
+			if (upload.acquire)
+				upload.acquire(graphicsCommandBuffer);
+
+			if (upload.onComplete)
+				upload.onComplete();
+
+			vkFreeCommandBuffers(m_device.device(), m_commandPool, 1, &upload.commandBuffer);
+			waitValue = upload.timelineValue;
+			m_pendingUploads.pop_front();
+		}
+		return waitValue;
+	}
+
+	void Uploader::flush()
+	{
+		if (m_pendingUploads.empty())
+			return;
+
+		waitForValue(m_pendingUploads.back().timelineValue);
+
+		VkCommandBuffer commandBuffer = m_device.beginSingleTimeCommands();
+		uint64_t waitValue = recordAcquires(commandBuffer);
+		vkEndCommandBuffer(commandBuffer);
+
+		// The acquire signals its own value, so only this submission is waited for instead of the whole graphics queue
+		uint64_t acquireValue = ++m_timelineValue;
+
+		VkTimelineSemaphoreSubmitInfo timelineInfo{};
+		timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+		timelineInfo.waitSemaphoreValueCount = 1;
+		timelineInfo.pWaitSemaphoreValues = &waitValue;
+		timelineInfo.signalSemaphoreValueCount = 1;
+		timelineInfo.pSignalSemaphoreValues = &acquireValue;
+
+		VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+		VkSubmitInfo submitInfo{};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.pNext = &timelineInfo;
+		submitInfo.waitSemaphoreCount = 1;
+		submitInfo.pWaitSemaphores = &m_timelineSemaphore;
+		submitInfo.pWaitDstStageMask = &waitStage;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &commandBuffer;
+		submitInfo.signalSemaphoreCount = 1;
+		submitInfo.pSignalSemaphores = &m_timelineSemaphore;
+
+		if (vkQueueSubmit(m_device.graphicsQueue(), 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
+			throw std::runtime_error("failed to submit upload acquire command buffer");
+		waitForValue(acquireValue);
+
+		vkFreeCommandBuffers(m_device.device(), m_device.commandPool(), 1, &commandBuffer);
+	}
+
+	void Uploader::waitForValue(uint64_t value)
+	{
+		VkSemaphoreWaitInfo waitInfo{};
+		waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+		waitInfo.semaphoreCount = 1;
+		waitInfo.pSemaphores = &m_timelineSemaphore;
+		waitInfo.pValues = &value;
+		vkWaitSemaphores(m_device.device(), &waitInfo, UINT64_MAX);
+	}
+
+	void Uploader::releaseBuffer(VkCommandBuffer transferCommandBuffer, VkBuffer buffer)
+	{
+		// Within the same queue family the acquire barrier alone makes the transfer visible
+		if (!requiresOwnershipTransfer())
+			return;
+
+		VkBufferMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = 0;
+		barrier.srcQueueFamilyIndex = m_transferFamily;
+		barrier.dstQueueFamilyIndex = m_graphicsFamily;
+		barrier.buffer = buffer;
+		barrier.offset = 0;
+		barrier.size = VK_WHOLE_SIZE;
+
+		vkCmdPipelineBarrier(transferCommandBuffer,
+			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+			0, 0, nullptr, 1, &barrier, 0, nullptr);
+	}
+
+	void Uploader::acquireBuffer(VkCommandBuffer graphicsCommandBuffer, VkBuffer buffer, VkAccessFlags dstAccessMask, VkPipelineStageFlags dstStageMask)
+	{
+		bool ownershipTransfer = requiresOwnershipTransfer();
+
+		VkBufferMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		barrier.srcAccessMask = ownershipTransfer ? 0 : VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = dstAccessMask;
+		barrier.srcQueueFamilyIndex = ownershipTransfer ? m_transferFamily : VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = ownershipTransfer ? m_graphicsFamily : VK_QUEUE_FAMILY_IGNORED;
+		barrier.buffer = buffer;
+		barrier.offset = 0;
+		barrier.size = VK_WHOLE_SIZE;
+
+		vkCmdPipelineBarrier(graphicsCommandBuffer,
+			ownershipTransfer ? VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT : VK_PIPELINE_STAGE_TRANSFER_BIT, dstStageMask,
+			0, 0, nullptr, 1, &barrier, 0, nullptr);
+	}
+
+	void Uploader::releaseImage(VkCommandBuffer transferCommandBuffer, VkImage image, uint32_t mipLevels, VkImageLayout oldLayout, VkImageLayout newLayout)
+	{
+		// Within the same queue family the acquire barrier alone transitions the layout
+		if (!requiresOwnershipTransfer())
+			return;
+
+		VkImageMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.oldLayout = oldLayout;
+		barrier.newLayout = newLayout;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = 0;
+		barrier.srcQueueFamilyIndex = m_transferFamily;
+		barrier.dstQueueFamilyIndex = m_graphicsFamily;
+		barrier.image = image;
+		barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, mipLevels, 0, 1 };
+
+		vkCmdPipelineBarrier(transferCommandBuffer,
+			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+			0, 0, nullptr, 0, nullptr, 1, &barrier);
+	}
+
+	void Uploader::acquireImage(
+		VkCommandBuffer graphicsCommandBuffer,
+		VkImage image,
+		uint32_t mipLevels,
+		VkImageLayout oldLayout,
+		VkImageLayout newLayout,
+		VkAccessFlags dstAccessMask,
+		VkPipelineStageFlags dstStageMask)
+	{
+		bool ownershipTransfer = requiresOwnershipTransfer();
+
+		VkImageMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.oldLayout = oldLayout;
+		barrier.newLayout = newLayout;
+		barrier.srcAccessMask = ownershipTransfer ? 0 : VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = dstAccessMask;
+		barrier.srcQueueFamilyIndex = ownershipTransfer ? m_transferFamily : VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = ownershipTransfer ? m_graphicsFamily : VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = image;
+		barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, mipLevels, 0, 1 };
+
+		vkCmdPipelineBarrier(graphicsCommandBuffer,
+			ownershipTransfer ? VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT : VK_PIPELINE_STAGE_TRANSFER_BIT, dstStageMask,
+			0, 0, nullptr, 0, nullptr, 1, &barrier);
+	}
+
+	void Uploader::createCommandPool()
+	{
+		VkCommandPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.queueFamilyIndex = m_transferFamily;
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+		if (vkCreateCommandPool(m_device.device(), &poolInfo, nullptr, &m_commandPool) != VK_SUCCESS)
+			throw std::runtime_error("failed to create transfer command pool");
+	}
+
+	void Uploader::createTimelineSemaphore()
+	{
+		VkSemaphoreTypeCreateInfo typeInfo{};
+		typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+		typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+		typeInfo.initialValue = 0;
+
+		VkSemaphoreCreateInfo semaphoreInfo{};
+		semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+		semaphoreInfo.pNext = &typeInfo;
+
+		if (vkCreateSemaphore(m_device.device(), &semaphoreInfo, nullptr, &m_timelineSemaphore) != VK_SUCCESS)
+			throw std::runtime_error("failed to create upload timeline semaphore");
+	}
+
+} // namespace VEGraphics
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "graphics/buffer.h"
+#include "graphics/device.h"
+
+#include <vulkan/vulkan.h>
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace VEGraphics
+{
+	/// @brief Submits resource uploads to the transfer queue without blocking the graphics queue
+	/// @note Completion is tracked with a timeline semaphore. If the transfer queue belongs to another queue family
+	/// the resources are released on the transfer queue and acquired on the graphics queue at the beginning of a frame.
+	class Uploader
+	{
+	public:
+		/// @brief Records the graphics queue side of an upload (acquire barriers and graphics only commands)
+		using AcquireFunction = std::function<void(VkCommandBuffer graphicsCommandBuffer)>;
+
+		Uploader(VulkanDevice& device);
+		~Uploader();
+
+		Uploader(const Uploader&) = delete;
+		Uploader& operator=(const Uploader&) = delete;
+
+		/// @brief Begins a command buffer for the transfer queue
+		VkCommandBuffer beginTransfer();
+
+		/// @brief Submits the transfer commands to the transfer queue
+		/// @param commandBuffer Command buffer returned by beginTransfer
+		/// @param stagingBuffers Source buffers which are kept alive until the transfer finished
+		/// @param acquire Recorded into a graphics command buffer after the transfer finished
+		/// @param onComplete Called on the main thread after acquire was recorded, the resources can be used afterwards
+		/// @return Timeline semaphore value that is signaled when the transfer finished
+		uint64_t submit(
+			VkCommandBuffer commandBuffer,
+			std::vector<std::unique_ptr<Buffer>> stagingBuffers,
+			AcquireFunction acquire,
+			std::function<void()> onComplete);
+
+		/// @brief Records the acquire commands of all finished transfers into a graphics command buffer
+		/// @return Timeline value the submission of the command buffer has to wait for, 0 if nothing was recorded
+		uint64_t recordAcquires(VkCommandBuffer graphicsCommandBuffer);
+
+		/// @brief Blocks until all submitted uploads finished and were acquired on the graphics queue
+		/// @note Waits on the timeline semaphore for the uploads only, frames in flight on the graphics queue are not waited for
+		void flush();
+
+		/// @brief Records the release of a buffer on the transfer queue
+		void releaseBuffer(VkCommandBuffer transferCommandBuffer, VkBuffer buffer);
+
+		/// @brief Records the acquire of a buffer on the graphics queue
+		void acquireBuffer(VkCommandBuffer graphicsCommandBuffer, VkBuffer buffer, VkAccessFlags dstAccessMask, VkPipelineStageFlags dstStageMask);
+
+		/// @brief Records the release of all mip levels of an image on the transfer queue, including the layout transition
+		void releaseImage(VkCommandBuffer transferCommandBuffer, VkImage image, uint32_t mipLevels, VkImageLayout oldLayout, VkImageLayout newLayout);
+
+		/// @brief Records the acquire of all mip levels of an image on the graphics queue, the layouts have to match the release
+		void acquireImage(
+			VkCommandBuffer graphicsCommandBuffer,
+			VkImage image,
+			uint32_t mipLevels,
+			VkImageLayout oldLayout,
+			VkImageLayout newLayout,
+			VkAccessFlags dstAccessMask,
+			VkPipelineStageFlags dstStageMask);
+
+		VkSemaphore timelineSemaphore() const { return m_timelineSemaphore; }
+
+		/// @brief Returns true if the transfer queue belongs to another family than the graphics queue
+		bool requiresOwnershipTransfer() const { return m_transferFamily != m_graphicsFamily; }
+
+	private:
+		struct PendingUpload
+		{
+			uint64_t timelineValue;
+			VkCommandBuffer commandBuffer;
+			std::vector<std::unique_ptr<Buffer>> stagingBuffers;
+			AcquireFunction acquire;
+			std::function<void()> onComplete;
+		};
+
+		void createCommandPool();
+		void createTimelineSemaphore();
+
+		/// @brief Blocks until the timeline semaphore reached the value
+		void waitForValue(uint64_t value);
+
+		VulkanDevice& m_device;
+
+		uint32_t m_transferFamily;
+		uint32_t m_graphicsFamily;
+
+		VkCommandPool m_commandPool = VK_NULL_HANDLE;
+		VkSemaphore m_timelineSemaphore = VK_NULL_HANDLE;
+		uint64_t m_timelineValue = 0;
+
+		std::deque<PendingUpload> m_pendingUploads; // Ordered by timeline value
+	};
+
+} // namespace VEGraphics
@@ -7,12 +7,21 @@
 
 #include <iostream>
 #include <stdexcept>
+#include <string_view>
 
-int main()
+int main(int argc, char* argv[])
 {
+	// --capture <directory> writes a dataset of all cameras headless instead of opening a window
+	Vulkanite::EngineConfig config{};
+	for (int i = 1; i + 1 < argc; i++)
+	{
+		if (std::string_view{ argv[i] } == "--capture")
+			config.capture = VEGraphics::DatasetCaptureSettings{ argv[i + 1] };
+	}
+
 	try
 	{
-		Vulkanite::Engine engine{};
+		Vulkanite::Engine engine{ config };
 		engine.loadScene<DefaultScene>();
 		engine.run();
 	}
@@ -2,6 +2,8 @@
 
 #include "scene/components.h"
 
+#include <cmath>
+
 namespace VEPhysics
 {
 	Force& Force::operator+=(const Force& other)
@@ -84,9 +86,9 @@ namespace VEPhysics
 
 	void MotionDynamics::update(float deltaSeconds)
 	{
+		applyForces(deltaSeconds);
 		addFriction(deltaSeconds);
 
-		applyForces(deltaSeconds);
 		// Update transform
 		auto& transform = getComponent<VEComponent::Transform>();
 		transform.location += m_linearVelocity * deltaSeconds;
@@ -110,8 +112,9 @@ namespace VEPhysics
 
 	void MotionDynamics::addFriction(float deltaSeconds)
 	{
-		addLinearForce(-m_linearVelocity * m_properties.linearFriction);
-		addAngularForce(-m_angularVelocity * m_properties.angularFriction);
+		// Exact decay instead of a friction force, which overshoots and reverses the velocity at large deltas
+		m_linearVelocity *= std::exp(-m_properties.linearFriction / m_properties.mass * deltaSeconds);
+		m_angularVelocity *= std::exp(-m_properties.angularFriction / m_properties.mass * deltaSeconds);
 	}
 
 
@@ -31,6 +31,9 @@ namespace VEPhysics
 	class MotionDynamics : public VEScripting::ScriptBase
 	{
 	public:
+		/// @brief Integrates the forces which the pre-physics scripts added this frame
+		static constexpr VEScripting::ScriptPhase phase = VEScripting::ScriptPhase::Physics;
+
 		struct Properties
 		{
 			float mass = 1.0f;
@@ -78,7 +81,8 @@ namespace VEPhysics
 		Properties& properties() { return m_properties; }
 
 		/// @brief Updates the position and rotation of the object based on the current velocity.
-		/// @note This function is called automatically each frame.
+		/// @note This function is called automatically each frame, or as set by the tick policy. The added forces act
+		/// over the whole delta, so scripts adding forces should use the same tick policy on the entity.
 		void update(float deltaSeconds) override;
 
 	private:
@@ -86,6 +90,7 @@ namespace VEPhysics
 		/// @note Resets the accelerations to zero for the next frame.
 		void applyForces(float deltaSeconds);
 
+		/// @brief Decays the velocities, stable for any delta
 		void addFriction(float deltaSeconds);
 
 
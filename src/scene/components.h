@@ -2,11 +2,14 @@
 
 #include "graphics/camera.h"
 #include "graphics/model.h"
+#include "graphics/texture.h"
 #include "utils/color.h"
 #include "utils/math_utils.h"
+#include "utils/string_pool.h"
 
 #include <memory>
 #include <string>
+#include <string_view>
 
 namespace VEScripting
 {
@@ -16,19 +19,26 @@ namespace VEScripting
 namespace VEComponent
 {
 	/// @brief Gives a name to the entity
+	/// @note Stores the id of the interned string, use Scene::rename to change it so the name index of the scene stays
+	/// up to date, the component is only readable through Entity
 	struct Name
 	{
-		std::string name;
+		uint32_t id = VEUtils::StringPool::EMPTY;
 
 		Name() = default;
 		Name(const Name&) = default;
-		Name(const std::string& entityName)
-			: name(entityName) {}
+		Name(std::string_view entityName)
+			: id(VEUtils::StringPool::instance().intern(entityName)) {}
+
+		const std::string& name() const { return VEUtils::StringPool::instance().string(id); }
 	};
 
 	/// @brief Stores the transformation of the entity
+	/// @note Changes are tracked, see Scene::viewChangedEntities
 	struct Transform
 	{
+		static constexpr bool trackChanges = true;
+
 		Vector3 location = { 0.0f, 0.0f, 0.0f };
 		Vector3 rotation = { 0.0f, 0.0f, 0.0f };
 		Vector3 scale = { 1.0f, 1.0f, 1.0f };
@@ -43,6 +53,15 @@ namespace VEComponent
 		Vector3 up() const { return MathLib::up(rotation); }
 	};
 
+	/// @brief Model and normal matrix of the Transform, rebuilt by the scene when the transform changed
+	struct WorldTransform
+	{
+		Matrix4 modelMatrix{ 1.0f };
+		Matrix3 normalMatrix{ 1.0f };
+
+		Vector3 location() const { return Vector3{ modelMatrix[3] }; }
+	};
+
 	/// @brief Holds a pointer to a model
 	struct Mesh
 	{
@@ -55,6 +74,20 @@ namespace VEComponent
 			: model(entityModel), color(baseColor) {}
 	};
 
+	/// @brief Surface properties of a mesh
+	/// @note Entities without a material are drawn untextured with the color of the mesh
+	struct Material
+	{
+		Color baseColor;
+		std::shared_ptr<VEGraphics::Texture> albedoTexture; // Multiplied with the base color, white if not set or still loading
+		float shininess = 32.0f; // Specular exponent, 0 disables the specular term (selects a pipeline variant without it)
+
+		Material() = default;
+		Material(const Material&) = default;
+		Material(const Color& color, std::shared_ptr<VEGraphics::Texture> texture = nullptr, float specularExponent = 32.0f)
+			: baseColor(color), albedoTexture(texture), shininess(specularExponent) {}
+	};
+
 	/// @brief Creates a light 
 	struct PointLight
 	{
@@ -68,11 +101,26 @@ namespace VEComponent
 	};
 
 	/// @brief Holds a camera to view the scene
+	/// @note Every camera renders one view per frame, either into a region of the window or into its own offscreen target
 	struct Camera
 	{
 		VEGraphics::Camera camera{};
+
+		Vector4 viewport{ 0.0f, 0.0f, 1.0f, 1.0f }; // Region of the window in normalized coordinates (x, y, width, height)
+		uint32_t targetWidth = 0; // Size of the offscreen target in pixels, zero renders into the window
+		uint32_t targetHeight = 0;
+		int32_t order = 0; // Views are rendered in ascending order, the window camera with the lowest order is the main camera
+
+		float fieldOfView = 0.8726646f; // Vertical field of view in radians (50 degrees)
+		float nearPlane = 0.1f;
+		float farPlane = 100.0f;
+
+		bool isOffscreen() const { return targetWidth > 0 && targetHeight > 0; }
 	};
 
+	/// @brief Tag of entities in unloaded cells of the world partition, their scripts are not updated and they are not rendered
+	struct Suspended {};
+
 	/// @brief Stores a custom script
 	struct Script
 	{
@@ -3,19 +3,22 @@
 #include "scene/components.h"
 #include "scene/entity.h"
 #include "scene/scene.h"
+#include "scene/scene_snapshot.h"
 #include "scripting/script_base.h"
 
 /// @brief Rotates the entity around the vertical axis
 /// @note Example of a custom Component
 class Rotator : public VEScripting::ScriptBase
 {
-protected:
+public:
 	void update(float deltaSeconds) override
 	{
 		getComponent<VEComponent::Transform>().rotation += Vector3{ 0.0f, 1.0f, 0.0f } * deltaSeconds;
 	}
 };
 
+inline const bool rotatorSnapshotRegistered = VEScene::SceneSnapshot::registerScript<Rotator>("Rotator");
+
 /// @brief Scene with a teapot on a plane
 /// @note Example of a custom scene
 class DefaultScene : public VEScene::Scene
@@ -27,14 +30,15 @@ public:
 	void initialize() override
 	{
 		{ // Models 
-			auto teapotModel = loadModel("models/teapot.obj");
+			auto teapotModel = loadModelAsync("models/teapot.obj");
 			auto teapot = createEntity("Teapot");
 			teapot.addComponent<VEComponent::Mesh>(teapotModel, Color::red());
 			teapot.addComponent<Rotator>();
 			
-			auto planeModel = loadModel("models/plane.obj");
+			auto planeModel = loadModelAsync("models/plane.obj");
 			auto plane = createEntity("Plane");
 			plane.addComponent<VEComponent::Mesh>(planeModel, Color::white());
+			plane.addComponent<VEComponent::Material>(Color::white(), loadTextureAsync("textures/painting.png"));
 		}
 		{ // Lights
 			auto light1 = createEntity("Light 1", { -5.0f, -5.0f, 0.0f });
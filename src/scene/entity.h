@@ -6,6 +6,7 @@
 #include <entt/entt.hpp>
 
 #include <cassert>
+#include <type_traits>
 
 namespace VEScene
 {
@@ -23,6 +24,15 @@ namespace VEScene
 			return m_entityHandle == other.m_entityHandle && m_scene == other.m_scene;
 		}
 
+		/// @brief Returns false for default constructed entities, failed lookups and destroyed entities
+		bool isValid() const { return m_scene != nullptr && m_scene->m_registry.valid(m_entityHandle); }
+
+		/// @brief Returns the id of the entity in the registry of its scene
+		entt::entity handle() const { return m_entityHandle; }
+
+		/// @brief Returns the scene the entity belongs to
+		Scene& scene() const { return *m_scene; }
+
 		/// @brief Checks if the entity has all components of type T...
 		/// @tparam ...T Type of the components to check
 		/// @return True if the entity has all components of type T... otherwise false
@@ -35,8 +45,19 @@ namespace VEScene
 		/// @brief Acces to the component of type T
 		/// @tparam T Type of the component
 		/// @return A reference to the component 
+		/// @note Marks change tracked components as changed, use readComponent if the component is not modified
 		template<typename T>
 		T& getComponent() const
+		{
+			static_assert(!std::is_same_v<T, VEComponent::Name>, "Names are indexed by the scene, use readComponent and Scene::rename");
+			assert(hasComponent<T>() && "Entity does not have the component");
+			m_scene->markChanged<T>(m_entityHandle);
+			return m_scene->m_registry.get<T>(m_entityHandle);
+		}
+
+		/// @brief Read-only access to the component of type T, which does not mark it as changed
+		template<typename T>
+		const T& readComponent() const
 		{
 			assert(hasComponent<T>() && "Entity does not have the component");
 			return m_scene->m_registry.get<T>(m_entityHandle);
@@ -61,10 +82,20 @@ namespace VEScene
 			assert(!hasComponent<T>() && "Entity already has the component");
 			auto& script = m_scene->m_registry.emplace<T>(m_entityHandle, std::forward<Args>(args)...);
 			script.m_entity = *this;
-			m_scene->addScript(&script);
+			m_scene->trackScript(script);
 			return script;
 		}
 
+		/// @brief Removes the component of type T from the entity
+		/// @note Invalidates references to the component, scripts are removed from the script manager.
+		/// Use the command buffer of the scene while entities are iterated.
+		template<typename T>
+		void removeComponent()
+		{
+			assert(hasComponent<T>() && "Entity does not have the component");
+			m_scene->m_registry.remove<T>(m_entityHandle);
+		}
+
 	private:
 		entt::entity m_entityHandle = { entt::null };
 		Scene* m_scene = nullptr;
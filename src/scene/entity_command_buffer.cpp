@@ -0,0 +1,61 @@
+#include "entity_command_buffer.h"
+
+#include "scene/scene.h"
+
+#include <utility>
+
+namespace VEScene
+{
+	EntityCommandBuffer::PendingEntity EntityCommandBuffer::createEntity(const std::string& name, const Vector3& location)
+	{
+		std::lock_guard lock{ m_mutex };
+
+		// The index is assigned under the same lock as the command, so it matches the playback order
+		PendingEntity pending{ m_createdCount++ };
+		m_commands.emplace_back([name, location](Scene& scene, std::vector<Entity>& created)
+			{
+				created.push_back(scene.createEntity(name, location));
+			});
+		return pending;
+	}
+
+	void EntityCommandBuffer::destroyEntity(Entity entity)
+	{
+		record([entity](Scene& scene, std::vector<Entity>&)
+			{
+				if (entity.isValid())
+					scene.destroyEntity(entity);
+			});
+	}
+
+	void EntityCommandBuffer::playback(Scene& scene)
+	{
+		std::vector<Command> commands;
+		uint32_t createdCount;
+		{
+			std::lock_guard lock{ m_mutex };
+			commands = std::exchange(m_commands, {});
+			createdCount = std::exchange(m_createdCount, 0);
+		}
+
+		std::vector<Entity> created;
+		created.reserve(createdCount);
+		for (auto& command : commands)
+		{
+			command(scene, created);
+		}
+	}
+
+	bool EntityCommandBuffer::empty() const
+	{
+		std::lock_guard lock{ m_mutex };
+		return m_commands.empty();
+	}
+
+	void EntityCommandBuffer::record(Command command)
+	{
+		std::lock_guard lock{ m_mutex };
+		m_commands.push_back(std::move(command));
+	}
+
+} // namespace VEScene
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "scene/entity.h"
+#include "utils/math_utils.h"
+
+#include <cassert>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace VEScene
+{
+	class Scene;
+
+	/// @brief Records structural changes of a scene and applies them later at a sync point
+	/// @note Recording is thread safe, so scripts and systems can queue changes while entities are iterated.
+	/// The scene plays back its buffer after the scripts were updated.
+	class EntityCommandBuffer
+	{
+	public:
+		/// @brief Placeholder for an entity which is created on playback
+		/// @note Only valid for commands recorded before the next playback of the buffer which created it
+		struct PendingEntity
+		{
+			uint32_t index;
+		};
+
+		/// @brief Records the creation of an entity with a name and a transform
+		PendingEntity createEntity(const std::string& name = std::string(), const Vector3& location = { 0.0f, 0.0f, 0.0f });
+
+		/// @brief Records the destruction of the entity and all its components
+		void destroyEntity(Entity entity);
+
+		/// @brief Records adding a component of type T, the arguments are copied until playback
+		template<typename T, typename... Args>
+		void addComponent(Entity entity, Args&&... args)
+		{
+			record([entity, arguments = std::make_tuple(std::forward<Args>(args)...)](Scene&, std::vector<Entity>&) mutable
+				{
+					if (entity.isValid())
+						std::apply([&](auto&... unpacked) { entity.addComponent<T>(std::move(unpacked)...); }, arguments);
+				});
+		}
+
+		/// @brief Records adding a component of type T to an entity created by this buffer
+		template<typename T, typename... Args>
+		void addComponent(PendingEntity pending, Args&&... args)
+		{
+			record([pending, arguments = std::make_tuple(std::forward<Args>(args)...)](Scene&, std::vector<Entity>& created) mutable
+				{
+					Entity entity = created[pending.index];
+					if (entity.isValid())
+						std::apply([&](auto&... unpacked) { entity.addComponent<T>(std::move(unpacked)...); }, arguments);
+				});
+		}
+
+		/// @brief Records removing the component of type T if the entity still has it
+		template<typename T>
+		void removeComponent(Entity entity)
+		{
+			record([entity](Scene&, std::vector<Entity>&)
+				{
+					if (entity.isValid() && entity.hasComponent<T>())
+						entity.removeComponent<T>();
+				});
+		}
+
+		/// @brief Applies the commands in recording order and clears the buffer
+		/// @note Has to be called on the main thread while no entities are iterated.
+		/// Commands recorded during playback are kept for the next playback.
+		void playback(Scene& scene);
+
+		bool empty() const;
+
+	private:
+		using Command = std::function<void(Scene&, std::vector<Entity>&)>;
+
+		void record(Command command);
+
+		mutable std::mutex m_mutex;
+		std::vector<Command> m_commands;
+		uint32_t m_createdCount = 0; // Number of pending entities of the recorded commands
+	};
+
+} // namespace VEScene
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "scene/components.h"
+#include "scene/entity.h"
+#include "scripting/script_base.h"
+
+#include <entt/entt.hpp>
+
+#include <functional>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+namespace VEScene
+{
+	/// @brief Template of the components of an entity, instantiated any number of times with Scene::instantiate
+	/// @note Components are copied into all instances with one bulk insert per type, scripts are constructed per instance
+	class Prefab
+	{
+	public:
+		/// @param name Name of every instance
+		/// @param transform Transform of every instance, the location can be set per instance when instantiating
+		Prefab(const std::string& name = "Entity", const VEComponent::Transform& transform = {})
+			: m_name{ name }, m_transform{ transform } {}
+
+		/// @brief Adds a component of type T which is copied into every instance
+		/// @param ...args Arguments for the constructor of T, it is constructed once here
+		template<typename T, typename... Args>
+		auto addComponent(Args&&... args) -> typename std::enable_if<!std::is_base_of<VEScripting::ScriptBase, T>::value, Prefab&>::type
+		{
+			m_components.emplace_back([component = T{ std::forward<Args>(args)... }](entt::registry& registry, const std::vector<entt::entity>& entities)
+				{
+					auto& storage = registry.storage<T>();
+					storage.reserve(storage.size() + entities.size());
+					registry.insert<T>(entities.begin(), entities.end(), component);
+				});
+			return *this;
+		}
+
+		/// @brief Adds a script derived from VEScripting::ScriptBase which is constructed for every instance
+		/// @param ...args Arguments for the constructor of T, copied unless passed with std::ref
+		template<typename T, typename... Args>
+		auto addComponent(Args&&... args) -> typename std::enable_if<std::is_base_of<VEScripting::ScriptBase, T>::value, Prefab&>::type
+		{
+			m_scripts.emplace_back([arguments = std::make_tuple(std::forward<Args>(args)...)](Entity entity) mutable
+				{
+					// Passed as lvalues, so the arguments are copied per instance and std::ref reaches T as a non-const reference
+					std::apply([&](auto&... unpacked) { entity.addComponent<T>(unpacked...); }, arguments);
+				});
+			return *this;
+		}
+
+		const std::string& name() const { return m_name; }
+		const VEComponent::Transform& transform() const { return m_transform; }
+
+	private:
+		std::string m_name;
+		VEComponent::Transform m_transform;
+
+		std::vector<std::function<void(entt::registry&, const std::vector<entt::entity>&)>> m_components;
+		std::vector<std::function<void(Entity)>> m_scripts;
+
+		friend class Scene;
+	};
+
+} // namespace VEScene
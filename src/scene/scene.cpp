@@ -2,19 +2,53 @@
 
 #include "components.h"
 #include "entity.h"
+#include "entity_command_buffer.h"
+#include "prefab.h"
+#include "scene_snapshot.h"
 #include "scripting/movement/kinematic_movement_controller.h"
 
+#include <algorithm>
 #include <cassert>
+#include <optional>
 
 namespace VEScene
 {
+	namespace
+	{
+		/// @brief Grows the storage of T once instead of while inserting
+		template<typename T>
+		void reserveStorage(entt::registry& registry, size_t count)
+		{
+			auto& storage = registry.storage<T>();
+			storage.reserve(storage.size() + count);
+		}
+	}
+
 	std::shared_ptr<VEGraphics::Model> Scene::loadModel(const std::filesystem::path& modelPath)
 	{
 		return VEGraphics::Model::createModelFromFile(m_device, modelPath);
 	}
 
-	Scene::Scene(VEGraphics::VulkanDevice& device) : m_device{ device }
+	std::shared_ptr<VEGraphics::Model> Scene::loadModelAsync(const std::filesystem::path& modelPath)
+	{
+		return m_assetLoader.loadModel(modelPath);
+	}
+
+	std::shared_ptr<VEGraphics::Texture> Scene::loadTextureAsync(const std::filesystem::path& texturePath)
 	{
+		return m_assetLoader.loadTexture(texturePath);
+	}
+
+	Scene::Scene(VEGraphics::VulkanDevice& device)
+		: m_device{ device }, m_commandBuffer{ std::make_unique<EntityCommandBuffer>() }, m_assetLoader{ device }
+	{
+		m_registry.on_construct<VEComponent::Name>().connect<&Scene::onNameConstruct>(*this);
+		m_registry.on_update<VEComponent::Name>().connect<&Scene::onNameUpdate>(*this);
+		m_registry.on_destroy<VEComponent::Name>().connect<&Scene::onNameDestroy>(*this);
+		m_registry.on_destroy<VEComponent::Mesh>().connect<&Scene::onMeshDestroy>(*this);
+		m_registry.on_destroy<VEComponent::Material>().connect<&Scene::onMaterialDestroy>(*this);
+		trackChanges<VEComponent::Transform>();
+
 		auto camera = createEntity("Main Camera");
 		camera.addComponent<VEComponent::Camera>();
 		camera.addComponent<VEScripting::KinematcMovementController>();
@@ -23,11 +57,244 @@ namespace VEScene
 		cameraTransform.rotation = { -1.03f, 0.0f, 0.0f };
 	}
 
+	Scene::~Scene()
+	{
+	}
+
+	void Scene::update(float deltaSeconds)
+	{
+		std::optional<Vector3> cameraLocation;
+		if (entt::entity mainCamera = findMainCamera(); mainCamera != entt::null)
+			cameraLocation = m_registry.get<VEComponent::Transform>(mainCamera).location;
+
+		m_scriptManager.update(deltaSeconds, cameraLocation);
+		m_commandBuffer->playback(*this);
+		updateWorldTransforms();
+	}
+
+	void Scene::clearChanges()
+	{
+		for (auto* changed : m_changedStorages)
+		{
+			changed->clear();
+		}
+	}
+
+	void Scene::updateWorldTransforms()
+	{
+		for (auto&& [entity, transform] : viewChangedEntities<VEComponent::Transform>().each())
+		{
+			m_registry.emplace_or_replace<VEComponent::WorldTransform>(
+				entity,
+				MathLib::tranformationMatrix(transform.location, transform.rotation, transform.scale),
+				MathLib::normalMatrix(transform.rotation, transform.scale));
+		}
+	}
+
+	void Scene::destroyEntity(Entity entity)
+	{
+		assert(entity.isValid() && "Entity is not valid");
+		m_registry.destroy(entity.handle());
+	}
+
+	void Scene::setSuspended(Entity entity, bool suspended)
+	{
+		bool isSuspended = m_registry.all_of<VEComponent::Suspended>(entity.handle());
+		if (suspended && !isSuspended)
+			m_registry.emplace<VEComponent::Suspended>(entity.handle());
+		else if (!suspended && isSuspended)
+			m_registry.remove<VEComponent::Suspended>(entity.handle());
+	}
+
 	Entity Scene::camera()
 	{
-		auto group = m_registry.group<VEComponent::Camera>();
-		assert(group.size() == 1 && "Scene has to contain exactly one camera");
-		return { group.front(), this };
+		entt::entity mainCamera = findMainCamera();
+		assert(mainCamera != entt::null && "Scene has to contain a camera which renders to the window");
+		return { mainCamera, this };
+	}
+
+	entt::entity Scene::findMainCamera()
+	{
+		entt::entity mainCamera = entt::null;
+		int32_t mainOrder = 0;
+		for (auto&& [entity, camera] : m_registry.view<VEComponent::Camera>().each())
+		{
+			if (!camera.isOffscreen() && (mainCamera == entt::null || camera.order < mainOrder))
+			{
+				mainCamera = entity;
+				mainOrder = camera.order;
+			}
+		}
+		return mainCamera;
+	}
+
+	std::vector<Entity> Scene::cameras()
+	{
+		auto view = m_registry.view<VEComponent::Camera>();
+
+		std::vector<Entity> cameras;
+		cameras.reserve(view.size());
+		for (entt::entity entity : view)
+		{
+			cameras.push_back({ entity, this });
+		}
+
+		std::stable_sort(cameras.begin(), cameras.end(), [&](const Entity& a, const Entity& b)
+			{
+				return view.get<VEComponent::Camera>(a.handle()).order < view.get<VEComponent::Camera>(b.handle()).order;
+			});
+		return cameras;
+	}
+
+	Entity Scene::findEntity(std::string_view name)
+	{
+		auto it = m_entitiesByName.find(VEUtils::StringPool::instance().find(name));
+		if (it == m_entitiesByName.end() || it->second.empty())
+			return {};
+
+		return { it->second.front(), this };
+	}
+
+	std::vector<Entity> Scene::findEntities(std::string_view name)
+	{
+		auto it = m_entitiesByName.find(VEUtils::StringPool::instance().find(name));
+		if (it == m_entitiesByName.end())
+			return {};
+
+		std::vector<Entity> entities;
+		entities.reserve(it->second.size());
+		for (entt::entity entity : it->second)
+		{
+			entities.emplace_back(entity, this);
+		}
+		return entities;
+	}
+
+	void Scene::rename(Entity entity, std::string_view name)
+	{
+		// Moves the entity to the new bucket of the name index in onNameUpdate
+		m_registry.replace<VEComponent::Name>(entity.handle(), name);
+	}
+
+	void Scene::onMeshDestroy(entt::registry& registry, entt::entity entity)
+	{
+		// Only the last owner retires the model, shared models of other entities stay alive anyway
+		auto& model = registry.get<VEComponent::Mesh>(entity).model;
+		if (model.use_count() == 1)
+			m_assetLoader.retire(model);
+	}
+
+	void Scene::onMaterialDestroy(entt::registry& registry, entt::entity entity)
+	{
+		auto& texture = registry.get<VEComponent::Material>(entity).albedoTexture;
+		if (texture.use_count() == 1)
+			m_assetLoader.retire(texture);
+	}
+
+	void Scene::onNameConstruct(entt::registry& registry, entt::entity entity)
+	{
+		uint32_t id = registry.get<VEComponent::Name>(entity).id;
+		auto& entities = m_entitiesByName[id];
+
+		auto index = entt::to_entity(entity);
+		if (index >= m_nameSlots.size())
+			m_nameSlots.resize(index + 1);
+		m_nameSlots[index] = { id, static_cast<uint32_t>(entities.size()) };
+
+		entities.push_back(entity);
+	}
+
+	void Scene::onNameUpdate(entt::registry& registry, entt::entity entity)
+	{
+		onNameDestroy(registry, entity);
+		onNameConstruct(registry, entity);
+	}
+
+	void Scene::onNameDestroy(entt::registry& registry, entt::entity entity)
+	{
+		// The indexed id is used, the component already has the new one when it was replaced
+		const NameSlot& nameSlot = m_nameSlots[entt::to_entity(entity)];
+		auto it = m_entitiesByName.find(nameSlot.id);
+		assert(it != m_entitiesByName.end() && "Name index is out of sync");
+
+		// Swap and pop, the order of entities with the same name is not kept
+		auto& entities = it->second;
+		uint32_t slot = nameSlot.slot;
+		assert(slot < entities.size() && entities[slot] == entity && "Name index is out of sync");
+
+		entt::entity moved = entities.back();
+		entities[slot] = moved;
+		m_nameSlots[entt::to_entity(moved)].slot = slot;
+		entities.pop_back();
+		if (entities.empty())
+			m_entitiesByName.erase(it);
+	}
+
+	std::vector<Entity> Scene::instantiate(const Prefab& prefab, size_t count)
+	{
+		std::vector<entt::entity> entities(count);
+		m_registry.create(entities.begin(), entities.end());
+
+		reserveStorage<VEComponent::Transform>(m_registry, count);
+		m_registry.insert<VEComponent::Transform>(entities.begin(), entities.end(), prefab.transform());
+
+		return insertPrefabComponents(prefab, entities);
+	}
+
+	std::vector<Entity> Scene::instantiate(const Prefab& prefab, const std::vector<Vector3>& locations)
+	{
+		std::vector<entt::entity> entities(locations.size());
+		m_registry.create(entities.begin(), entities.end());
+
+		std::vector<VEComponent::Transform> transforms(locations.size(), prefab.transform());
+		for (size_t i = 0; i < locations.size(); i++)
+		{
+			transforms[i].location = locations[i];
+		}
+
+		reserveStorage<VEComponent::Transform>(m_registry, locations.size());
+		m_registry.insert<VEComponent::Transform>(entities.begin(), entities.end(), transforms.begin());
+
+		return insertPrefabComponents(prefab, entities);
+	}
+
+	std::vector<Entity> Scene::insertPrefabComponents(const Prefab& prefab, const std::vector<entt::entity>& entities)
+	{
+		reserveStorage<VEComponent::Name>(m_registry, entities.size());
+		m_registry.insert<VEComponent::Name>(entities.begin(), entities.end(), VEComponent::Name{ prefab.name() });
+
+		for (const auto& insertComponent : prefab.m_components)
+		{
+			insertComponent(m_registry, entities);
+		}
+
+		std::vector<Entity> instances;
+		instances.reserve(entities.size());
+		for (entt::entity entity : entities)
+		{
+			instances.emplace_back(entity, this);
+		}
+
+		// Scripts have to be registered at the script manager, so they are added one by one
+		for (const auto& addScript : prefab.m_scripts)
+		{
+			for (const Entity& instance : instances)
+			{
+				addScript(instance);
+			}
+		}
+
+		return instances;
+	}
+
+	bool Scene::saveSnapshot(const std::filesystem::path& filepath)
+	{
+		return SceneSnapshot::save(*this, filepath);
+	}
+
+	bool Scene::loadSnapshot(const std::filesystem::path& filepath)
+	{
+		return SceneSnapshot::load(*this, filepath);
 	}
 
 	Entity Scene::createEntity(const std::string& name, const Vector3& location)
@@ -1,12 +1,20 @@
 #pragma once
 
+#include "graphics/asset_loader.h"
 #include "graphics/device.h"
 #include "graphics/model.h"
+#include "graphics/texture.h"
 #include "scripting/script_manager.h"
 
 #include <entt/entt.hpp>
 
 #include <filesystem>
+#include <memory>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 namespace VEScripting
 {
@@ -16,6 +24,20 @@ namespace VEScripting
 namespace VEScene
 {
 	class Entity;
+	class EntityCommandBuffer;
+	class Prefab;
+
+	/// @brief Tag of the entities whose component T changed since the last Scene::clearChanges
+	template<typename T>
+	struct Changed {};
+
+	/// @brief Components which declare static constexpr bool trackChanges = true
+	template<typename T>
+	concept ChangeTracked = requires { requires T::trackChanges; };
+
+	/// @brief Views hand out change tracked components as const, writes go through Entity::getComponent which marks them
+	template<typename T>
+	using ViewAccess = std::conditional_t<ChangeTracked<T>, const T, T>;
 
 	/// @brief Base class for representation of a scene with objects
 	/// @note For example subclass view DefaultScene
@@ -25,6 +47,7 @@ namespace VEScene
 	public:
 		// Todo: remove device parameter
 		Scene(VEGraphics::VulkanDevice& device);
+		virtual ~Scene();
 
 		/// @brief Abstract method for creating the scene in a subclass
 		virtual void initialize() = 0;
@@ -32,25 +55,135 @@ namespace VEScene
 		/// @brief Creates a view of entities with components of type T
 		/// @tparam ...T The components of the entities
 		/// @return A view containing all entities with the given component types
+		/// @note Change tracked components are const, see ViewAccess
 		template<typename... T>
 		auto viewEntitiesByType()
 		{
-			return m_registry.view<T...>();
+			return m_registry.view<ViewAccess<T>...>();
+		}
+
+		/// @brief Creates a view of entities with components of type T which have none of the excluded components
+		/// @note For example viewEntitiesByType<Transform, Mesh>(entt::exclude<Suspended>)
+		template<typename... T, typename... Exclude>
+		auto viewEntitiesByType(entt::exclude_t<Exclude...> exclude)
+		{
+			return m_registry.view<ViewAccess<T>...>(exclude);
+		}
+
+		/// @brief Creates a view of the entities whose component T changed since the last clearChanges
+		/// @tparam ...Others Further components of the entities, which are not checked for changes
+		/// @note Only the changed entities are visited, so systems can skip static entities
+		template<typename T, typename... Others>
+		auto viewChangedEntities()
+		{
+			static_assert(ChangeTracked<T>, "Changes of the component are not tracked");
+			return m_registry.view<Changed<T>, const T, ViewAccess<Others>...>();
+		}
+
+		/// @brief Marks the component T of the entity as changed
+		/// @note Done by Entity::getComponent and when the component is added, call it when writing through the registry.
+		/// Views can not write tracked components, they are const there
+		template<typename T>
+		void markChanged(entt::entity entity)
+		{
+			if constexpr (ChangeTracked<T>)
+			{
+				auto& changed = m_registry.storage<Changed<T>>();
+				if (!changed.contains(entity))
+					changed.emplace(entity);
+			}
+		}
+
+		/// @brief Forgets all changes, called once per frame after all systems processed them
+		void clearChanges();
+
+		/// @brief Returns the component of type T of the entity or nullptr if it does not have one
+		/// @note Used while iterating a view which does not contain T, change tracked components are const like in views
+		template<typename T>
+		ViewAccess<T>* tryGetComponent(entt::entity entity)
+		{
+			return m_registry.try_get<T>(entity);
 		}
 
-		// Todo: save camera somehow and allow multiple cameras
-		/// @brief Returns the camera
+		/// @brief Returns the main camera, the window camera with the lowest order
 		Entity camera();
 
-		/// @brief Adds tracking for a script component to call its virtual functions
-		void addScript(VEScripting::ScriptBase* script) { m_scriptManager.addScript(script); }
+		/// @brief Returns all cameras sorted by their render order
+		std::vector<Entity> cameras();
+
+		/// @brief Adds tracking for a script component and stops it when the component is destroyed
+		/// @note T is the concrete type of the script, its bucket in the script manager updates it without virtual dispatch
+		template<typename T>
+		void trackScript(T& script)
+		{
+			// The destroy listener is connected once per script type
+			if (m_scriptTypes.insert(entt::type_id<T>().hash()).second)
+				m_registry.on_destroy<T>().template connect<&Scene::onScriptDestroy<T>>(*this);
+
+			m_scriptManager.addScript(&script);
+		}
+
+		/// @brief Limits the time per frame spent on the scripts of type T with a budgeted tick policy
+		/// @param milliseconds Zero updates them every frame
+		template<typename T>
+		void setScriptTickBudget(float milliseconds)
+		{
+			m_scriptManager.setTickBudget<T>(milliseconds);
+		}
+
+		/// @brief Calls the update function on the script components which are due and applies the recorded commands afterwards
+		/// @note Rebuilds the world transforms of the changed entities at the end
+		void update(float deltaSeconds);
+
+		/// @brief Destroys the entity and all its components
+		/// @note Use the command buffer while entities are iterated
+		void destroyEntity(Entity entity);
 
-		/// @brief Calls the update function on all script components
-		void update(float deltaSeconds) { m_scriptManager.update(deltaSeconds); }
+		/// @brief Adds or removes the Suspended tag, suspended entities are not updated or rendered
+		void setSuspended(Entity entity, bool suspended);
+
+		/// @brief Returns the buffer for structural changes during the update, it is applied after the scripts were updated
+		EntityCommandBuffer& commands() { return *m_commandBuffer; }
 
 		/// @brief Calls the end function on all script components
 		void runtimeEnd() { m_scriptManager.runtimeEnd(); }
 
+		/// @brief Uploads asynchronously loaded assets, called once per frame
+		void processAssetUploads() { m_assetLoader.processUploads(); }
+
+		/// @brief Returns the loader of the asynchronously loaded assets
+		VEGraphics::AssetLoader& assetLoader() { return m_assetLoader; }
+
+		/// @brief Returns an entity with the name or an invalid entity if there is none
+		/// @note If several entities share the name any of them is returned
+		Entity findEntity(std::string_view name);
+
+		/// @brief Returns all entities with the name
+		std::vector<Entity> findEntities(std::string_view name);
+
+		/// @brief Changes the name of the entity and updates the name index
+		/// @note The only way to change a name besides replacing the component in the registry,
+		/// Entity::getComponent does not hand out a writable Name
+		void rename(Entity entity, std::string_view name);
+
+		/// @brief Creates count entities with the components of the prefab
+		/// @note Each component type is inserted in bulk, only scripts are constructed per entity
+		/// @return The new entities in creation order
+		std::vector<Entity> instantiate(const Prefab& prefab, size_t count);
+
+		/// @brief Creates an entity with the components of the prefab at each location
+		/// @return The new entities in the order of the locations
+		std::vector<Entity> instantiate(const Prefab& prefab, const std::vector<Vector3>& locations);
+
+		/// @brief Writes the entities with registered components to a binary snapshot
+		/// @return False if the scene has components which the snapshot can not store, nothing is written then
+		/// @see SceneSnapshot
+		bool saveSnapshot(const std::filesystem::path& filepath);
+
+		/// @brief Creates the entities of a snapshot instead of initializing the scene
+		/// @return False if the snapshot does not exist
+		bool loadSnapshot(const std::filesystem::path& filepath);
+
 	protected:
 		/// @brief Loads a model frome the given path
 		/// @param modelPath Path to the model 
@@ -58,17 +191,83 @@ namespace VEScene
 		/// @note The shared pointer can be used multiple times
 		std::shared_ptr<VEGraphics::Model> loadModel(const std::filesystem::path& modelPath);
 
+		/// @brief Starts loading a model on a worker thread
+		/// @param modelPath Path to the model
+		/// @return A shared pointer to the model which is not rendered until it is uploaded
+		/// @note Loading the same path multiple times returns the same model
+		std::shared_ptr<VEGraphics::Model> loadModelAsync(const std::filesystem::path& modelPath);
+
+		/// @brief Starts loading a texture on a worker thread
+		/// @param texturePath Path to the texture
+		/// @return A shared pointer to the texture, use AssetLoader::resolve to substitute it until it is uploaded
+		std::shared_ptr<VEGraphics::Texture> loadTextureAsync(const std::filesystem::path& texturePath);
+
 		/// @brief Creates an entity with a NameComponent and TransformComponent
 		/// @note The entity can be passed by value since its just an id
 		Entity createEntity(const std::string& name = std::string(), const Vector3& location = { 0.0f, 0.0f, 0.0f });
 
 	private:
+		/// @brief Returns the window camera with the lowest order or entt::null
+		entt::entity findMainCamera();
+
+		/// @brief Marks new components of type T as changed and registers the tag storage for clearChanges
+		template<typename T>
+		void trackChanges()
+		{
+			m_registry.on_construct<T>().template connect<&Scene::onTrackedConstruct<T>>(*this);
+			m_changedStorages.push_back(&m_registry.storage<Changed<T>>());
+		}
+
+		template<typename T>
+		void onTrackedConstruct(entt::registry&, entt::entity entity)
+		{
+			markChanged<T>(entity);
+		}
+
+		/// @brief Rebuilds the world transforms of the entities whose transform changed
+		void updateWorldTransforms();
+
+		/// @brief Stops tracking the script before its component is destroyed
+		template<typename T>
+		void onScriptDestroy(entt::registry& registry, entt::entity entity)
+		{
+			m_scriptManager.removeScript(&registry.get<T>(entity));
+		}
+
+		/// @brief Retires the assets of destroyed components, frames in flight may still draw with them
+		void onMeshDestroy(entt::registry& registry, entt::entity entity);
+		void onMaterialDestroy(entt::registry& registry, entt::entity entity);
+
+		/// @brief Keeps the name index up to date, connected to the signals of the Name storage
+		/// @note Writes which do not emit a signal are prevented by Entity::getComponent, see Scene::rename
+		void onNameConstruct(entt::registry& registry, entt::entity entity);
+		void onNameUpdate(entt::registry& registry, entt::entity entity);
+		void onNameDestroy(entt::registry& registry, entt::entity entity);
+
+		/// @brief Inserts the name and the components of the prefab, the entities already have their transform
+		std::vector<Entity> insertPrefabComponents(const Prefab& prefab, const std::vector<entt::entity>& entities);
+
 		VEGraphics::VulkanDevice& m_device;
-		entt::registry m_registry;
 
+		// Declared before the registry, which notifies the script manager and the name index when components are destroyed
 		VEScripting::ScriptManager m_scriptManager;
+		std::unordered_set<entt::id_type> m_scriptTypes; // Script types with a connected destroy listener
+		std::unordered_map<uint32_t, std::vector<entt::entity>> m_entitiesByName; // Entities by the id of their interned name
+		struct NameSlot
+		{
+			uint32_t id; // Name the entity is indexed by
+			uint32_t slot; // Position in the bucket of the name
+		};
+		std::vector<NameSlot> m_nameSlots; // By entity index
+		entt::registry m_registry;
+		std::vector<entt::sparse_set*> m_changedStorages; // Changed<T> tags of all tracked components
+
+		std::unique_ptr<EntityCommandBuffer> m_commandBuffer;
+		VEGraphics::AssetLoader m_assetLoader;
 
 		friend class Entity;
+		friend class EntityCommandBuffer;
+		friend class SceneSnapshot;
 	};
 
 } // namespace VEScene
@@ -0,0 +1,482 @@
+#include "scene_snapshot.h"
+
+#include "utils/mapped_file.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace VEScene
+{
+	namespace
+	{
+		constexpr uint32_t NO_ASSET = UINT32_MAX;
+
+		/// @brief Returns true for caches which the scene rebuilds from the stored components
+		bool isDerivedType(entt::id_type id)
+		{
+			static const std::unordered_set<entt::id_type> derivedTypes = {
+				entt::type_hash<entt::entity>::value(),
+				entt::type_hash<VEComponent::WorldTransform>::value(),
+				entt::type_hash<Changed<VEComponent::Transform>>::value(),
+			};
+			return derivedTypes.count(id) > 0;
+		}
+
+		/// @brief Appends values to a byte buffer
+		class Writer
+		{
+		public:
+			Writer(std::vector<std::byte>& buffer) : m_buffer{ buffer } {}
+
+			void write(const void* data, size_t size)
+			{
+				const auto* bytes = static_cast<const std::byte*>(data);
+				m_buffer.insert(m_buffer.end(), bytes, bytes + size);
+			}
+
+			template<typename T>
+			void write(const T& value)
+			{
+				static_assert(std::is_trivially_copyable_v<T>);
+				write(&value, sizeof(T));
+			}
+
+			void writeString(const std::string& string)
+			{
+				write(static_cast<uint32_t>(string.size()));
+				write(string.data(), string.size());
+			}
+
+			/// @brief Pads the buffer to the snapshot alignment
+			void align()
+			{
+				m_buffer.resize((m_buffer.size() + SceneSnapshot::ALIGNMENT - 1) / SceneSnapshot::ALIGNMENT * SceneSnapshot::ALIGNMENT);
+			}
+
+		private:
+			std::vector<std::byte>& m_buffer;
+		};
+
+		/// @brief Reads values from a byte range and throws if it is too short
+		class Reader
+		{
+		public:
+			Reader(const std::byte* data, size_t size) : m_data{ data }, m_size{ size } {}
+
+			const std::byte* read(size_t size)
+			{
+				if (size > m_size - m_offset)
+					throw std::runtime_error("scene snapshot is truncated");
+
+				const std::byte* data = m_data + m_offset;
+				m_offset += size;
+				return data;
+			}
+
+			template<typename T>
+			T read()
+			{
+				static_assert(std::is_trivially_copyable_v<T>);
+				T value;
+				std::memcpy(&value, read(sizeof(T)), sizeof(T));
+				return value;
+			}
+
+			std::string readString()
+			{
+				uint32_t length = read<uint32_t>();
+				return { reinterpret_cast<const char*>(read(length)), length };
+			}
+
+			void align()
+			{
+				m_offset = std::min(m_size, (m_offset + SceneSnapshot::ALIGNMENT - 1) / SceneSnapshot::ALIGNMENT * SceneSnapshot::ALIGNMENT);
+			}
+
+		private:
+			const std::byte* m_data;
+			size_t m_size;
+			size_t m_offset = 0;
+		};
+
+		/// @brief Assigns indices to the paths of assets, so every asset is stored and loaded once
+		template<typename Asset>
+		class AssetTable
+		{
+		public:
+			using PathFunction = std::function<std::string(const Asset*)>;
+
+			AssetTable(PathFunction path) : m_path{ std::move(path) } {}
+
+			uint32_t index(const std::shared_ptr<Asset>& asset)
+			{
+				if (!asset)
+					return NO_ASSET;
+
+				auto [it, inserted] = m_indices.try_emplace(asset.get(), NO_ASSET);
+				if (inserted)
+				{
+					// Assets which were not loaded from a file can not be restored
+					std::string path = m_path(asset.get());
+					if (!path.empty())
+					{
+						it->second = static_cast<uint32_t>(m_paths.size());
+						m_paths.push_back(std::move(path));
+					}
+				}
+				return it->second;
+			}
+
+			void write(Writer& writer) const
+			{
+				writer.write(static_cast<uint32_t>(m_paths.size()));
+				for (const auto& path : m_paths)
+				{
+					writer.writeString(path);
+				}
+				writer.align();
+			}
+
+		private:
+			PathFunction m_path;
+			std::unordered_map<const Asset*, uint32_t> m_indices;
+			std::vector<std::string> m_paths;
+		};
+
+		/// @brief Reads the asset table and starts loading every asset
+		template<typename Asset, typename LoadFunction>
+		std::vector<std::shared_ptr<Asset>> readAssets(Reader& reader, LoadFunction load)
+		{
+			std::vector<std::shared_ptr<Asset>> assets(reader.read<uint32_t>());
+			for (auto& asset : assets)
+			{
+				asset = load(reader.readString());
+			}
+			reader.align();
+			return assets;
+		}
+
+		template<typename Asset>
+		std::shared_ptr<Asset> resolveAsset(const std::vector<std::shared_ptr<Asset>>& assets, uint32_t index)
+		{
+			if (index == NO_ASSET)
+				return nullptr;
+			if (index >= assets.size())
+				throw std::runtime_error("scene snapshot references an unknown asset");
+			return assets[index];
+		}
+	}
+
+	std::vector<SceneSnapshot::ComponentType>& SceneSnapshot::types()
+	{
+		static std::vector<ComponentType> types = {
+			rawType<VEComponent::Transform>("Transform"),
+			rawType<VEComponent::PointLight>("PointLight"),
+			{
+				"Name",
+				entt::type_hash<VEComponent::Name>::value(),
+				false,
+				[](Scene& scene) { return entitiesWith<VEComponent::Name>(scene); },
+				[](Scene& scene, const std::vector<entt::entity>& entities, std::vector<std::byte>& payload)
+				{
+					// Lengths first, then the characters of all names back to back
+					Writer writer{ payload };
+					for (entt::entity entity : entities)
+					{
+						writer.write(static_cast<uint32_t>(scene.m_registry.get<VEComponent::Name>(entity).name().size()));
+					}
+					for (entt::entity entity : entities)
+					{
+						const auto& name = scene.m_registry.get<VEComponent::Name>(entity).name();
+						writer.write(name.data(), name.size());
+					}
+				},
+				[](Scene& scene, const std::vector<entt::entity>& entities, const std::byte* payload, size_t size)
+				{
+					Reader lengths{ payload, size };
+					Reader characters{ payload, size };
+					characters.read(entities.size() * sizeof(uint32_t));
+
+					std::vector<VEComponent::Name> names;
+					names.reserve(entities.size());
+					for (size_t i = 0; i < entities.size(); i++)
+					{
+						uint32_t length = lengths.read<uint32_t>();
+						names.emplace_back(std::string_view{ reinterpret_cast<const char*>(characters.read(length)), length });
+					}
+					scene.m_registry.insert<VEComponent::Name>(entities.begin(), entities.end(), names.begin());
+				}
+			},
+			{
+				"Mesh",
+				entt::type_hash<VEComponent::Mesh>::value(),
+				false,
+				[](Scene& scene) { return entitiesWith<VEComponent::Mesh>(scene); },
+				[](Scene& scene, const std::vector<entt::entity>& entities, std::vector<std::byte>& payload)
+				{
+					AssetTable<VEGraphics::Model> models{ [&](const VEGraphics::Model* model) { return scene.m_assetLoader.modelPath(model); } };
+					std::vector<uint32_t> modelIndices;
+					modelIndices.reserve(entities.size());
+					for (entt::entity entity : entities)
+					{
+						modelIndices.push_back(models.index(scene.m_registry.get<VEComponent::Mesh>(entity).model));
+					}
+
+					Writer writer{ payload };
+					models.write(writer);
+					for (size_t i = 0; i < entities.size(); i++)
+					{
+						writer.write(modelIndices[i]);
+						writer.write(scene.m_registry.get<VEComponent::Mesh>(entities[i]).color);
+					}
+				},
+				[](Scene& scene, const std::vector<entt::entity>& entities, const std::byte* payload, size_t size)
+				{
+					Reader reader{ payload, size };
+					auto models = readAssets<VEGraphics::Model>(reader, [&](const std::string& path) { return scene.loadModelAsync(path); });
+
+					std::vector<VEComponent::Mesh> meshes;
+					meshes.reserve(entities.size());
+					for (size_t i = 0; i < entities.size(); i++)
+					{
+						auto model = resolveAsset(models, reader.read<uint32_t>());
+						meshes.emplace_back(std::move(model), reader.read<Color>());
+					}
+					scene.m_registry.insert<VEComponent::Mesh>(entities.begin(), entities.end(), meshes.begin());
+				}
+			},
+			{
+				"Material",
+				entt::type_hash<VEComponent::Material>::value(),
+				false,
+				[](Scene& scene) { return entitiesWith<VEComponent::Material>(scene); },
+				[](Scene& scene, const std::vector<entt::entity>& entities, std::vector<std::byte>& payload)
+				{
+					AssetTable<VEGraphics::Texture> textures{ [&](const VEGraphics::Texture* texture) { return scene.m_assetLoader.texturePath(texture); } };
+					std::vector<uint32_t> textureIndices;
+					textureIndices.reserve(entities.size());
+					for (entt::entity entity : entities)
+					{
+						textureIndices.push_back(textures.index(scene.m_registry.get<VEComponent::Material>(entity).albedoTexture));
+					}
+
+					Writer writer{ payload };
+					textures.write(writer);
+					for (size_t i = 0; i < entities.size(); i++)
+					{
+						const auto& material = scene.m_registry.get<VEComponent::Material>(entities[i]);
+						writer.write(textureIndices[i]);
+						writer.write(material.baseColor);
+						writer.write(material.shininess);
+					}
+				},
+				[](Scene& scene, const std::vector<entt::entity>& entities, const std::byte* payload, size_t size)
+				{
+					Reader reader{ payload, size };
+					auto textures = readAssets<VEGraphics::Texture>(reader, [&](const std::string& path) { return scene.loadTextureAsync(path); });
+
+					std::vector<VEComponent::Material> materials;
+					materials.reserve(entities.size());
+					for (size_t i = 0; i < entities.size(); i++)
+					{
+						auto texture = resolveAsset(textures, reader.read<uint32_t>());
+						Color baseColor = reader.read<Color>();
+						materials.emplace_back(baseColor, std::move(texture), reader.read<float>());
+					}
+					scene.m_registry.insert<VEComponent::Material>(entities.begin(), entities.end(), materials.begin());
+				}
+			},
+		};
+		return types;
+	}
+
+	void SceneSnapshot::registerType(ComponentType type)
+	{
+		auto& registered = types();
+		auto it = std::find_if(registered.begin(), registered.end(), [&](const ComponentType& other) { return other.name == type.name; });
+		assert(it == registered.end() && "Component type is already registered");
+
+		registered.push_back(std::move(type));
+	}
+
+	bool SceneSnapshot::save(Scene& scene, const std::filesystem::path& filepath)
+	{
+		// A lossy snapshot would replace the initialization of the scene on every later run.
+		// Cameras are not written (see entitiesWith), the scene creates its own, so their components are not lost
+		const auto& registered = types();
+		const auto& cameras = scene.m_registry.storage<VEComponent::Camera>();
+		std::vector<std::string_view> lostTypes;
+		for (auto [id, storage] : scene.m_registry.storage())
+		{
+			if (isDerivedType(id) || std::any_of(registered.begin(), registered.end(), [&](const ComponentType& type) { return type.typeId == id; }))
+				continue;
+
+			// Storages of scripts keep tombstones of removed components, which are not contained
+			if (std::any_of(storage.begin(), storage.end(), [&](entt::entity entity) { return storage.contains(entity) && !cameras.contains(entity); }))
+				lostTypes.push_back(storage.type().name());
+		}
+
+		if (!lostTypes.empty())
+		{
+			std::cout << "Scene snapshot not saved, components of these types are not registered and would be lost:";
+			for (std::string_view name : lostTypes)
+			{
+				std::cout << " " << name;
+			}
+			std::cout << std::endl;
+			return false;
+		}
+
+		auto beginTime = std::chrono::steady_clock::now();
+
+		size_t size = write(scene, filepath, nullptr);
+
+		std::cout << "Scene snapshot saved: " << size / 1024 << " KiB in "
+			<< std::chrono::duration<float, std::chrono::milliseconds::period>(std::chrono::steady_clock::now() - beginTime).count()
+			<< " ms" << std::endl;
+		return true;
+	}
+
+	size_t SceneSnapshot::save(Scene& scene, const std::filesystem::path& filepath, const std::vector<entt::entity>& entities)
+	{
+		std::unordered_set<entt::entity> subset{ entities.begin(), entities.end() };
+		return write(scene, filepath, &subset);
+	}
+
+	bool SceneSnapshot::load(Scene& scene, const std::filesystem::path& filepath)
+	{
+		if (!std::filesystem::exists(filepath))
+			return false;
+
+		auto beginTime = std::chrono::steady_clock::now();
+
+		VEUtils::MappedFile file{ filepath };
+		auto entities = load(scene, file.data(), file.size());
+
+		std::cout << "Scene snapshot loaded: " << entities.size() << " entities in "
+			<< std::chrono::duration<float, std::chrono::milliseconds::period>(std::chrono::steady_clock::now() - beginTime).count()
+			<< " ms" << std::endl;
+		return true;
+	}
+
+	std::vector<entt::entity> SceneSnapshot::load(Scene& scene, const std::byte* data, size_t size)
+	{
+		Reader reader{ data, size };
+
+		auto header = reader.read<Header>();
+		if (header.magic != MAGIC)
+			throw std::runtime_error("not a scene snapshot");
+		if (header.version != VERSION)
+			throw std::runtime_error("unsupported scene snapshot version: " + std::to_string(header.version));
+		reader.align();
+
+		std::vector<entt::entity> entities(header.entityCount);
+		scene.m_registry.create(entities.begin(), entities.end());
+
+		std::vector<entt::entity> blockEntities;
+		for (uint32_t i = 0; i < header.blockCount; i++)
+		{
+			auto blockHeader = reader.read<BlockHeader>();
+			std::string name{ reinterpret_cast<const char*>(reader.read(blockHeader.nameLength)), blockHeader.nameLength };
+			reader.align();
+			const auto* indices = reinterpret_cast<const uint32_t*>(reader.read(blockHeader.count * sizeof(uint32_t)));
+			reader.align();
+			const std::byte* payload = reader.read(blockHeader.payloadSize);
+			reader.align();
+
+			auto& registered = types();
+			auto type = std::find_if(registered.begin(), registered.end(), [&](const ComponentType& other) { return other.name == name; });
+			if (type == registered.end())
+			{
+				std::cout << "Skipped unknown component in scene snapshot: " << name << std::endl;
+				continue;
+			}
+
+			blockEntities.resize(blockHeader.count);
+			for (uint32_t j = 0; j < blockHeader.count; j++)
+			{
+				if (indices[j] >= entities.size())
+					throw std::runtime_error("scene snapshot references an unknown entity");
+				blockEntities[j] = entities[indices[j]];
+			}
+			type->load(scene, blockEntities, payload, blockHeader.payloadSize);
+		}
+
+		return entities;
+	}
+
+	bool SceneSnapshot::canStore(Scene& scene, entt::entity entity)
+	{
+		const auto& registered = types();
+		for (auto [id, storage] : scene.m_registry.storage())
+		{
+			if (!storage.contains(entity) || isDerivedType(id))
+				continue;
+
+			auto type = std::find_if(registered.begin(), registered.end(), [&](const ComponentType& other) { return other.typeId == id; });
+			if (type == registered.end() || type->script)
+				return false;
+		}
+		return true;
+	}
+
+	size_t SceneSnapshot::write(Scene& scene, const std::filesystem::path& filepath, const std::unordered_set<entt::entity>* subset)
+	{
+		struct Block
+		{
+			const ComponentType* type;
+			std::vector<uint32_t> indices;
+			std::vector<std::byte> payload;
+		};
+
+		// Entities are stored by dense indices in the order they are first seen
+		std::unordered_map<entt::entity, uint32_t> entityIndices;
+		std::vector<Block> blocks;
+		for (const auto& type : types())
+		{
+			auto entities = type.entities(scene);
+			if (subset)
+				std::erase_if(entities, [&](entt::entity entity) { return subset->count(entity) == 0; });
+			if (entities.empty())
+				continue;
+
+			Block& block = blocks.emplace_back(Block{ &type });
+			block.indices.reserve(entities.size());
+			for (entt::entity entity : entities)
+			{
+				auto [it, inserted] = entityIndices.try_emplace(entity, static_cast<uint32_t>(entityIndices.size()));
+				block.indices.push_back(it->second);
+			}
+			type.save(scene, entities, block.payload);
+		}
+
+		std::vector<std::byte> buffer;
+		Writer writer{ buffer };
+		writer.write(Header{ MAGIC, VERSION, static_cast<uint32_t>(entityIndices.size()), static_cast<uint32_t>(blocks.size()) });
+		writer.align();
+		for (const auto& block : blocks)
+		{
+			writer.write(BlockHeader{ static_cast<uint32_t>(block.type->name.size()), static_cast<uint32_t>(block.indices.size()), block.payload.size() });
+			writer.write(block.type->name.data(), block.type->name.size());
+			writer.align();
+			writer.write(block.indices.data(), block.indices.size() * sizeof(uint32_t));
+			writer.align();
+			writer.write(block.payload.data(), block.payload.size());
+			writer.align();
+		}
+
+		std::ofstream file{ filepath, std::ios::binary | std::ios::trunc };
+		if (!file.is_open())
+			throw std::runtime_error("failed to write scene snapshot: " + filepath.string());
+		file.write(reinterpret_cast<const char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+
+		return buffer.size();
+	}
+
+} // namespace VEScene
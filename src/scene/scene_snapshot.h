@@ -0,0 +1,172 @@
+#pragma once
+
+#include "scene/components.h"
+#include "scene/entity.h"
+#include "scene/scene.h"
+#include "scripting/script_base.h"
+
+#include <entt/entt.hpp>
+
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <unordered_set>
+#include <vector>
+
+namespace VEScene
+{
+	/// @brief Binary file format of the entities of a scene
+	/// @note Components are stored per type as contiguous blocks, which are emplaced in bulk from the memory-mapped file.
+	/// Only components of registered types are stored, other components and the camera entity of the scene are skipped.
+	///
+	/// Layout: Header, then per component type a BlockHeader, its name, the entity indices and the payload.
+	/// Every section starts at a multiple of ALIGNMENT, so raw components can be read in place.
+	class SceneSnapshot
+	{
+	public:
+		static constexpr uint32_t MAGIC = 0x4E534556; // "VESN"
+		static constexpr uint32_t VERSION = 1;
+		static constexpr size_t ALIGNMENT = 16;
+
+		/// @brief Writes the entities of the scene to the file
+		/// @return False without writing if components of unregistered types would be lost
+		static bool save(Scene& scene, const std::filesystem::path& filepath);
+
+		/// @brief Writes only the given entities to the file
+		/// @return Size of the file in bytes
+		static size_t save(Scene& scene, const std::filesystem::path& filepath, const std::vector<entt::entity>& entities);
+
+		/// @brief Creates the entities of the snapshot in the scene
+		/// @return False if the file does not exist, throws if it is not a valid snapshot
+		static bool load(Scene& scene, const std::filesystem::path& filepath);
+
+		/// @brief Creates the entities of a snapshot which is already in memory
+		/// @return The created entities, throws if the data is not a valid snapshot
+		static std::vector<entt::entity> load(Scene& scene, const std::byte* data, size_t size);
+
+		/// @brief Returns true if a snapshot restores the entity completely
+		/// @note False for entities with scripts or with components of unregistered types
+		static bool canStore(Scene& scene, entt::entity entity);
+
+		/// @brief Registers a trivially copyable component, which is stored as raw memory
+		/// @return True, so the registration can initialize a static variable
+		template<typename T>
+		static bool registerComponent(const std::string& name)
+		{
+			registerType(rawType<T>(name));
+			return true;
+		}
+
+		/// @brief Registers a script, which is default constructed when loading
+		/// @note Only the presence of the script is stored, not its member variables
+		/// @return True, so the registration can initialize a static variable
+		template<typename T>
+		static bool registerScript(const std::string& name)
+		{
+			registerType(scriptType<T>(name));
+			return true;
+		}
+
+	private:
+		struct Header
+		{
+			uint32_t magic;
+			uint32_t version;
+			uint32_t entityCount;
+			uint32_t blockCount;
+		};
+
+		struct BlockHeader
+		{
+			uint32_t nameLength;
+			uint32_t count; // Number of components and entity indices
+			uint64_t payloadSize;
+		};
+
+		struct ComponentType
+		{
+			std::string name;
+			entt::id_type typeId; // Id of the storage in the registry
+			bool script;
+
+			/// @brief Returns the entities with the component in storage order
+			std::function<std::vector<entt::entity>(Scene&)> entities;
+			/// @brief Writes the components of the entities to the payload
+			std::function<void(Scene&, const std::vector<entt::entity>&, std::vector<std::byte>&)> save;
+			/// @brief Emplaces the components of the entities from the payload
+			std::function<void(Scene&, const std::vector<entt::entity>&, const std::byte*, size_t)> load;
+		};
+
+		/// @brief Returns the registered types, the built-in components are registered on first use
+		static std::vector<ComponentType>& types();
+
+		static void registerType(ComponentType type);
+
+		/// @brief Writes the entities of the subset or all entities if it is null
+		static size_t write(Scene& scene, const std::filesystem::path& filepath, const std::unordered_set<entt::entity>* subset);
+
+		template<typename T>
+		static ComponentType rawType(const std::string& name)
+		{
+			static_assert(std::is_trivially_copyable_v<T>, "Component has to be trivially copyable");
+			static_assert(alignof(T) <= ALIGNMENT, "Component alignment exceeds the block alignment");
+
+			return {
+				name,
+				entt::type_hash<T>::value(),
+				false,
+				[](Scene& scene) { return entitiesWith<T>(scene); },
+				[](Scene& scene, const std::vector<entt::entity>& entities, std::vector<std::byte>& payload)
+				{
+					payload.resize(entities.size() * sizeof(T));
+					for (size_t i = 0; i < entities.size(); i++)
+					{
+						std::memcpy(payload.data() + i * sizeof(T), &scene.m_registry.get<T>(entities[i]), sizeof(T));
+					}
+				},
+				[](Scene& scene, const std::vector<entt::entity>& entities, const std::byte* payload, size_t size)
+				{
+					if (size != entities.size() * sizeof(T))
+						throw std::runtime_error("snapshot block has an unexpected size");
+
+					// The payload is aligned in the mapped file, so the components are copied straight into the storage
+					const T* components = reinterpret_cast<const T*>(payload);
+					scene.m_registry.insert<T>(entities.begin(), entities.end(), components);
+				} };
+		}
+
+		template<typename T>
+		static ComponentType scriptType(const std::string& name)
+		{
+			static_assert(std::is_base_of_v<VEScripting::ScriptBase, T>, "Script has to derive from ScriptBase");
+			static_assert(std::is_default_constructible_v<T>, "Script has to be default constructible");
+
+			return {
+				name,
+				entt::type_hash<T>::value(),
+				true,
+				[](Scene& scene) { return entitiesWith<T>(scene); },
+				[](Scene&, const std::vector<entt::entity>&, std::vector<std::byte>&) {},
+				[](Scene& scene, const std::vector<entt::entity>& entities, const std::byte*, size_t)
+				{
+					// Scripts are tracked by the script manager, so each one is added through its entity
+					for (entt::entity entity : entities)
+					{
+						Entity{ entity, &scene }.addComponent<T>();
+					}
+				} };
+		}
+
+		template<typename T>
+		static std::vector<entt::entity> entitiesWith(Scene& scene)
+		{
+			auto view = scene.m_registry.view<T>(entt::exclude<VEComponent::Camera>);
+			return { view.begin(), view.end() };
+		}
+	};
+
+} // namespace VEScene
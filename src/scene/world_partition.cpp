@@ -0,0 +1,296 @@
+#include "world_partition.h"
+
+#include "scene/components.h"
+#include "scene/entity.h"
+#include "scene/scene_snapshot.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <string>
+
+namespace VEScene
+{
+	namespace
+	{
+		constexpr size_t PAGE_SIZE = 4096;
+		constexpr const char* CHUNK_EXTENSION = ".cell";
+	}
+
+	WorldPartition::WorldPartition(Scene& scene, const std::filesystem::path& directory, const WorldPartitionSettings& settings)
+		: m_scene{ scene }, m_directory{ directory }, m_settings{ settings }
+	{
+		assert(m_settings.unloadMargin >= 0.0f && "Negative hysteresis makes cells load and unload every frame");
+		std::filesystem::create_directories(m_directory);
+	}
+
+	WorldPartition::~WorldPartition()
+	{
+	}
+
+	void WorldPartition::build()
+	{
+		auto beginTime = std::chrono::steady_clock::now();
+
+		// A rebuild starts from the complete scene, so the cells of a previous build are loaded before their chunks are removed
+		for (auto& [key, cell] : m_cells)
+		{
+			if (cell.state == CellState::Unloaded)
+				requestLoad(cell);
+			if (cell.state == CellState::Loading)
+				instantiate(cell);
+		}
+		m_cells.clear();
+		m_residentBytes = 0;
+
+		// Chunks of a previous build could belong to cells which are empty now
+		for (const auto& entry : std::filesystem::directory_iterator(m_directory))
+		{
+			if (entry.path().extension() == CHUNK_EXTENSION)
+				std::filesystem::remove(entry.path());
+		}
+
+		std::unordered_map<uint64_t, std::vector<entt::entity>> cellEntities;
+		std::unordered_map<uint64_t, std::vector<entt::entity>> residentEntities;
+		for (auto&& [entity, transform] : m_scene.viewEntitiesByType<VEComponent::Transform>(entt::exclude<VEComponent::Camera>).each())
+		{
+			auto& entities = SceneSnapshot::canStore(m_scene, entity) ? cellEntities : residentEntities;
+			entities[cellKey(transform.location)].push_back(entity);
+		}
+
+		size_t entityCount = 0;
+		for (const auto& [key, entities] : cellEntities)
+		{
+			Cell& cell = findOrCreateCell(key);
+			cell.path = m_directory / ("cell_" + std::to_string(cell.x) + "_" + std::to_string(cell.z) + CHUNK_EXTENSION);
+			cell.size = SceneSnapshot::save(m_scene, cell.path, entities);
+
+			for (entt::entity entity : entities)
+			{
+				m_scene.destroyEntity({ entity, &m_scene });
+			}
+			entityCount += entities.size();
+		}
+
+		// Resident entities start suspended like the cells they are in. Cells with only resident entities have no
+		// chunk, they are still loaded and unloaded by distance to suspend and resume their entities.
+		for (auto& [key, entities] : residentEntities)
+		{
+			Cell& cell = findOrCreateCell(key);
+
+			for (entt::entity entity : entities)
+			{
+				m_scene.setSuspended({ entity, &m_scene }, true);
+			}
+			cell.suspended = std::move(entities);
+		}
+
+		std::cout << "World partition built: " << entityCount << " entities in " << m_cells.size() << " cells in "
+			<< std::chrono::duration<float, std::chrono::milliseconds::period>(std::chrono::steady_clock::now() - beginTime).count()
+			<< " ms" << std::endl;
+	}
+
+	void WorldPartition::update(const Vector3& cameraLocation)
+	{
+		// Instantiate chunks which the worker has mapped
+		uint32_t loads = 0;
+		for (auto& [key, cell] : m_cells)
+		{
+			if (loads >= m_settings.maxLoadsPerFrame)
+				break;
+
+			if (cell.state == CellState::Loading && cell.pendingChunk.wait_for(std::chrono::seconds{ 0 }) == std::future_status::ready)
+			{
+				instantiate(cell);
+				loads++;
+			}
+		}
+
+		// Between the load and the unload radius cells keep their state, so they do not toggle at the border
+		float unloadRadius = m_settings.loadRadius + m_settings.unloadMargin;
+		std::vector<std::pair<float, Cell*>> candidates;
+		for (auto& [key, cell] : m_cells)
+		{
+			float cellDistance = distance(cell, cameraLocation);
+			if (cell.state == CellState::Loaded && cellDistance > unloadRadius)
+				unload(key, cell);
+			else if (cell.state == CellState::Unloaded && cellDistance <= m_settings.loadRadius)
+				candidates.emplace_back(cellDistance, &cell);
+		}
+
+		// Nearest cells first, farther loaded cells are evicted if the budget is exceeded
+		std::sort(candidates.begin(), candidates.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+		for (auto& [candidateDistance, candidate] : candidates)
+		{
+			while (m_residentBytes + candidate->size > m_settings.memoryBudget)
+			{
+				uint64_t farthestKey = 0;
+				Cell* farthest = nullptr;
+				float farthestDistance = candidateDistance;
+				for (auto& [key, cell] : m_cells)
+				{
+					float cellDistance = distance(cell, cameraLocation);
+					if (cell.state == CellState::Loaded && cellDistance > farthestDistance)
+					{
+						farthestKey = key;
+						farthest = &cell;
+						farthestDistance = cellDistance;
+					}
+				}
+
+				if (!farthest)
+					break;
+				unload(farthestKey, *farthest);
+			}
+
+			if (m_residentBytes + candidate->size > m_settings.memoryBudget)
+				break;
+
+			requestLoad(*candidate);
+		}
+	}
+
+	void WorldPartition::suspendDeparted()
+	{
+		// Only entities which moved this frame can have left their cell
+		std::vector<std::pair<entt::entity, uint64_t>> departed;
+		for (auto&& [entity, transform] : m_scene.viewChangedEntities<VEComponent::Transform>().each())
+		{
+			Entity moved{ entity, &m_scene };
+			if (moved.hasComponent<VEComponent::Camera>() || moved.hasComponent<VEComponent::Suspended>())
+				continue;
+
+			uint64_t key = cellKey(transform.location);
+			auto it = m_cells.find(key);
+			if (it == m_cells.end() || it->second.state == CellState::Unloaded)
+				departed.emplace_back(entity, key);
+		}
+
+		// Suspended like the resident entities of the cell and resumed when it loads
+		for (auto [entity, key] : departed)
+		{
+			m_scene.setSuspended({ entity, &m_scene }, true);
+			findOrCreateCell(key).suspended.push_back(entity);
+		}
+	}
+
+	uint32_t WorldPartition::loadedCellCount() const
+	{
+		return static_cast<uint32_t>(std::count_if(m_cells.begin(), m_cells.end(), [](const auto& entry) { return entry.second.state == CellState::Loaded; }));
+	}
+
+	WorldPartition::Cell& WorldPartition::findOrCreateCell(uint64_t key)
+	{
+		auto [it, inserted] = m_cells.try_emplace(key);
+		if (inserted)
+		{
+			it->second.x = static_cast<int32_t>(key >> 32);
+			it->second.z = static_cast<int32_t>(key & 0xFFFFFFFF);
+		}
+		return it->second;
+	}
+
+	uint64_t WorldPartition::cellKey(int32_t x, int32_t z)
+	{
+		return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(z);
+	}
+
+	int32_t WorldPartition::cellCoordinate(float value) const
+	{
+		return static_cast<int32_t>(std::floor(value / m_settings.cellSize));
+	}
+
+	uint64_t WorldPartition::cellKey(const Vector3& location) const
+	{
+		return cellKey(cellCoordinate(location.x), cellCoordinate(location.z));
+	}
+
+	float WorldPartition::distance(const Cell& cell, const Vector3& location) const
+	{
+		float minX = cell.x * m_settings.cellSize;
+		float minZ = cell.z * m_settings.cellSize;
+		float dx = std::max({ minX - location.x, 0.0f, location.x - (minX + m_settings.cellSize) });
+		float dz = std::max({ minZ - location.z, 0.0f, location.z - (minZ + m_settings.cellSize) });
+		return std::sqrt(dx * dx + dz * dz);
+	}
+
+	void WorldPartition::requestLoad(Cell& cell)
+	{
+		cell.state = CellState::Loading;
+		m_residentBytes += cell.size;
+
+		// Nothing to map, the resident entities are resumed at once
+		if (cell.path.empty())
+		{
+			instantiate(cell);
+			return;
+		}
+
+		cell.pendingChunk = m_threadPool.submit([path = cell.path]()
+			{
+				auto chunk = std::make_shared<VEUtils::MappedFile>(path);
+
+				// Touch every page, so instantiating on the main thread does not wait for the disk
+				volatile unsigned char sink = 0;
+				for (size_t offset = 0; offset < chunk->size(); offset += PAGE_SIZE)
+				{
+					sink = static_cast<unsigned char>(chunk->data()[offset]);
+				}
+				return chunk;
+			});
+	}
+
+	void WorldPartition::instantiate(Cell& cell)
+	{
+		if (!cell.path.empty())
+		{
+			try
+			{
+				auto chunk = cell.pendingChunk.get();
+				cell.entities = SceneSnapshot::load(m_scene, chunk->data(), chunk->size());
+			}
+			catch (const std::exception& e)
+			{
+				// The cell counts as loaded, so it is not requested again every frame
+				std::cout << "Failed to load world cell " << cell.path.string() << ": " << e.what() << std::endl;
+			}
+		}
+		cell.state = CellState::Loaded;
+
+		for (entt::entity handle : cell.suspended)
+		{
+			Entity entity{ handle, &m_scene };
+			if (entity.isValid())
+				m_scene.setSuspended(entity, false);
+		}
+		cell.suspended.clear();
+	}
+
+	void WorldPartition::unload(uint64_t key, Cell& cell)
+	{
+		for (entt::entity handle : cell.entities)
+		{
+			Entity entity{ handle, &m_scene };
+			if (entity.isValid())
+				m_scene.destroyEntity(entity);
+		}
+		cell.entities.clear();
+
+		// Entities which can not be streamed keep their state and are resumed with the cell
+		for (auto&& [entity, transform] : m_scene.viewEntitiesByType<VEComponent::Transform>(entt::exclude<VEComponent::Camera, VEComponent::Suspended>).each())
+		{
+			if (cellKey(transform.location) == key)
+				cell.suspended.push_back(entity);
+		}
+		for (entt::entity handle : cell.suspended)
+		{
+			m_scene.setSuspended({ handle, &m_scene }, true);
+		}
+
+		cell.state = CellState::Unloaded;
+		m_residentBytes -= cell.size;
+	}
+
+} // namespace VEScene
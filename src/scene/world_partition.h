@@ -0,0 +1,105 @@
+#pragma once
+
+#include "scene/scene.h"
+#include "utils/mapped_file.h"
+#include "utils/math_utils.h"
+#include "utils/thread_pool.h"
+
+#include <entt/entt.hpp>
+
+#include <filesystem>
+#include <future>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace VEScene
+{
+	struct WorldPartitionSettings
+	{
+		float cellSize = 32.0f; // Edge length of the square cells on the XZ plane
+		float loadRadius = 64.0f; // Cells closer to the camera are loaded
+		float unloadMargin = 16.0f; // Loaded cells are kept until they are farther than loadRadius + unloadMargin
+		size_t memoryBudget = 256ull << 20; // Upper bound of the resident cell data, approximated by the chunk sizes
+		uint32_t maxLoadsPerFrame = 2; // Cells instantiated per frame, limits the time spent in update
+	};
+
+	/// @brief Streams the static entities of a scene in square cells around the camera
+	/// @note build moves every entity which a snapshot can restore into the chunk file of its cell. Chunks are mapped and
+	/// prefetched on a worker thread and instantiated on the main thread. Changes to streamed entities are lost when
+	/// their cell unloads. Other entities, like those with scripts, stay resident and are suspended while their cell is unloaded.
+	class WorldPartition
+	{
+	public:
+		/// @param directory Directory of the cell chunks, created if it does not exist
+		WorldPartition(Scene& scene, const std::filesystem::path& directory, const WorldPartitionSettings& settings = {});
+		~WorldPartition();
+
+		WorldPartition(const WorldPartition&) = delete;
+		WorldPartition& operator=(const WorldPartition&) = delete;
+
+		/// @brief Writes the storable entities of the scene into cell chunks and destroys them, all cells start unloaded
+		/// @note Building again loads the cells of the previous build first, so the new chunks contain all entities
+		void build();
+
+		/// @brief Loads and unloads cells by their distance to the camera, called once per frame on the main thread
+		void update(const Vector3& cameraLocation);
+
+		/// @brief Suspends the entities which moved into an unloaded cell, called once per frame after the scene update
+		/// @note Uses the changed transforms of the frame, so it has to run before the changes are cleared
+		void suspendDeparted();
+
+		uint32_t cellCount() const { return static_cast<uint32_t>(m_cells.size()); }
+		uint32_t loadedCellCount() const;
+
+		/// @brief Returns the chunk size of the loading and loaded cells
+		size_t residentBytes() const { return m_residentBytes; }
+
+	private:
+		enum class CellState
+		{
+			Unloaded,
+			Loading, // The chunk is mapped on the worker thread
+			Loaded,
+		};
+
+		struct Cell
+		{
+			int32_t x = 0;
+			int32_t z = 0;
+			std::filesystem::path path; // Empty if the cell only has resident entities
+			size_t size = 0;
+
+			CellState state = CellState::Unloaded;
+			std::future<std::shared_ptr<VEUtils::MappedFile>> pendingChunk;
+
+			std::vector<entt::entity> entities; // Created from the chunk while the cell is loaded
+			std::vector<entt::entity> suspended; // Resident entities which were suspended when the cell was unloaded
+		};
+
+		/// @brief Returns the cell of the key, a cell without a chunk is created if there is none
+		Cell& findOrCreateCell(uint64_t key);
+
+		static uint64_t cellKey(int32_t x, int32_t z);
+		int32_t cellCoordinate(float value) const;
+		uint64_t cellKey(const Vector3& location) const;
+
+		/// @brief Returns the distance on the XZ plane from the location to the nearest point of the cell
+		float distance(const Cell& cell, const Vector3& location) const;
+
+		void requestLoad(Cell& cell);
+		void instantiate(Cell& cell);
+		void unload(uint64_t key, Cell& cell);
+
+		Scene& m_scene;
+		std::filesystem::path m_directory;
+		WorldPartitionSettings m_settings;
+
+		std::unordered_map<uint64_t, Cell> m_cells;
+		size_t m_residentBytes = 0;
+
+		// Declared last so the worker is stopped before the cells are destroyed
+		VEUtils::ThreadPool m_threadPool{ 1 };
+	};
+
+} // namespace VEScene
@@ -12,6 +12,9 @@ namespace VEScripting
 	class WorldBorder : public ScriptBase
 	{
 	public:
+		/// @brief Clamps the location after the motion of the frame was integrated
+		static constexpr ScriptPhase phase = ScriptPhase::PostPhysics;
+
 		/// @brief Constructs a WorldBorder.
 		/// @param limits Positive values for the limits.
 		WorldBorder(const Vector3& limits = Vector3{ FLT_MAX })
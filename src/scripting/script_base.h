@@ -1,13 +1,51 @@
 #pragma once
 
 #include "scene/entity.h"
+#include "scene/entity_command_buffer.h"
 #include "scene/components.h"
+#include "scripting/script_phase.h"
 
 namespace VEScripting
 {
+	class ScriptManager;
+
 	class ScriptBase
 	{
 	public:
+		/// @brief How often the script manager calls update, the delta passed to update is the time since the last update
+		struct TickPolicy
+		{
+			enum class Mode
+			{
+				EveryFrame,
+				Interval, // Every interval frames
+				Distance, // Every frame up to nearDistance to the main camera, every maxInterval frames from farDistance
+				Budgeted, // Round robin within the tick budget of the script type, see Scene::setScriptTickBudget
+			};
+
+			Mode mode = Mode::EveryFrame;
+			uint32_t interval = 1;
+			float nearDistance = 20.0f;
+			float farDistance = 100.0f;
+			uint32_t maxInterval = 8;
+
+			static TickPolicy everyFrame() { return {}; }
+			static TickPolicy everyNFrames(uint32_t frames) { return { Mode::Interval, frames }; }
+			static TickPolicy byDistance(float nearDistance, float farDistance, uint32_t maxInterval) { return { Mode::Distance, 1, nearDistance, farDistance, maxInterval }; }
+			static TickPolicy budgeted() { return { Mode::Budgeted }; }
+		};
+
+		/// @brief Removing a script leaves a hole in its storage instead of moving the last script into it,
+		/// so the pointers of the script manager stay valid
+		static constexpr auto in_place_delete = true;
+
+		/// @brief Phase in which the scripts of this type are updated, a derived script declares its own to change it
+		static constexpr ScriptPhase phase = ScriptPhase::PrePhysics;
+
+		/// @brief Script types of the same or an earlier phase which are updated before this type
+		/// @note A derived script declares its own list, e.g. using UpdateAfter = ScriptTypes<MotionDynamics>;
+		using UpdateAfter = ScriptTypes<>;
+
 		/// @brief Constructor
 		/// @note When overriding, dont't use member functions (m_entity is not initialized yet)
 		ScriptBase() = default;
@@ -15,7 +53,8 @@ namespace VEScripting
 
 		/// @brief Called once at the first frame just before update
 		virtual void begin() {}
-		/// @brief Called every frame with the delta of the last two frames in seconds
+		/// @brief Called every frame, or as set by the tick policy, with the seconds since the last update
+		/// @note The script manager calls the update of the concrete type without virtual dispatch, so overrides have to be public
 		virtual void update(float deltaSeconds) {}
 		/// @brief Called once at the end of the last frame
 		virtual void end() {}
@@ -28,13 +67,20 @@ namespace VEScripting
 		}
 
 		/// @brief Returns a reference of the component of type T
-		/// @note Component of type T must exist
+		/// @note Component of type T must exist, change tracked components are marked as changed
 		template<typename T>
 		T& getComponent() const
 		{
 			return m_entity.getComponent<T>();
 		}
 
+		/// @brief Returns a read-only reference of the component of type T, which does not mark it as changed
+		template<typename T>
+		const T& readComponent() const
+		{
+			return m_entity.readComponent<T>();
+		}
+
 		/// @brief Adds a component of type T to the entity and returns a reference to it
 		template<typename T, typename... Args>
 		T& addComponent(Args&&... args)
@@ -45,10 +91,28 @@ namespace VEScripting
 		/// @brief Returns the entity
 		VEScene::Entity entity() const { return m_entity; }
 
+		/// @brief Returns true while the entity is in an unloaded cell of the world partition, update is not called then
+		bool isSuspended() const { return m_entity.hasComponent<VEComponent::Suspended>(); }
+
+		/// @brief Sets how often update is called, can also be called in the constructor
+		/// @note Scripts of the same entity with the same policy are updated in the same frames
+		void setTickPolicy(const TickPolicy& policy) { m_tickPolicy = policy; }
+		const TickPolicy& tickPolicy() const { return m_tickPolicy; }
+
+		/// @brief Returns the command buffer of the scene to create and destroy entities or add and remove components
+		/// @note Changes are applied after all scripts were updated
+		VEScene::EntityCommandBuffer& commands() const { return m_entity.scene().commands(); }
+
 	private:
 		VEScene::Entity m_entity;
 
+		TickPolicy m_tickPolicy;
+		double m_lastUpdateSeconds = 0.0; // Time of the script manager at the last update
+		size_t m_scriptSlot = SIZE_MAX; // Index in the bucket of the script manager, or in its new scripts while pending
+		bool m_pendingBegin = false;
+
 		friend class VEScene::Entity;
+		friend class ScriptManager;
 	};
 
 } // namespace VEScripting
@@ -2,41 +2,280 @@
 
 #include "scripting/script_base.h"
 
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
 namespace VEScripting
 {
-	void ScriptManager::addScript(ScriptBase* script)
+	namespace
+	{
+		const char* phaseName(ScriptPhase phase)
+		{
+			switch (phase)
+			{
+			case ScriptPhase::PrePhysics: return "pre-physics";
+			case ScriptPhase::Physics: return "physics";
+			case ScriptPhase::PostPhysics: return "post-physics";
+			case ScriptPhase::Late: return "late";
+			}
+			return "unknown";
+		}
+	}
+
+	void ScriptManager::addScript(ScriptBase* script, Bucket& bucket)
+	{
+		script->m_scriptSlot = m_newScripts.size();
+		script->m_pendingBegin = true;
+		m_newScripts.push_back({ script, &bucket });
+	}
+
+	void ScriptManager::removeScript(ScriptBase* script, Bucket& bucket)
 	{
-		m_newScripts.emplace_back(script);
+		size_t slot = script->m_scriptSlot;
+		if (slot == SIZE_MAX)
+			return;
+
+		script->m_scriptSlot = SIZE_MAX;
+		if (script->m_pendingBegin)
+		{
+			// Has not begun yet, so it is not ended either
+			assert(m_newScripts[slot].script == script && "Slot of the new script is out of sync");
+			m_newScripts[slot].script = nullptr;
+			script->m_pendingBegin = false;
+			return;
+		}
+
+		assert(bucket.scripts[slot] == script && "Slot of the script is out of sync");
+		script->end();
+
+		// The bucket can be iterated right now, the slot is removed after the update
+		bucket.scripts[slot] = nullptr;
+		bucket.hasRemovedScripts = true;
 	}
 
-	void ScriptManager::update(float deltaSeconds)
+	void ScriptManager::update(float deltaSeconds, const std::optional<Vector3>& cameraLocation)
 	{
+		// New scripts start their interval at the previous frame, so their first update gets the delta of this frame
 		handleNewScripts();
 
-		for (auto& script : m_scripts)
+		m_frame++;
+		m_elapsedSeconds += deltaSeconds;
+		m_cameraLocation = cameraLocation;
+
+		if (m_orderChanged)
+			sortBuckets();
+
+		for (Bucket* bucket : m_updateOrder)
 		{
-			script->update(deltaSeconds);
+			if (bucket->tick == nullptr || bucket->scripts.empty())
+				continue;
+
+			auto beginTime = std::chrono::steady_clock::now();
+			bucket->tick(*this, *bucket);
+			bucket->totalMilliseconds += std::chrono::duration<double, std::chrono::milliseconds::period>(std::chrono::steady_clock::now() - beginTime).count();
+			bucket->updates++;
 		}
+
+		compact();
 	}
 
 	void ScriptManager::runtimeEnd()
 	{
 		handleNewScripts(); // just in case
 
-		for (auto& script : m_scripts)
+		if (m_orderChanged)
+			sortBuckets();
+
+		for (Bucket* bucket : m_updateOrder)
 		{
-			script->end();
+			for (ScriptBase* script : bucket->scripts)
+			{
+				if (script != nullptr)
+				{
+					script->m_scriptSlot = SIZE_MAX;
+					script->end();
+				}
+			}
+
+			// Components destroyed afterwards must not be ended again
+			bucket->scripts.clear();
+			bucket->hasRemovedScripts = false;
+		}
+
+		std::cout << "Script update time per type:" << std::endl;
+		for (const TypeTiming& timing : timings())
+		{
+			if (timing.updates == 0)
+				continue;
+
+			std::cout << "  " << timing.name << " (" << phaseName(timing.phase) << "): "
+				<< timing.totalMilliseconds / timing.updates << " ms per frame over " << timing.updates << " frames" << std::endl;
 		}
 	}
 
+	std::vector<ScriptManager::TypeTiming> ScriptManager::timings()
+	{
+		if (m_orderChanged)
+			sortBuckets();
+
+		std::vector<TypeTiming> result;
+		result.reserve(m_updateOrder.size());
+		for (const Bucket* bucket : m_updateOrder)
+		{
+			size_t scriptCount = bucket->scripts.size() - std::count(bucket->scripts.begin(), bucket->scripts.end(), nullptr);
+			result.push_back({ bucket->name, bucket->phase, scriptCount, bucket->updates, bucket->totalMilliseconds });
+		}
+		return result;
+	}
+
 	void ScriptManager::handleNewScripts()
 	{
-		for (auto& script : m_newScripts)
+		// Scripts added by begin are handled in the next round, all of a round are tracked before the first begins,
+		// so scripts removed by begin are found
+		std::vector<std::pair<Bucket*, size_t>> slots;
+		while (!m_newScripts.empty())
 		{
-			script->begin();
-			m_scripts.emplace_back(script);
+			slots.clear();
+			for (const NewScript& newScript : m_newScripts)
+			{
+				if (newScript.script == nullptr)
+					continue;
+
+				ScriptBase* script = newScript.script;
+				script->m_lastUpdateSeconds = m_elapsedSeconds;
+				script->m_scriptSlot = newScript.bucket->scripts.size();
+				script->m_pendingBegin = false;
+				slots.emplace_back(newScript.bucket, script->m_scriptSlot);
+				newScript.bucket->scripts.push_back(script);
+			}
+			m_newScripts.clear();
+
+			for (auto& [bucket, index] : slots)
+			{
+				if (bucket->scripts[index] != nullptr)
+					bucket->scripts[index]->begin();
+			}
+		}
+	}
+
+	bool ScriptManager::isDue(ScriptBase& script, bool budgeted) const
+	{
+		using Mode = ScriptBase::TickPolicy::Mode;
+		const auto& policy = script.m_tickPolicy;
+
+		uint32_t interval = 1;
+		switch (policy.mode)
+		{
+		case Mode::EveryFrame:
+			return true;
+		case Mode::Interval:
+			interval = policy.interval;
+			break;
+		case Mode::Distance:
+		{
+			if (!m_cameraLocation || !script.hasComponent<VEComponent::Transform>())
+				return true;
+
+			float distance = glm::length(script.readComponent<VEComponent::Transform>().location - *m_cameraLocation);
+			float range = std::max(policy.farDistance - policy.nearDistance, FLT_EPSILON);
+			float t = std::clamp((distance - policy.nearDistance) / range, 0.0f, 1.0f);
+			interval = 1 + static_cast<uint32_t>(std::round(t * (std::max(policy.maxInterval, 1u) - 1)));
+			break;
+		}
+		case Mode::Budgeted:
+			return !budgeted;
+		}
+
+		// Offset by the entity, so the scripts of a type spread over the frames while the scripts of one entity stay in step
+		uint64_t offset = static_cast<uint64_t>(entt::to_integral(script.entity().handle()));
+		return (m_frame + offset) % std::max(interval, 1u) == 0;
+	}
+
+	float ScriptManager::consumeDelta(ScriptBase& script) const
+	{
+		float deltaSeconds = static_cast<float>(m_elapsedSeconds - script.m_lastUpdateSeconds);
+		script.m_lastUpdateSeconds = m_elapsedSeconds;
+		return deltaSeconds;
+	}
+
+	void ScriptManager::tickBudgeted(Bucket& bucket, UpdateFunction update)
+	{
+		size_t count = bucket.scripts.size();
+		if (count == 0)
+			return;
+
+		// Continues after the last updated script, so every budgeted script gets its turn
+		auto beginTime = std::chrono::steady_clock::now();
+		size_t visited = 0;
+		for (; visited < count; visited++)
+		{
+			ScriptBase* script = bucket.scripts[(bucket.budgetCursor + visited) % count];
+			if (script == nullptr || script->m_tickPolicy.mode != ScriptBase::TickPolicy::Mode::Budgeted)
+				continue;
+
+			if (std::chrono::duration<float, std::chrono::milliseconds::period>(std::chrono::steady_clock::now() - beginTime).count() >= bucket.budgetMilliseconds)
+				break;
+
+			update(*this, *script);
+		}
+		bucket.budgetCursor = (bucket.budgetCursor + visited) % count;
+	}
+
+	void ScriptManager::sortBuckets()
+	{
+		std::vector<Bucket*> remaining;
+		remaining.reserve(m_buckets.size());
+		for (const auto& bucket : m_buckets)
+		{
+			remaining.push_back(bucket.get());
+		}
+		std::stable_sort(remaining.begin(), remaining.end(), [](const Bucket* a, const Bucket* b) { return a->phase < b->phase; });
+
+		// Dependencies on types of earlier phases or on types without scripts yet are always met
+		auto isReady = [&](const Bucket* bucket)
+			{
+				return std::all_of(bucket->updateAfter.begin(), bucket->updateAfter.end(), [&](entt::id_type type)
+					{
+						auto dependency = m_bucketIndex.find(type);
+						return dependency == m_bucketIndex.end() || dependency->second->phase != bucket->phase
+							|| std::find(remaining.begin(), remaining.end(), dependency->second) == remaining.end();
+					});
+			};
+
+		m_updateOrder.clear();
+		while (!remaining.empty())
+		{
+			ScriptPhase phase = remaining.front()->phase;
+			auto ready = std::find_if(remaining.begin(), remaining.end(), [&](const Bucket* bucket) { return bucket->phase == phase && isReady(bucket); });
+			if (ready == remaining.end())
+				throw std::runtime_error(std::string("Cyclic UpdateAfter dependencies between script types of the ") + phaseName(phase) + " phase");
+
+			m_updateOrder.push_back(*ready);
+			remaining.erase(ready);
+		}
+		m_orderChanged = false;
+	}
+
+	void ScriptManager::compact()
+	{
+		for (const auto& bucket : m_buckets)
+		{
+			if (!bucket->hasRemovedScripts)
+				continue;
+
+			std::erase(bucket->scripts, nullptr);
+			for (size_t slot = 0; slot < bucket->scripts.size(); slot++)
+			{
+				bucket->scripts[slot]->m_scriptSlot = slot;
+			}
+			bucket->hasRemovedScripts = false;
 		}
-		m_newScripts.clear();
 	}
 
-} // namespace VEScripting
\ No newline at end of file
+} // namespace VEScripting
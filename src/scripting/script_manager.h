@@ -1,30 +1,195 @@
 #pragma once
 
+#include "scripting/script_phase.h"
+#include "utils/math_utils.h"
+
+#include <entt/entt.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
 #include <vector>
 
 namespace VEScripting
 {
 	class ScriptBase;
 
+	/// @brief Updates the scripts bucketed by their concrete type
+	/// @note Buckets are updated phase by phase and within a phase after the types they declare in UpdateAfter.
+	/// Each bucket calls the update of its type in a tight loop without virtual dispatch, so scripts of different
+	/// types do not interleave. Types which do not override update get no loop at all.
+	/// Scripts whose tick policy skips frames receive the accumulated time since their last update.
 	class ScriptManager
 	{
 	public:
-		/// @brief Adds a script to call its virtual functions
+		/// @brief Update time of the scripts of one type
+		struct TypeTiming
+		{
+			std::string_view name;
+			ScriptPhase phase;
+			size_t scriptCount;
+			uint64_t updates; // Frames in which the bucket was updated
+			double totalMilliseconds;
+		};
+
+		/// @brief Adds a script to call its functions, T has to be the concrete type of the script
 		/// @param script The script to add
-		void addScript(ScriptBase* script);
+		template<typename T>
+		void addScript(T* script)
+		{
+			addScript(script, bucket<T>());
+		}
+
+		/// @brief Stops tracking a script before its component is destroyed, calls its end function if it has begun
+		/// @note Can be called while the scripts are updated
+		template<typename T>
+		void removeScript(T* script)
+		{
+			removeScript(script, bucket<T>());
+		}
 
-		/// @brief Calls the update function of each script
-		void update(float deltaSeconds);
+		/// @brief Limits the time spent per frame on the scripts of type T with a budgeted tick policy
+		/// @param milliseconds Zero updates them every frame
+		template<typename T>
+		void setTickBudget(float milliseconds)
+		{
+			bucket<T>().budgetMilliseconds = milliseconds;
+		}
 
-		/// @brief Calls the end function of each script
+		/// @brief Calls the update function of each script which is due this frame
+		/// @param cameraLocation Location of the main camera for the distance tick policy, scripts with it are updated
+		/// every frame without a camera
+		void update(float deltaSeconds, const std::optional<Vector3>& cameraLocation = std::nullopt);
+
+		/// @brief Calls the end function of each script and prints the update time per type
 		void runtimeEnd();
 
+		/// @brief Returns the accumulated update time of each script type in update order
+		std::vector<TypeTiming> timings();
+
 	private:
+		struct Bucket;
+		using TickFunction = void(*)(ScriptManager& manager, Bucket& bucket);
+		using UpdateFunction = void(*)(ScriptManager& manager, ScriptBase& script);
+
+		struct Bucket
+		{
+			entt::id_type type;
+			std::string_view name;
+			ScriptPhase phase;
+			std::vector<entt::id_type> updateAfter;
+			TickFunction tick; // nullptr if the type does not override update
+
+			// Pointers into the script storage, which does not move its components (see ScriptBase::in_place_delete)
+			std::vector<ScriptBase*> scripts; // Removed scripts are set to nullptr until the next compaction, which renumbers the slots
+			bool hasRemovedScripts = false;
+
+			float budgetMilliseconds = 0.0f;
+			size_t budgetCursor = 0; // Next script of the round robin over the budgeted scripts
+
+			uint64_t updates = 0;
+			double totalMilliseconds = 0.0;
+		};
+
+		struct NewScript
+		{
+			ScriptBase* script; // nullptr if removed before it began
+			Bucket* bucket;
+		};
+
+		template<typename T>
+		static void updateScript(ScriptManager& manager, ScriptBase& script)
+		{
+			// Time spent suspended is consumed as well, so resumed scripts do not jump
+			float deltaSeconds = manager.consumeDelta(script);
+
+			// The qualified call binds to the update of T at compile time
+			T& typed = static_cast<T&>(script);
+			if (!typed.isSuspended())
+				typed.T::update(deltaSeconds);
+		}
+
+		template<typename T>
+		static void tick(ScriptManager& manager, Bucket& bucket)
+		{
+			bool budgeted = bucket.budgetMilliseconds > 0.0f;
+			for (ScriptBase* script : bucket.scripts)
+			{
+				if (script != nullptr && manager.isDue(*script, budgeted))
+					updateScript<T>(manager, *script);
+			}
+
+			if (budgeted)
+				manager.tickBudgeted(bucket, &ScriptManager::updateScript<T>);
+		}
+
+		template<typename T, typename... After>
+		static std::vector<entt::id_type> dependencies(ScriptTypes<After...>)
+		{
+			static_assert(((After::phase <= T::phase) && ...), "A script type can not be updated after a type of a later phase");
+			return { entt::type_id<After>().hash()... };
+		}
+
+		/// @brief Returns the bucket of the script type T, creates it on first use
+		template<typename T>
+		Bucket& bucket()
+		{
+			auto found = m_bucketIndex.find(entt::type_id<T>().hash());
+			if (found != m_bucketIndex.end())
+				return *found->second;
+
+			static_assert(requires(T& script, float deltaSeconds) { script.T::update(deltaSeconds); },
+				"The update of a script type has to be public, the script manager calls it without virtual dispatch");
+
+			// The member function pointer has the type of the class which declares update
+			constexpr bool overridesUpdate = !std::is_same_v<decltype(&T::update), void (ScriptBase::*)(float)>;
+
+			auto& created = m_buckets.emplace_back(std::make_unique<Bucket>(Bucket{
+				entt::type_id<T>().hash(),
+				entt::type_id<T>().name(),
+				T::phase,
+				dependencies<T>(typename T::UpdateAfter{}),
+				overridesUpdate ? &ScriptManager::tick<T> : nullptr }));
+			m_bucketIndex.emplace(created->type, created.get());
+			m_orderChanged = true;
+			return *created;
+		}
+
+		void addScript(ScriptBase* script, Bucket& bucket);
+		void removeScript(ScriptBase* script, Bucket& bucket);
+
+		/// @brief Returns true if the tick policy of the script updates it this frame
+		/// @param budgeted True if budgeted scripts are left to tickBudgeted
+		bool isDue(ScriptBase& script, bool budgeted) const;
+
+		/// @brief Returns the seconds since the last update of the script and starts the next interval
+		float consumeDelta(ScriptBase& script) const;
+
+		/// @brief Updates the budgeted scripts round robin until the budget of the bucket is spent
+		void tickBudgeted(Bucket& bucket, UpdateFunction update);
+
 		/// @brief Calls the begin function of each script once
 		void handleNewScripts();
-		
-		std::vector<ScriptBase*> m_scripts;
-		std::vector<ScriptBase*> m_newScripts;
+
+		/// @brief Sorts the buckets by phase and within a phase after their dependencies
+		void sortBuckets();
+
+		/// @brief Removes the slots of scripts which were removed during the update
+		void compact();
+
+		std::vector<std::unique_ptr<Bucket>> m_buckets; // In order of creation, the tie-break of the update order
+		std::unordered_map<entt::id_type, Bucket*> m_bucketIndex;
+		std::vector<Bucket*> m_updateOrder;
+		bool m_orderChanged = false;
+
+		std::vector<NewScript> m_newScripts;
+
+		uint64_t m_frame = 0;
+		double m_elapsedSeconds = 0.0;
+		std::optional<Vector3> m_cameraLocation;
 	};
 
-} // namespace VEScripting
\ No newline at end of file
+} // namespace VEScripting
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+
+namespace VEScripting
+{
+	/// @brief Phases of the script update, all script types of a phase are updated before the next phase begins
+	enum class ScriptPhase : uint8_t
+	{
+		PrePhysics, // Input and gameplay logic which drives the motion
+		Physics, // Integrates the motion
+		PostPhysics, // Reacts to the integrated motion, like constraints on the location
+		Late, // Runs after all entities have moved, like cameras following them
+	};
+
+	/// @brief List of script types, used to declare the types a script type is updated after
+	template<typename... T>
+	struct ScriptTypes {};
+
+} // namespace VEScripting
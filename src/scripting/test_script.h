@@ -20,8 +20,8 @@ namespace VEScripting
 		/// @brief Acces protected methods and other components here.
 		virtual void begin() override
 		{
-			auto& name = getComponent<VEComponent::Name>();
-			std::cout << "TestScript::begin() " << name.name << " " << m_x << std::endl;
+			const auto& name = readComponent<VEComponent::Name>();
+			std::cout << "TestScript::begin() " << name.name() << " " << m_x << std::endl;
 		}
 
 		/// @brief Update the script each frame here.
@@ -0,0 +1,82 @@
+#include "mapped_file.h"
+
+#include <stdexcept>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace VEUtils
+{
+	MappedFile::MappedFile(const std::filesystem::path& filepath)
+	{
+#ifdef _WIN32
+		m_file = CreateFileW(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (m_file == INVALID_HANDLE_VALUE)
+			throw std::runtime_error("failed to open file: " + filepath.string());
+
+		LARGE_INTEGER size{};
+		GetFileSizeEx(m_file, &size);
+		m_size = static_cast<size_t>(size.QuadPart);
+		if (m_size == 0)
+			return; // Empty files can not be mapped
+
+		m_mapping = CreateFileMappingW(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (m_mapping != nullptr)
+			m_data = static_cast<const std::byte*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+
+		if (m_data == nullptr)
+		{
+			if (m_mapping != nullptr)
+				CloseHandle(m_mapping);
+			CloseHandle(m_file);
+			throw std::runtime_error("failed to map file: " + filepath.string());
+		}
+#else
+		int file = open(filepath.c_str(), O_RDONLY | O_CLOEXEC);
+		if (file < 0)
+			throw std::runtime_error("failed to open file: " + filepath.string());
+
+		struct stat status {};
+		fstat(file, &status);
+		m_size = static_cast<size_t>(status.st_size);
+		if (m_size == 0)
+		{
+			close(file);
+			return; // Empty files can not be mapped
+		}
+
+		// The mapping keeps the file referenced, so the descriptor is not needed anymore
+		void* data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, file, 0);
+		close(file);
+		if (data == MAP_FAILED)
+			throw std::runtime_error("failed to map file: " + filepath.string());
+
+		madvise(data, m_size, MADV_WILLNEED); // Start reading ahead, the whole file is consumed right away
+		m_data = static_cast<const std::byte*>(data);
+#endif
+	}
+
+	MappedFile::~MappedFile()
+	{
+#ifdef _WIN32
+		if (m_data != nullptr)
+		{
+			UnmapViewOfFile(m_data);
+			CloseHandle(m_mapping);
+		}
+		CloseHandle(m_file);
+#else
+		if (m_data != nullptr)
+			munmap(const_cast<std::byte*>(m_data), m_size);
+#endif
+	}
+
+} // namespace VEUtils
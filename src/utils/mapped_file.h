@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+
+namespace VEUtils
+{
+	/// @brief Read-only memory mapping of a whole file
+	/// @note The pages are read by the OS on first access instead of copying the file into a buffer
+	class MappedFile
+	{
+	public:
+		/// @note Throws if the file can not be opened or mapped
+		MappedFile(const std::filesystem::path& filepath);
+		~MappedFile();
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		/// @brief Returns the start of the mapping, which is aligned to the page size
+		const std::byte* data() const { return m_data; }
+		size_t size() const { return m_size; }
+
+	private:
+		const std::byte* m_data = nullptr;
+		size_t m_size = 0;
+
+#ifdef _WIN32
+		void* m_file = nullptr;
+		void* m_mapping = nullptr;
+#endif
+	};
+
+} // namespace VEUtils
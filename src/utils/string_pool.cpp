@@ -0,0 +1,63 @@
+#include "string_pool.h"
+
+#include <cassert>
+#include <mutex>
+
+namespace VEUtils
+{
+	StringPool& StringPool::instance()
+	{
+		static StringPool instance;
+		return instance;
+	}
+
+	StringPool::StringPool()
+	{
+		intern({});
+	}
+
+	uint32_t StringPool::intern(std::string_view string)
+	{
+		{
+			std::shared_lock lock{ m_mutex };
+			auto it = m_ids.find(string);
+			if (it != m_ids.end())
+				return it->second;
+		}
+
+		std::unique_lock lock{ m_mutex };
+
+		// Another thread could have added it between the locks
+		auto it = m_ids.find(string);
+		if (it != m_ids.end())
+			return it->second;
+
+		auto id = static_cast<uint32_t>(m_strings.size());
+		assert(id != INVALID && "String pool is full");
+
+		const std::string& stored = m_strings.emplace_back(string);
+		m_ids.emplace(stored, id);
+		return id;
+	}
+
+	uint32_t StringPool::find(std::string_view string) const
+	{
+		std::shared_lock lock{ m_mutex };
+		auto it = m_ids.find(string);
+		return it != m_ids.end() ? it->second : INVALID;
+	}
+
+	const std::string& StringPool::string(uint32_t id) const
+	{
+		std::shared_lock lock{ m_mutex };
+		assert(id < m_strings.size() && "Unknown string id");
+		return m_strings[id];
+	}
+
+	size_t StringPool::size() const
+	{
+		std::shared_lock lock{ m_mutex };
+		return m_strings.size();
+	}
+
+} // namespace VEUtils
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace VEUtils
+{
+	/// @brief Stores every distinct string once and identifies it by a 32 bit id
+	/// @note Strings are never removed, so ids and references stay valid for the lifetime of the program. Thread safe.
+	class StringPool
+	{
+	public:
+		static constexpr uint32_t EMPTY = 0; // Id of the empty string
+		static constexpr uint32_t INVALID = UINT32_MAX;
+
+		/// @brief Returns the pool shared by all scenes
+		static StringPool& instance();
+
+		/// @brief Returns the id of the string and adds it to the pool if it is not interned yet
+		uint32_t intern(std::string_view string);
+
+		/// @brief Returns the id of the string or INVALID if it was never interned
+		/// @note Used by lookups, so unknown strings do not grow the pool
+		uint32_t find(std::string_view string) const;
+
+		/// @brief Returns the interned string of the id
+		const std::string& string(uint32_t id) const;
+
+		size_t size() const;
+
+	private:
+		StringPool();
+
+		mutable std::shared_mutex m_mutex;
+		std::deque<std::string> m_strings; // Indexed by id, a deque keeps references stable while growing
+		std::unordered_map<std::string_view, uint32_t> m_ids; // Views into m_strings
+	};
+
+} // namespace VEUtils
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace VEUtils
+{
+	/// @brief Fixed number of worker threads executing submitted tasks in FIFO order
+	class ThreadPool
+	{
+	public:
+		/// @param threadCount Number of worker threads, 0 uses the hardware concurrency minus the main thread
+		ThreadPool(uint32_t threadCount = 0);
+		~ThreadPool();
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		/// @brief Queues a task for execution on a worker thread
+		/// @return Future with the result of the task, exceptions thrown by the task are rethrown by get()
+		template<typename F>
+		auto submit(F&& task) -> std::future<std::invoke_result_t<F>>
+		{
+			using Result = std::invoke_result_t<F>;
+
+			auto packagedTask = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(task));
+			std::future<Result> future = packagedTask->get_future();
+			{
+				std::lock_guard lock{ m_mutex };
+				m_tasks.emplace([packagedTask]() { (*packagedTask)(); });
+			}
+			m_condition.notify_one();
+			return future;
+		}
+
+		/// @brief Returns the number of worker threads
+		uint32_t threadCount() const { return static_cast<uint32_t>(m_workers.size()); }
+
+	private:
+		void workerLoop();
+
+		std::vector<std::thread> m_workers;
+		std::queue<std::function<void()>> m_tasks;
+
+		std::mutex m_mutex;
+		std::condition_variable m_condition;
+		bool m_stop = false;
+	};
+
+} // namespace VEUtils
@@ -0,0 +1,468 @@
+// Offline converter from images (png, jpg, ...) to mipmapped, block compressed KTX2 textures
+// Usage: TextureConverter <input image> <output.ktx2> [--bc1 | --bc3 | --rgba]
+// Without a format option BC3 is used for images with transparency and BC1 for opaque images
+
+#include "graphics/ktx2.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#include <algorithm>
+#include <array>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+	struct Image
+	{
+		uint32_t width = 0;
+		uint32_t height = 0;
+		std::vector<float> pixels; // Linear RGBA
+	};
+
+	float srgbToLinear(float value)
+	{
+		return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+	}
+
+	float linearToSrgb(float value)
+	{
+		return value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+	}
+
+	uint8_t toByte(float value)
+	{
+		return static_cast<uint8_t>(std::clamp(value * 255.0f + 0.5f, 0.0f, 255.0f));
+	}
+
+	/// @brief Halves the image with a box filter (in linear space)
+	Image downsample(const Image& source)
+	{
+		Image result;
+		result.width = std::max(1u, source.width / 2);
+		result.height = std::max(1u, source.height / 2);
+		result.pixels.resize(static_cast<size_t>(result.width) * result.height * 4);
+
+		for (uint32_t y = 0; y < result.height; y++)
+		{
+			for (uint32_t x = 0; x < result.width; x++)
+			{
+				uint32_t x0 = std::min(x * 2, source.width - 1);
+				uint32_t x1 = std::min(x * 2 + 1, source.width - 1);
+				uint32_t y0 = std::min(y * 2, source.height - 1);
+				uint32_t y1 = std::min(y * 2 + 1, source.height - 1);
+
+				for (uint32_t c = 0; c < 4; c++)
+				{
+					float sum =
+						source.pixels[(static_cast<size_t>(y0) * source.width + x0) * 4 + c] +
+						source.pixels[(static_cast<size_t>(y0) * source.width + x1) * 4 + c] +
+						source.pixels[(static_cast<size_t>(y1) * source.width + x0) * 4 + c] +
+						source.pixels[(static_cast<size_t>(y1) * source.width + x1) * 4 + c];
+					result.pixels[(static_cast<size_t>(y) * result.width + x) * 4 + c] = sum * 0.25f;
+				}
+			}
+		}
+		return result;
+	}
+
+	/// @brief Returns the 4x4 block at (blockX, blockY) as sRGB encoded bytes, edges are clamped
+	std::array<std::array<uint8_t, 4>, 16> fetchBlock(const Image& image, uint32_t blockX, uint32_t blockY)
+	{
+		std::array<std::array<uint8_t, 4>, 16> block{};
+		for (uint32_t i = 0; i < 16; i++)
+		{
+			uint32_t x = std::min(blockX * 4 + i % 4, image.width - 1);
+			uint32_t y = std::min(blockY * 4 + i / 4, image.height - 1);
+			const float* pixel = &image.pixels[(static_cast<size_t>(y) * image.width + x) * 4];
+			block[i] = { toByte(linearToSrgb(pixel[0])), toByte(linearToSrgb(pixel[1])), toByte(linearToSrgb(pixel[2])), toByte(pixel[3]) };
+		}
+		return block;
+	}
+
+	uint16_t packRgb565(const float color[3])
+	{
+		uint16_t r = static_cast<uint16_t>(std::clamp(color[0], 0.0f, 255.0f) * 31.0f / 255.0f + 0.5f);
+		uint16_t g = static_cast<uint16_t>(std::clamp(color[1], 0.0f, 255.0f) * 63.0f / 255.0f + 0.5f);
+		uint16_t b = static_cast<uint16_t>(std::clamp(color[2], 0.0f, 255.0f) * 31.0f / 255.0f + 0.5f);
+		return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+	}
+
+	std::array<float, 3> unpackRgb565(uint16_t color)
+	{
+		return {
+			static_cast<float>((color >> 11) & 31) * 255.0f / 31.0f,
+			static_cast<float>((color >> 5) & 63) * 255.0f / 63.0f,
+			static_cast<float>(color & 31) * 255.0f / 31.0f };
+	}
+
+	/// @brief Encodes the color of a block in 4-color mode with endpoints along the principal axis
+	void encodeColorBlock(const std::array<std::array<uint8_t, 4>, 16>& block, uint8_t* output)
+	{
+		float mean[3] = { 0.0f, 0.0f, 0.0f };
+		for (const auto& pixel : block)
+		{
+			for (int c = 0; c < 3; c++)
+				mean[c] += pixel[c] / 16.0f;
+		}
+
+		float covariance[6] = {}; // rr, rg, rb, gg, gb, bb
+		for (const auto& pixel : block)
+		{
+			float r = pixel[0] - mean[0], g = pixel[1] - mean[1], b = pixel[2] - mean[2];
+			covariance[0] += r * r; covariance[1] += r * g; covariance[2] += r * b;
+			covariance[3] += g * g; covariance[4] += g * b; covariance[5] += b * b;
+		}
+
+		// Power iteration for the principal axis
+		float axis[3] = { 0.577f, 0.577f, 0.577f };
+		for (int i = 0; i < 8; i++)
+		{
+			float next[3] = {
+				covariance[0] * axis[0] + covariance[1] * axis[1] + covariance[2] * axis[2],
+				covariance[1] * axis[0] + covariance[3] * axis[1] + covariance[4] * axis[2],
+				covariance[2] * axis[0] + covariance[4] * axis[1] + covariance[5] * axis[2] };
+			float length = std::sqrt(next[0] * next[0] + next[1] * next[1] + next[2] * next[2]);
+			if (length < 1e-6f)
+				break;
+
+			for (int c = 0; c < 3; c++)
+				axis[c] = next[c] / length;
+		}
+
+		float minProjection = 0.0f, maxProjection = 0.0f;
+		for (const auto& pixel : block)
+		{
+			float projection = (pixel[0] - mean[0]) * axis[0] + (pixel[1] - mean[1]) * axis[1] + (pixel[2] - mean[2]) * axis[2];
+			minProjection = std::min(minProjection, projection);
+			maxProjection = std::max(maxProjection, projection);
+		}
+
+		float maxColor[3], minColor[3];
+		for (int c = 0; c < 3; c++)
+		{
+			maxColor[c] = mean[c] + axis[c] * maxProjection;
+			minColor[c] = mean[c] + axis[c] * minProjection;
+		}
+
+		uint16_t color0 = packRgb565(maxColor);
+		uint16_t color1 = packRgb565(minColor);
+		if (color0 < color1)
+			std::swap(color0, color1); // color0 > color1 selects the 4-color mode
+
+		auto endpoint0 = unpackRgb565(color0);
+		auto endpoint1 = unpackRgb565(color1);
+		std::array<std::array<float, 3>, 4> palette{};
+		for (int c = 0; c < 3; c++)
+		{
+			palette[0][c] = endpoint0[c];
+			palette[1][c] = endpoint1[c];
+			palette[2][c] = (2.0f * endpoint0[c] + endpoint1[c]) / 3.0f;
+			palette[3][c] = (endpoint0[c] + 2.0f * endpoint1[c]) / 3.0f;
+		}
+
+		uint32_t indices = 0;
+		if (color0 != color1)
+		{
+			for (uint32_t i = 0; i < 16; i++)
+			{
+				uint32_t bestIndex = 0;
+				float bestError = FLT_MAX;
+				for (uint32_t p = 0; p < 4; p++)
+				{
+					float error = 0.0f;
+					for (int c = 0; c < 3; c++)
+					{
+						float difference = block[i][c] - palette[p][c];
+						error += difference * difference;
+					}
+					if (error < bestError)
+					{
+						bestError = error;
+						bestIndex = p;
+					}
+				}
+				indices |= bestIndex << (2 * i);
+			}
+		}
+
+		std::memcpy(output + 0, &color0, 2);
+		std::memcpy(output + 2, &color1, 2);
+		std::memcpy(output + 4, &indices, 4);
+	}
+
+	/// @brief Encodes the alpha of a block with 8 interpolated values (BC3)
+	void encodeAlphaBlock(const std::array<std::array<uint8_t, 4>, 16>& block, uint8_t* output)
+	{
+		uint8_t alpha0 = 0, alpha1 = 255;
+		for (const auto& pixel : block)
+		{
+			alpha0 = std::max(alpha0, pixel[3]);
+			alpha1 = std::min(alpha1, pixel[3]);
+		}
+
+		std::array<float, 8> palette{};
+		palette[0] = alpha0;
+		palette[1] = alpha1;
+		for (int i = 1; i < 7; i++)
+		{
+			palette[i + 1] = ((7 - i) * alpha0 + i * alpha1) / 7.0f;
+		}
+
+		uint64_t indices = 0;
+		if (alpha0 != alpha1)
+		{
+			for (uint32_t i = 0; i < 16; i++)
+			{
+				uint64_t bestIndex = 0;
+				float bestError = FLT_MAX;
+				for (uint32_t p = 0; p < 8; p++)
+				{
+					float error = std::abs(block[i][3] - palette[p]);
+					if (error < bestError)
+					{
+						bestError = error;
+						bestIndex = p;
+					}
+				}
+				indices |= bestIndex << (3 * i);
+			}
+		}
+
+		output[0] = alpha0;
+		output[1] = alpha1;
+		for (int i = 0; i < 6; i++)
+		{
+			output[2 + i] = static_cast<uint8_t>(indices >> (8 * i));
+		}
+	}
+
+	std::vector<uint8_t> encodeLevel(const Image& image, VkFormat format)
+	{
+		std::vector<uint8_t> data(VEGraphics::textureLevelSize(format, image.width, image.height));
+
+		if (format == VK_FORMAT_R8G8B8A8_SRGB)
+		{
+			for (size_t i = 0; i < static_cast<size_t>(image.width) * image.height; i++)
+			{
+				data[i * 4 + 0] = toByte(linearToSrgb(image.pixels[i * 4 + 0]));
+				data[i * 4 + 1] = toByte(linearToSrgb(image.pixels[i * 4 + 1]));
+				data[i * 4 + 2] = toByte(linearToSrgb(image.pixels[i * 4 + 2]));
+				data[i * 4 + 3] = toByte(image.pixels[i * 4 + 3]);
+			}
+			return data;
+		}
+
+		uint32_t blockSize = VEGraphics::blockCompressedBlockSize(format);
+		uint32_t blocksX = (image.width + 3) / 4;
+		uint32_t blocksY = (image.height + 3) / 4;
+		for (uint32_t y = 0; y < blocksY; y++)
+		{
+			for (uint32_t x = 0; x < blocksX; x++)
+			{
+				auto block = fetchBlock(image, x, y);
+				uint8_t* output = &data[(static_cast<size_t>(y) * blocksX + x) * blockSize];
+				if (format == VK_FORMAT_BC3_SRGB_BLOCK)
+				{
+					encodeAlphaBlock(block, output);
+					encodeColorBlock(block, output + 8);
+				}
+				else
+				{
+					encodeColorBlock(block, output);
+				}
+			}
+		}
+		return data;
+	}
+
+	/// @brief Builds the basic data format descriptor required by the KTX2 specification
+	std::vector<uint32_t> dataFormatDescriptor(VkFormat format)
+	{
+		struct Sample { uint32_t bitOffset; uint32_t bitLength; uint32_t channel; };
+
+		uint32_t colorModel = 1; // KHR_DF_MODEL_RGBSDA
+		uint32_t blockDimension = 0;
+		uint32_t bytesPlane0 = 4;
+		std::vector<Sample> samples;
+
+		switch (format)
+		{
+		case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+			colorModel = 128; // KHR_DF_MODEL_BC1A
+			blockDimension = 3 | (3 << 8);
+			bytesPlane0 = 8;
+			samples = { { 0, 64, 0 } };
+			break;
+		case VK_FORMAT_BC3_SRGB_BLOCK:
+			colorModel = 130; // KHR_DF_MODEL_BC3
+			blockDimension = 3 | (3 << 8);
+			bytesPlane0 = 16;
+			samples = { { 0, 64, 15 }, { 64, 64, 0 } }; // alpha, color
+			break;
+		default:
+			samples = { { 0, 8, 0 }, { 8, 8, 1 }, { 16, 8, 2 }, { 24, 8, 15 } };
+			break;
+		}
+
+		uint32_t blockSize = 24 + 16 * static_cast<uint32_t>(samples.size());
+		std::vector<uint32_t> words;
+		words.push_back(4 + blockSize);                      // dfdTotalSize
+		words.push_back(0);                                  // vendorId | descriptorType
+		words.push_back(2 | (blockSize << 16));              // versionNumber | descriptorBlockSize
+		words.push_back(colorModel | (1 << 8) | (2 << 16));  // colorModel | BT709 primaries | sRGB transfer | flags
+		words.push_back(blockDimension);
+		words.push_back(bytesPlane0);
+		words.push_back(0);
+
+		for (const auto& sample : samples)
+		{
+			// Alpha channels of sRGB formats are linear
+			uint32_t qualifiers = sample.channel == 15 ? 0x10 : 0;
+			uint32_t upper = colorModel == 1 ? 255 : 0xFFFFFFFF;
+			words.push_back(sample.bitOffset | ((sample.bitLength - 1) << 16) | ((sample.channel | (qualifiers << 4)) << 24));
+			words.push_back(0);
+			words.push_back(0);
+			words.push_back(upper);
+		}
+		return words;
+	}
+
+	void writeKtx2(const std::string& path, VkFormat format, const std::vector<Image>& levels)
+	{
+		std::vector<std::vector<uint8_t>> levelData;
+		for (const auto& level : levels)
+		{
+			levelData.push_back(encodeLevel(level, format));
+		}
+
+		auto dfd = dataFormatDescriptor(format);
+		const uint32_t levelCount = static_cast<uint32_t>(levels.size());
+		const uint64_t levelIndexOffset = sizeof(VEGraphics::KTX2_IDENTIFIER) + sizeof(VEGraphics::Ktx2Header) + sizeof(VEGraphics::Ktx2Index);
+		const uint64_t dfdOffset = levelIndexOffset + levelCount * sizeof(VEGraphics::Ktx2LevelIndex);
+		const uint64_t alignment = std::max<uint64_t>(4, VEGraphics::blockCompressedBlockSize(format));
+
+		// Levels are stored with the smallest level first
+		std::vector<VEGraphics::Ktx2LevelIndex> levelIndices(levelCount);
+		uint64_t offset = dfdOffset + dfd.size() * sizeof(uint32_t);
+		for (int32_t level = static_cast<int32_t>(levelCount) - 1; level >= 0; level--)
+		{
+			offset = (offset + alignment - 1) / alignment * alignment;
+			levelIndices[level] = { offset, levelData[level].size(), levelData[level].size() };
+			offset += levelData[level].size();
+		}
+
+		VEGraphics::Ktx2Header header{};
+		header.vkFormat = static_cast<uint32_t>(format);
+		header.typeSize = 1;
+		header.pixelWidth = levels[0].width;
+		header.pixelHeight = levels[0].height;
+		header.pixelDepth = 0;
+		header.layerCount = 0;
+		header.faceCount = 1;
+		header.levelCount = levelCount;
+		header.supercompressionScheme = 0;
+
+		VEGraphics::Ktx2Index index{};
+		index.dfdByteOffset = static_cast<uint32_t>(dfdOffset);
+		index.dfdByteLength = static_cast<uint32_t>(dfd.size() * sizeof(uint32_t));
+
+		std::ofstream file{ path, std::ios::binary };
+		if (!file.is_open())
+			throw std::runtime_error("failed to open output file: " + path);
+
+		auto write = [&file](const void* data, size_t size) { file.write(reinterpret_cast<const char*>(data), size); };
+		write(VEGraphics::KTX2_IDENTIFIER, sizeof(VEGraphics::KTX2_IDENTIFIER));
+		write(&header, sizeof(header));
+		write(&index, sizeof(index));
+		write(levelIndices.data(), levelIndices.size() * sizeof(VEGraphics::Ktx2LevelIndex));
+		write(dfd.data(), dfd.size() * sizeof(uint32_t));
+
+		uint64_t position = dfdOffset + dfd.size() * sizeof(uint32_t);
+		for (int32_t level = static_cast<int32_t>(levelCount) - 1; level >= 0; level--)
+		{
+			const std::vector<char> padding(levelIndices[level].byteOffset - position, 0);
+			write(padding.data(), padding.size());
+			write(levelData[level].data(), levelData[level].size());
+			position = levelIndices[level].byteOffset + levelData[level].size();
+		}
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc < 3)
+	{
+		std::cerr << "Usage: TextureConverter <input image> <output.ktx2> [--bc1 | --bc3 | --rgba]" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	try
+	{
+		int width, height, channels;
+		stbi_uc* pixels = stbi_load(argv[1], &width, &height, &channels, STBI_rgb_alpha);
+		if (!pixels)
+			throw std::runtime_error(std::string("failed to load image: ") + argv[1]);
+
+		Image image;
+		image.width = static_cast<uint32_t>(width);
+		image.height = static_cast<uint32_t>(height);
+		image.pixels.resize(static_cast<size_t>(width) * height * 4);
+
+		bool hasAlpha = false;
+		for (size_t i = 0; i < image.pixels.size(); i++)
+		{
+			bool isAlpha = i % 4 == 3;
+			hasAlpha |= isAlpha && pixels[i] < 255;
+			image.pixels[i] = isAlpha ? pixels[i] / 255.0f : srgbToLinear(pixels[i] / 255.0f);
+		}
+		stbi_image_free(pixels);
+
+		VkFormat format = hasAlpha ? VK_FORMAT_BC3_SRGB_BLOCK : VK_FORMAT_BC1_RGB_SRGB_BLOCK;
+		if (argc > 3)
+		{
+			std::string option = argv[3];
+			if (option == "--bc1")
+				format = VK_FORMAT_BC1_RGB_SRGB_BLOCK;
+			else if (option == "--bc3")
+				format = VK_FORMAT_BC3_SRGB_BLOCK;
+			else if (option == "--rgba")
+				format = VK_FORMAT_R8G8B8A8_SRGB;
+			else
+				throw std::runtime_error("unknown option: " + option);
+		}
+
+		std::vector<Image> levels;
+		levels.push_back(std::move(image));
+		while (levels.back().width > 1 || levels.back().height > 1)
+		{
+			levels.push_back(downsample(levels.back()));
+		}
+
+		writeKtx2(argv[2], format, levels);
+
+		uint64_t sourceSize = static_cast<uint64_t>(width) * height * 4;
+		uint64_t convertedSize = 0;
+		for (const auto& level : levels)
+		{
+			convertedSize += VEGraphics::textureLevelSize(format, level.width, level.height);
+		}
+		std::cout << argv[1] << " -> " << argv[2] << ": " << levels.size() << " levels, "
+			<< sourceSize / 1024 << " KiB (RGBA8, level 0) -> " << convertedSize / 1024 << " KiB" << std::endl;
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << e.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}